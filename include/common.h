@@ -79,6 +79,34 @@ struct Vertex
     }
 };
 
+//index range of one level of detail in the index buffer of a mesh, level 0 is the full mesh. the error is the
+//object space distance the surface of the level may be off the full mesh
+struct MeshLod
+{
+    uint32_t m_index_offset = 0;
+    uint32_t m_index_count = 0;
+    float m_error = 0.0f;
+};
+
+//cluster of the full mesh culled on the gpu as a whole, laid out as the std430 struct of meshlet_cull.comp
+struct Meshlet
+{
+    Vector4f m_sphere = Vector4f( 0.0f ); //object space center and radius
+    Vector4f m_cone = Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ); //normal axis and the sine of the normal spread, 1 is never backfacing
+    uint32_t m_index_offset = 0;
+    uint32_t m_index_count = 0;
+    int32_t m_vertex_offset = 0; //0 in the mesh, where its vertices start in the geometry arena once drawn
+    uint32_t m_padding = 0;
+};
+
+//what a pass draws for, every view selects its own level of detail per entity
+enum class LodView : uint32_t
+{
+    Camera,
+    Shadow,
+    Count
+};
+
 typedef enum ImageBlockType
 {
     IMAGE_BLOCK_2D          = 0,
@@ -86,31 +114,24 @@ typedef enum ImageBlockType
     IMAGE_BLOCK_3D          = 2,
 } ImageType;
 
+//range of device memory handed out by the MemoryAllocatorVK
+struct MemoryAllocation
+{
+    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    VkDeviceSize m_offset = 0;
+    VkDeviceSize m_size = 0;
+    void* m_mapped = nullptr;
+    uint32_t m_block = UINT32_MAX; //UINT32_MAX when the memory belongs to this resource alone
+};
+
 struct ImageBlock
 {
     ImageType m_type = IMAGE_BLOCK_2D;
     VkImage m_image = VK_NULL_HANDLE;
     VkImageView m_image_view = VK_NULL_HANDLE;
     VkFormat m_format;
-    VkDeviceMemory m_memory = VK_NULL_HANDLE;
+    MemoryAllocation m_memory;
     VkSampler m_sampler = VK_NULL_HANDLE;
 };
 
-struct Attachments
-{
-    // GBUFFER
-    ImageBlock m_color_attachment;
-    ImageBlock m_position_depth_attachment;
-    ImageBlock m_normal_attachment;
-    ImageBlock m_material_attachment;
-    ImageBlock m_depth_attachment;
-
-    // ADDITIONAL RENDER TARGET
-    ImageBlock m_ssao_attachment;
-    ImageBlock m_ssao_blur_attachment;
-
-    // SHADOWS
-    ImageBlock m_shadow_attachment;
-};
-
 }; // namespace MiniEngine
@@ -79,7 +79,23 @@ namespace MiniEngine
     constexpr uint32_t kMAX_NUMBER_LIGHTS = 10;
     constexpr uint32_t kMAX_NUMBER_OF_OBJECTS = 10000;
     constexpr uint32_t kMAX_NUMBER_OF_FRAMES = 3;
+    constexpr uint32_t kDEFAULT_FRAMES_IN_FLIGHT = 2;
+    constexpr uint32_t kMAX_WORKER_THREADS = 8;
+    constexpr uint32_t kENTITIES_PER_SECONDARY_BUFFER = 256;
     constexpr uint32_t kSSAO_KERNEL_SIZE = 64;
     constexpr uint32_t kSSAO_NOISE_DIM = 4;
+    constexpr uint32_t kPROFILER_MAX_GPU_SCOPES = 32;
+    constexpr uint32_t kPROFILER_AVERAGE_WINDOW = 120;
+    constexpr uint32_t kPROFILER_MAX_TRACE_EVENTS = 1 << 20;
+    constexpr uint64_t kMEMORY_BLOCK_SIZE = 64ull * 1024 * 1024;
+    constexpr uint64_t kUPLOAD_RING_SIZE = 32ull * 1024 * 1024;
+    constexpr uint32_t kUPLOAD_BATCHES = 4;
+    constexpr uint32_t kVERTEX_CACHE_SIZE = 16;
+    constexpr uint32_t kMAX_MESH_LODS = 4;
+    constexpr float kDEFAULT_LOD_ERROR_PIXELS = 1.0f;
+    constexpr uint32_t kMESHLET_MAX_VERTICES = 64;
+    constexpr uint32_t kMESHLET_MAX_TRIANGLES = 124;
+    constexpr uint32_t kGEOMETRY_BLOCK_VERTICES = 1 << 20;
+    constexpr uint32_t kGEOMETRY_BLOCK_INDICES = 1 << 22;
 
 };
\ No newline at end of file
@@ -2,10 +2,12 @@
 
 #include "common.h"
 #include "runtime.h"
+#include "frame.h"
 
 namespace MiniEngine
 {
     class RenderPassVK;
+    class RenderGraphVK;
     class WindowVK;
     class Scene;
 
@@ -17,12 +19,56 @@ namespace MiniEngine
         Engine ();
         ~Engine();
 
-        bool initialize();
+        bool initialize( const bool i_headless = false );
         void run       ();
         void shutdown  ();
 
         void loadScene     ( const std::string& i_path );
 
+        //number of frames the cpu can record ahead of the gpu, clamped to [1, kMAX_NUMBER_OF_FRAMES]
+        void setFramesInFlight( const uint32_t i_frames_in_flight );
+
+        inline uint32_t getFramesInFlight() const
+        {
+            return m_frames_in_flight;
+        }
+
+        //worker threads used to record the passes, must be set before initialize
+        void setWorkerThreads( const uint32_t i_worker_threads );
+
+        //stop run() after rendering this many frames, 0 runs until the window is closed
+        inline void setFrameLimit( const uint32_t i_frame_limit )
+        {
+            m_frame_limit = i_frame_limit;
+        }
+
+        //write a chrome trace of the gpu and cpu scopes to this path at shutdown, must be set before initialize
+        inline void setTraceFile( const std::string& i_path )
+        {
+            m_trace_file = i_path;
+        }
+
+        //largest error in pixels a coarser level of detail may show, on screen for the camera and in the
+        //shadow map for the lights
+        inline void setLodErrorThreshold( const float i_pixels )
+        {
+            m_lod_error_threshold = i_pixels;
+        }
+
+        //also drop meshlets whose triangles all face away from the camera, must be set before initialize. only safe when the scene
+        //has no open or inside viewed meshes since the passes draw both faces
+        inline void setMeshletConeCulling( const bool i_enable )
+        {
+            m_meshlet_cone_culling = i_enable;
+        }
+
+        //depth prepass and shadows fetch the positions from a buffer of their own, at the cost of storing them twice.
+        //must be set before initialize
+        inline void setPositionStreams( const bool i_enable )
+        {
+            m_position_streams = i_enable;
+        }
+
         inline const VkAccelerationStructureKHR getTLAS() const
         {
             return m_tlas_structure;
@@ -39,13 +85,16 @@ namespace MiniEngine
         void destroySyncObjects ();
         void createRenderPasses ();
         void destroyRenderPasses();
-        void createAttachments  ();
-        void destroyAttachments ();
         void createSamplers     ();
         void destroySamplers    ();
-        void updateGlobalBuffers();
+        void updateGlobalBuffers( const Frame& i_frame );
+        //selects the level of detail of every entity per view and invalidates the passes whose levels changed
+        void updateLods         ();
+        void recreateSwapChain  ();
 
-        std::vector<std::shared_ptr<RenderPassVK>> m_render_passes;
+        //owns the attachments, the pass order and the barriers between passes
+        std::unique_ptr<RenderGraphVK>             m_render_graph;
+        std::vector<std::shared_ptr<RenderPassVK>> m_render_passes; //live passes of the graph, in order
 
         struct FrameSemaphores
         {
@@ -53,9 +102,16 @@ namespace MiniEngine
             VkSemaphore m_presentation_semaphore;
         };
         
-        std::array<FrameSemaphores, 3> m_frame_semaphore;
-        std::array<VkFence        , 3> m_frame_fence;
-        uint32_t                       m_current_frame;
+        std::array<FrameSemaphores, kMAX_NUMBER_OF_FRAMES> m_frame_semaphore;
+        std::array<VkFence        , kMAX_NUMBER_OF_FRAMES> m_frame_fence;
+        uint32_t                                          m_current_frame;
+        uint32_t                                          m_frames_in_flight;
+        uint32_t                                          m_frame_limit;
+        uint32_t                                          m_worker_threads;
+        std::string                                       m_trace_file;
+        float                                             m_lod_error_threshold;
+        bool                                              m_meshlet_cone_culling;
+        bool                                              m_position_streams;
 
         bool m_resize;
         bool m_close;
@@ -64,18 +120,18 @@ namespace MiniEngine
 
 
         std::shared_ptr<Scene> m_scene;
+        std::vector<PerObjectData> m_per_object_data; //cpu copy of the per object records, the mapped buffers receive its dirty ranges
         
-        Attachments m_render_target_attachments;
         std::array<VkSampler, 1> m_global_samplers;
 
         //TLAS
         VkAccelerationStructureKHR m_tlas_structure = VK_NULL_HANDLE;
         VkBuffer m_tlas_buffer = VK_NULL_HANDLE;
-        VkDeviceMemory m_tlas_memory = VK_NULL_HANDLE;
+        MemoryAllocation m_tlas_memory;
 
         //TLAS instance
         VkBuffer m_instances_buffer = VK_NULL_HANDLE;
-        VkDeviceMemory m_instances_memory = VK_NULL_HANDLE;
+        MemoryAllocation m_instances_memory;
 
     };
 };
@@ -2,6 +2,7 @@
 
 #include "common.h"
 #include "transform.h"
+#include "vertexLayout.h"
 
 
 typedef VkCommandBuffer CommandBuffer;
@@ -12,11 +13,16 @@ namespace MiniEngine
     class Material;
     struct Frame;
     struct Runtime;
+    struct GeometryBinding;
 
     class Entity final 
     {
     public:
-        explicit Entity( const Runtime& i_runtime ) : m_runtime( i_runtime ){};
+        explicit Entity( const Runtime& i_runtime ) : m_runtime( i_runtime )
+        {
+            m_uploaded_version.fill( UINT32_MAX );
+            m_lods.fill( 0 );
+        };
         ~Entity        () = default;
     
         bool initialize();
@@ -25,7 +31,12 @@ namespace MiniEngine
 
         static std::shared_ptr<Entity> createEntity(  const Runtime& i_runtime, const pugi::xml_node& i_node, const uint32_t i_id );
 
-        void draw( CommandBuffer& i_command_buffer,  const Frame& i_frame );
+        //layout the mesh of an entity node is uploaded with
+        static VertexFormat getVertexFormat( const pugi::xml_node& i_node );
+
+        //draws the level of detail selected for the view from the vertex stream the pipeline reads,
+        //io_binding tracks the geometry bound to the command buffer across draws
+        void draw( CommandBuffer& i_command_buffer,  const Frame& i_frame, const LodView i_view = LodView::Camera, const VertexStream i_stream = VertexStream::Interleaved, GeometryBinding* io_binding = nullptr );
 
         inline Transform& getTransform()
        {
@@ -47,6 +58,19 @@ namespace MiniEngine
            return *m_mesh;
        }
 
+       //true when the transform changed since the per object record of this frame slot was written,
+       //the record is considered written after the call. materials are fixed once the scene is loaded
+       //and do not invalidate it
+       bool consumeDirty( const uint32_t i_frame_index );
+
+       inline uint32_t getLod( const LodView i_view ) const
+       {
+           return m_lods[ static_cast<uint32_t>( i_view ) ];
+       }
+
+       //true when the level differs from the one selected before, command buffers drawing the view are then stale
+       bool setLod( const LodView i_view, const uint32_t i_lod );
+
     private:
         Entity( const Entity& ) = delete;
         Entity& operator=(const Entity& ) = delete;
@@ -57,5 +81,7 @@ namespace MiniEngine
         std::shared_ptr<Material> m_material;
 
         uint32_t m_entity_offset;
+        std::array<uint32_t, kMAX_NUMBER_OF_FRAMES> m_uploaded_version; //transform version
+        std::array<uint32_t, static_cast<uint32_t>( LodView::Count )> m_lods;
     };
 };
\ No newline at end of file
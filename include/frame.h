@@ -33,8 +33,15 @@ namespace MiniEngine
         alignas( 16 ) Matrix4f m_model;
         alignas( 16 ) Vector4f m_albedo; 
         alignas( 16 ) Vector4f m_metallic_roughness;
+        //vertex format of the mesh, see VertexDequantization
+        alignas( 16 ) Vector4f m_dequantize_scale;
+        alignas( 16 ) Vector4f m_dequantize_offset;
     };
 
+    //per frame context handed to the passes, frame in flight slot and swap chain image are independent
     struct Frame
-    {};
+    {
+        uint32_t m_frame_index = 0; //slot of the frame in flight: command buffers, descriptor sets and uniform buffers
+        uint32_t m_image_index = 0; //swap chain image the frame presents
+    };
 };
\ No newline at end of file
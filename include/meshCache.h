@@ -0,0 +1,67 @@
+#pragma once
+
+#include "common.h"
+
+namespace MiniEngine
+{
+    //read only mapping of a whole file, unmapped on close or destruction
+    class MappedFile final
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        bool open ( const std::string& i_path );
+        void close();
+
+        inline const uint8_t* getData() const
+        {
+            return m_data;
+        }
+
+        inline size_t getSize() const
+        {
+            return m_size;
+        }
+
+    private:
+        MappedFile( const MappedFile& ) = delete;
+        MappedFile& operator=(const MappedFile& ) = delete;
+
+        const uint8_t* m_data    = nullptr;
+        size_t         m_size    = 0;
+#ifdef _WIN32
+        void*          m_file    = nullptr;
+        void*          m_mapping = nullptr;
+#endif
+    };
+
+    //processed geometry of a mesh file stored next to it as <path>.meshcache. a cache is only used while it
+    //matches the source path, size and modification time, or its content hash when only the time changed
+    namespace MeshCache
+    {
+        //the arrays point into the mapping, or into the caller's vectors when storing
+        struct View
+        {
+            const Vertex*   m_vertices     = nullptr;
+            uint32_t        m_vertex_count = 0;
+            const uint32_t* m_indices      = nullptr;
+            uint32_t        m_index_count  = 0;
+            Vector3f        m_bounds_min   = Vector3f( 0.0f );
+            Vector3f        m_bounds_max   = Vector3f( 0.0f );
+            //ranges of m_indices, the levels of detail follow each other in the array
+            std::array<MeshLod, kMAX_MESH_LODS> m_lods;
+            uint32_t        m_lod_count    = 0;
+            //clusters of the lod 0 range, culled on the gpu
+            const Meshlet*  m_meshlets      = nullptr;
+            uint32_t        m_meshlet_count = 0;
+        };
+
+        //maps the cache of i_source_path into o_file, false when there is none or it is stale
+        bool load ( const std::string& i_source_path, MappedFile& o_file, View& o_view );
+        //failing to write only costs the next start its speedup, so it reports and returns
+        void store( const std::string& i_source_path, const View& i_view );
+
+        std::string getCachePath( const std::string& i_source_path );
+    };
+};
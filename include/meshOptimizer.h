@@ -0,0 +1,37 @@
+#pragma once
+
+#include "common.h"
+
+namespace MiniEngine
+{
+    //reorders the geometry of a mesh for the gpu, without changing what gets drawn. the steps are meant to run
+    //in order: vertex cache, then overdraw on the clusters the first step reports, then vertex fetch
+    namespace MeshOptimizer
+    {
+        struct Stats
+        {
+            float m_acmr = 0.0f; //post transform cache misses per triangle, 0.5 is the best a regular grid gets
+            float m_atvr = 0.0f; //misses per vertex, 1 means every vertex is transformed once
+        };
+
+        //tipsify, keeps triangles around the last used vertices while they are likely still cached.
+        //o_clusters gets the first triangle of every run that starts after a cache restart
+        void optimizeVertexCache ( std::vector<uint32_t>& io_indices, const uint32_t i_vertex_count, std::vector<uint32_t>& o_clusters );
+        //sorts the clusters so the ones facing away from the mesh center, likely occluders, are drawn first
+        void optimizeOverdraw    ( std::vector<uint32_t>& io_indices, const std::vector<Vertex>& i_vertices, const std::vector<uint32_t>& i_clusters );
+        //renumbers the vertices in order of first use, so the draw reads the vertex buffer front to back
+        void optimizeVertexFetch ( std::vector<uint32_t>& io_indices, std::vector<Vertex>& io_vertices );
+
+        //quadric error edge collapse down to about i_target_index_count indices into the same vertices, borders and
+        //uv or normal seams stay in place. returns the object space error of the result, an upper bound of how far
+        //its surface moved
+        float simplify( const std::vector<uint32_t>& i_indices, const std::vector<Vertex>& i_vertices, const uint32_t i_target_index_count, std::vector<uint32_t>& o_indices );
+
+        //splits the range into runs of consecutive triangles with at most kMESHLET_MAX_VERTICES vertices and
+        //kMESHLET_MAX_TRIANGLES triangles. the order is kept, so a vertex cache optimized range gives compact clusters
+        void buildMeshlets( const std::vector<uint32_t>& i_indices, const uint32_t i_index_offset, const uint32_t i_index_count, const std::vector<Vertex>& i_vertices, std::vector<Meshlet>& o_meshlets );
+
+        //simulates a fifo cache of kVERTEX_CACHE_SIZE entries
+        Stats analyze( const std::vector<uint32_t>& i_indices, const uint32_t i_vertex_count );
+    };
+};
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "common.h"
+#include "vertexLayout.h"
+#include <mutex>
+#include <condition_variable>
+#include <unordered_set>
 
 namespace MiniEngine
 {
@@ -17,14 +21,49 @@ namespace MiniEngine
         bool initialize();
         void shutdown();
 
-        std::shared_ptr<MeshVK> loadMesh( const std::string& i_path );
+        typedef std::pair<std::string, VertexFormat> MeshRequest;
+
+        //thread safe, a path is only loaded once per vertex format however many callers ask for it, and a path being
+        //preloaded is waited for instead of parsed a second time
+        std::shared_ptr<MeshVK> loadMesh( const std::string& i_path, const VertexFormat i_format = VertexFormat::Float );
+
+        //parses the files not loaded yet on the thread pool, once per path, then creates and uploads the meshes of
+        //every format asked for on the calling thread
+        void preloadMeshes( const std::vector<MeshRequest>& i_meshes );
+
+        //bottom level acceleration structures of the meshes loaded since the last call
+        void createBLAS();
+
+        //meshes loaded from now on also keep their positions in a stream of their own
+        inline void enablePositionStreams( const bool i_enable )
+        {
+            m_position_streams = i_enable;
+        }
+
+        //the depth only passes read the position streams when the meshes have them
+        inline bool hasPositionStreams() const
+        {
+            return m_position_streams;
+        }
 
 
     private:
         MeshRegistry( const MeshRegistry& ) = delete;
         MeshRegistry& operator=(const MeshRegistry& ) = delete;
 
+        struct Geometry;
+
+        //cpu side of a load, safe to run for different paths at the same time
+        static void loadGeometry( const std::string& i_path, Geometry& o_geometry );
+        std::shared_ptr<MeshVK> createMesh( const std::string& i_path, const VertexFormat i_format, const Geometry& i_geometry );
+
+        static std::string getMeshKey( const std::string& i_path, const VertexFormat i_format );
+
         const Runtime& m_runtime;
         std::unordered_map<std::string, std::shared_ptr<MeshVK>> m_meshes;
+        std::mutex     m_mutex;
+        std::condition_variable         m_preloaded;
+        std::unordered_set<std::string> m_preloading; //paths whose geometry a preload is reading without the lock
+        bool           m_position_streams;
     };
 };
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "defines.h"
+#include "common.h"
 
 namespace MiniEngine
 {
@@ -8,12 +8,22 @@ namespace MiniEngine
     class ShaderRegistry;
     class Engine;
     class RendererVK;
+    class ProfilerVK;
+    class ThreadPool;
+    class CommandPoolsVK;
+    class MeshletCullingVK;
+    class GeometryArenaVK;
 
     struct Runtime
     {
-        std::unique_ptr<RendererVK>     m_renderer;
-        std::unique_ptr<ShaderRegistry> m_shader_registry;
-        std::unique_ptr<MeshRegistry>   m_mesh_registry;
+        std::unique_ptr<RendererVK>       m_renderer;
+        std::unique_ptr<ShaderRegistry>   m_shader_registry;
+        std::unique_ptr<MeshRegistry>     m_mesh_registry;
+        std::unique_ptr<ProfilerVK>       m_profiler;
+        std::unique_ptr<ThreadPool>       m_thread_pool;
+        std::unique_ptr<CommandPoolsVK>   m_command_pools;
+        std::unique_ptr<MeshletCullingVK> m_meshlet_culling;
+        std::unique_ptr<GeometryArenaVK>  m_geometry_arena;
         
 
         inline const std::array<VkBuffer, kMAX_NUMBER_OF_FRAMES> getPerFrameBuffer() const
@@ -38,10 +48,10 @@ namespace MiniEngine
         void freeResources  ();
 
         std::array<VkBuffer      , kMAX_NUMBER_OF_FRAMES> m_per_frame_buffer        = { VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE};
-        std::array<VkDeviceMemory, kMAX_NUMBER_OF_FRAMES> m_per_frame_buffer_memory;
+        std::array<MemoryAllocation, kMAX_NUMBER_OF_FRAMES> m_per_frame_buffer_memory;
 
         std::array<VkBuffer       , kMAX_NUMBER_OF_FRAMES> m_per_object_buffer = { VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE };
-        std::array<VkDeviceMemory, kMAX_NUMBER_OF_FRAMES> m_per_object_buffer_memory;
+        std::array<MemoryAllocation, kMAX_NUMBER_OF_FRAMES> m_per_object_buffer_memory;
 
         friend class Engine;
     };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "common.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+
+namespace MiniEngine
+{
+    class ThreadPool final
+    {
+    public:
+        typedef std::function<void()> Job;
+
+        explicit ThreadPool( const uint32_t i_worker_count );
+        ~ThreadPool();
+
+        //runs the jobs on the workers and the calling thread, returns once all of them are done.
+        //a job may call run() again, the waiting thread keeps executing queued jobs instead of blocking
+        void run( const std::vector<Job>& i_jobs );
+
+        //workers plus the thread that owns the pool
+        inline uint32_t getThreadCount() const
+        {
+            return static_cast<uint32_t>( m_workers.size() ) + 1;
+        }
+
+        //0 for the owner thread, 1..N for the workers
+        static uint32_t getThreadIndex();
+
+    private:
+        ThreadPool( const ThreadPool& ) = delete;
+        ThreadPool& operator=(const ThreadPool& ) = delete;
+
+        struct Batch
+        {
+            uint32_t           m_pending = 0;
+            std::exception_ptr m_error;
+        };
+
+        struct Task
+        {
+            const Job* m_job;
+            Batch*     m_batch;
+        };
+
+        void workerLoop( const uint32_t i_thread_index );
+        void execute   ( const Task& i_task );
+
+        std::vector<std::thread> m_workers;
+        std::deque<Task>         m_queue;
+        std::mutex               m_mutex;
+        std::condition_variable  m_condition;
+        bool                     m_stop;
+    };
+};
@@ -15,8 +15,13 @@ namespace MiniEngine
     public:
         explicit Transform();
         explicit Transform( const Matrix4f& i_mat );
+        Transform( const Transform& ) = default;
         ~Transform() = default;
 
+        //takes the matrix but keeps growing its own version, the one of the other transform
+        //may be a version the frame slots already uploaded
+        Transform& operator=( const Transform& i_other );
+
         bool initialize();
         void shutdown  ();
 
@@ -27,6 +32,12 @@ namespace MiniEngine
         void rotate   ( const RotAxis&  i_rotation    );
         void scale    ( const Vector3f& i_scale       );
 
+        //grows on every change of the matrix
+        inline uint32_t getVersion() const
+        {
+            return m_version;
+        }
+
         /// Concatenate with another transform
         Transform operator*(const Transform &t) const;
 
@@ -34,6 +45,7 @@ namespace MiniEngine
 
     private:
         bool m_dirty;
+        uint32_t m_version;
         Matrix4f m_transform_matrix;
         Matrix4f m_inverse_transform;
     };
@@ -0,0 +1,309 @@
+#pragma once
+
+#include "common.h"
+
+#include <glm/gtc/packing.hpp>
+
+namespace MiniEngine
+{
+    //layouts a mesh can be uploaded with, chosen per mesh in the scene. the cache and the cpu side keep Vertex
+    enum class VertexFormat : uint32_t
+    {
+        Float,   //32 bytes, the Vertex struct as is
+        Compact, //16 bytes, 16 bit positions within the mesh bounds, octahedral normals and half uvs
+        Count
+    };
+
+    constexpr uint32_t kVERTEX_FORMAT_COUNT = static_cast<uint32_t>( VertexFormat::Count );
+
+    //vertex buffers of a mesh, the depth only passes fetch nothing but the positions
+    enum class VertexStream : uint32_t
+    {
+        Interleaved, //every attribute of the format
+        Position     //the positions alone, in the encoding of the format
+    };
+
+    //takes the stored position back to object space in the vertex shader, the w of the scale is 1 when
+    //the normals are octahedral. laid out as the end of ObjectData in the shaders
+    struct VertexDequantization
+    {
+        Vector4f m_scale  = Vector4f( 1.0f, 1.0f, 1.0f, 0.0f );
+        Vector4f m_offset = Vector4f( 0.0f );
+    };
+
+    //every encoding knows its stored type, the vulkan format the vertex fetch decodes it with and how to encode
+    namespace VertexEncoding
+    {
+        struct PositionFloat3
+        {
+            struct Type { float m_value[ 3 ]; };
+
+            static constexpr VkFormat kFORMAT = VK_FORMAT_R32G32B32_SFLOAT;
+
+            static Type encode( const Vector3f& i_position, const Vector3f& /*i_center*/, const Vector3f& /*i_half_extent*/ )
+            {
+                return { { i_position.x, i_position.y, i_position.z } };
+            }
+
+            static void getDequantization( const Vector3f& /*i_center*/, const Vector3f& /*i_half_extent*/, VertexDequantization& io_dequantization )
+            {
+                io_dequantization.m_scale  = Vector4f( 1.0f, 1.0f, 1.0f, io_dequantization.m_scale.w );
+                io_dequantization.m_offset = Vector4f( 0.0f );
+            }
+        };
+
+        //signed around the center of the bounds, one of the formats acceleration structures take as input.
+        //the fourth component pads the fetch to 8 bytes, three component 16 bit formats are rarely supported
+        struct PositionSnorm16
+        {
+            struct Type { int16_t m_value[ 4 ]; };
+
+            static constexpr VkFormat kFORMAT = VK_FORMAT_R16G16B16A16_SNORM;
+
+            static Type encode( const Vector3f& i_position, const Vector3f& i_center, const Vector3f& i_half_extent )
+            {
+                const Vector3f normalized = glm::clamp( ( i_position - i_center ) / i_half_extent, Vector3f( -1.0f ), Vector3f( 1.0f ) );
+                return { { toSnorm16( normalized.x ), toSnorm16( normalized.y ), toSnorm16( normalized.z ), 0 } };
+            }
+
+            static void getDequantization( const Vector3f& i_center, const Vector3f& i_half_extent, VertexDequantization& io_dequantization )
+            {
+                io_dequantization.m_scale  = Vector4f( i_half_extent, io_dequantization.m_scale.w );
+                io_dequantization.m_offset = Vector4f( i_center, 0.0f );
+            }
+
+            static int16_t toSnorm16( const float i_value )
+            {
+                return static_cast<int16_t>( std::round( i_value * 32767.0f ) );
+            }
+        };
+
+        struct NormalFloat3
+        {
+            struct Type { float m_value[ 3 ]; };
+
+            static constexpr VkFormat kFORMAT     = VK_FORMAT_R32G32B32_SFLOAT;
+            static constexpr bool     kOCTAHEDRAL = false;
+
+            static Type encode( const Vector3f& i_normal )
+            {
+                return { { i_normal.x, i_normal.y, i_normal.z } };
+            }
+        };
+
+        //the unit sphere folded onto a square, two components read back as (x, y, 0) and unfolded in the shader
+        struct NormalOctahedral16
+        {
+            struct Type { int16_t m_value[ 2 ]; };
+
+            static constexpr VkFormat kFORMAT     = VK_FORMAT_R16G16_SNORM;
+            static constexpr bool     kOCTAHEDRAL = true;
+
+            static Type encode( const Vector3f& i_normal )
+            {
+                const float length = std::abs( i_normal.x ) + std::abs( i_normal.y ) + std::abs( i_normal.z );
+                if( length <= 0.0f )
+                {
+                    return { { 0, 0 } };
+                }
+
+                Vector2f folded = Vector2f( i_normal.x, i_normal.y ) / length;
+
+                //lower hemisphere goes to the corners
+                if( i_normal.z < 0.0f )
+                {
+                    folded = ( Vector2f( 1.0f ) - glm::abs( Vector2f( folded.y, folded.x ) ) ) *
+                             Vector2f( folded.x >= 0.0f ? 1.0f : -1.0f, folded.y >= 0.0f ? 1.0f : -1.0f );
+                }
+
+                return { { PositionSnorm16::toSnorm16( folded.x ), PositionSnorm16::toSnorm16( folded.y ) } };
+            }
+        };
+
+        struct UvFloat2
+        {
+            struct Type { float m_value[ 2 ]; };
+
+            static constexpr VkFormat kFORMAT = VK_FORMAT_R32G32_SFLOAT;
+
+            static Type encode( const Vector2f& i_uv )
+            {
+                return { { i_uv.x, i_uv.y } };
+            }
+        };
+
+        //half floats keep tiling uvs outside 0..1
+        struct UvHalf2
+        {
+            struct Type { uint16_t m_value[ 2 ]; };
+
+            static constexpr VkFormat kFORMAT = VK_FORMAT_R16G16_SFLOAT;
+
+            static Type encode( const Vector2f& i_uv )
+            {
+                return { { glm::packHalf1x16( i_uv.x ), glm::packHalf1x16( i_uv.y ) } };
+            }
+        };
+    };
+
+    //interleaved layout built from one encoding per attribute, generates both the packing and the vertex input
+    //of the pipelines, so the two can not drift apart
+    template<typename TPosition, typename TNormal, typename TUv>
+    struct VertexLayout
+    {
+        struct Packed
+        {
+            typename TPosition::Type m_position;
+            typename TNormal::Type   m_normal;
+            typename TUv::Type       m_uv;
+        };
+
+        static constexpr uint32_t kSTRIDE          = sizeof( Packed );
+        static constexpr uint32_t kPOSITION_STRIDE = sizeof( typename TPosition::Type );
+
+        static std::array<VkVertexInputAttributeDescription, 3> getAttributes( const uint32_t i_binding )
+        {
+            return { {
+                { 0, i_binding, TPosition::kFORMAT, static_cast<uint32_t>( offsetof( Packed, m_position ) ) },
+                { 1, i_binding, TNormal::kFORMAT  , static_cast<uint32_t>( offsetof( Packed, m_normal   ) ) },
+                { 2, i_binding, TUv::kFORMAT      , static_cast<uint32_t>( offsetof( Packed, m_uv       ) ) }
+            } };
+        }
+
+        //the position stream starts every vertex with the position
+        static VkVertexInputAttributeDescription getPositionAttribute( const uint32_t i_binding )
+        {
+            return { 0, i_binding, TPosition::kFORMAT, 0 };
+        }
+
+        //o_data receives i_count packed vertices
+        static VertexDequantization pack( const Vertex* i_vertices, const uint32_t i_count, const Vector3f& i_bounds_min, const Vector3f& i_bounds_max, std::vector<uint8_t>& o_data )
+        {
+            Vector3f center, half_extent;
+            getRange( i_bounds_min, i_bounds_max, center, half_extent );
+
+            o_data.resize( size_t( i_count ) * kSTRIDE );
+            Packed* packed = reinterpret_cast<Packed*>( o_data.data() );
+
+            for( uint32_t idx = 0; idx < i_count; idx++ )
+            {
+                packed[ idx ].m_position = TPosition::encode( i_vertices[ idx ].m_position, center, half_extent );
+                packed[ idx ].m_normal   = TNormal::encode  ( i_vertices[ idx ].m_normal );
+                packed[ idx ].m_uv       = TUv::encode      ( i_vertices[ idx ].m_uv );
+            }
+
+            VertexDequantization dequantization;
+            dequantization.m_scale.w = TNormal::kOCTAHEDRAL ? 1.0f : 0.0f;
+            TPosition::getDequantization( center, half_extent, dequantization );
+
+            return dequantization;
+        }
+
+        //o_data receives the positions alone, encoded as in pack so both streams rasterize the same
+        static void packPositions( const Vertex* i_vertices, const uint32_t i_count, const Vector3f& i_bounds_min, const Vector3f& i_bounds_max, std::vector<uint8_t>& o_data )
+        {
+            Vector3f center, half_extent;
+            getRange( i_bounds_min, i_bounds_max, center, half_extent );
+
+            o_data.resize( size_t( i_count ) * kPOSITION_STRIDE );
+            typename TPosition::Type* positions = reinterpret_cast<typename TPosition::Type*>( o_data.data() );
+
+            for( uint32_t idx = 0; idx < i_count; idx++ )
+            {
+                positions[ idx ] = TPosition::encode( i_vertices[ idx ].m_position, center, half_extent );
+            }
+        }
+
+    private:
+        static void getRange( const Vector3f& i_bounds_min, const Vector3f& i_bounds_max, Vector3f& o_center, Vector3f& o_half_extent )
+        {
+            o_center      = ( i_bounds_min + i_bounds_max ) * 0.5f;
+            //a flat axis keeps a unit range, every position on it encodes to 0
+            o_half_extent = glm::max( ( i_bounds_max - i_bounds_min ) * 0.5f, Vector3f( std::numeric_limits<float>::min() ) );
+        }
+    };
+
+    using FloatVertexLayout   = VertexLayout<VertexEncoding::PositionFloat3 , VertexEncoding::NormalFloat3      , VertexEncoding::UvFloat2>;
+    using CompactVertexLayout = VertexLayout<VertexEncoding::PositionSnorm16, VertexEncoding::NormalOctahedral16, VertexEncoding::UvHalf2 >;
+
+    static_assert( FloatVertexLayout::kSTRIDE   == sizeof( Vertex ), "the float layout uploads Vertex as is" );
+    static_assert( CompactVertexLayout::kSTRIDE == 16              , "the compact layout is half of Vertex"  );
+
+    //runtime side of the layouts, for the code that only knows the format of a mesh
+    namespace VertexLayouts
+    {
+        //calls i_function with a default constructed layout of the format
+        template<typename TFunction>
+        auto visit( const VertexFormat i_format, TFunction&& i_function )
+        {
+            switch( i_format )
+            {
+                case VertexFormat::Compact: return i_function( CompactVertexLayout() );
+                default:                    return i_function( FloatVertexLayout  () );
+            }
+        }
+
+        //vertex input of the pipelines drawing a stream of the meshes of the format, the create info points into this struct
+        struct InputState
+        {
+            VkVertexInputBindingDescription                  m_binding;
+            std::array<VkVertexInputAttributeDescription, 3> m_attributes;
+            uint32_t                                         m_attribute_count;
+            VkPipelineVertexInputStateCreateInfo             m_create_info;
+
+            explicit InputState( const VertexFormat i_format, const VertexStream i_stream = VertexStream::Interleaved )
+            {
+                visit( i_format, [ this, i_stream ]( auto i_layout )
+                {
+                    using Layout = decltype( i_layout );
+
+                    m_binding.binding   = 0;
+                    m_binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+                    if( i_stream == VertexStream::Position )
+                    {
+                        m_binding.stride  = Layout::kPOSITION_STRIDE;
+                        m_attributes[ 0 ] = Layout::getPositionAttribute( 0 );
+                        m_attribute_count = 1;
+                    }
+                    else
+                    {
+                        m_binding.stride  = Layout::kSTRIDE;
+                        m_attributes      = Layout::getAttributes( 0 );
+                        m_attribute_count = static_cast<uint32_t>( m_attributes.size() );
+                    }
+                } );
+
+                m_create_info                                 = {};
+                m_create_info.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+                m_create_info.vertexBindingDescriptionCount   = 1;
+                m_create_info.pVertexBindingDescriptions      = &m_binding;
+                m_create_info.vertexAttributeDescriptionCount = m_attribute_count;
+                m_create_info.pVertexAttributeDescriptions    = m_attributes.data();
+            }
+
+            InputState( const InputState& ) = delete;
+            InputState& operator=(const InputState& ) = delete;
+        };
+
+        inline VertexFormat parseFormat( const std::string& i_name )
+        {
+            if( i_name.empty() || i_name == "float" )
+            {
+                return VertexFormat::Float;
+            }
+
+            if( i_name == "compact" )
+            {
+                return VertexFormat::Compact;
+            }
+
+            throw MiniEngineException( "Unknown vertex format %s", i_name );
+        }
+
+        inline const char* getFormatName( const VertexFormat i_format )
+        {
+            return i_format == VertexFormat::Compact ? "compact" : "float";
+        }
+    };
+};
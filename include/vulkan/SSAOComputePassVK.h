@@ -0,0 +1,57 @@
+#pragma once
+
+#include "vulkan/renderPassVK.h"
+
+namespace MiniEngine
+{
+    struct Runtime;
+
+    //screen space ambient occlusion in a compute dispatch. it only reads the gbuffer, so the render graph
+    //can run it on the async compute queue next to the shadow maps
+    class SSAOComputePassVK final : public RenderPassVK
+    {
+    public:
+        SSAOComputePassVK(
+                            const Runtime& i_runtime,
+                            const ImageBlock& i_in_position_depth_attachment,
+                            const ImageBlock& i_in_normal_attachment,
+                            const ImageBlock& i_out_ssao
+                         );
+        virtual ~SSAOComputePassVK();
+
+        bool            initialize() override;
+        void            shutdown  () override;
+        VkCommandBuffer draw      ( const Frame& i_frame ) override;
+        void            resize    () override;
+
+        bool isCompute() const override
+        {
+            return true;
+        }
+
+    private:
+        SSAOComputePassVK( const SSAOComputePassVK& ) = delete;
+        SSAOComputePassVK& operator=(const SSAOComputePassVK& ) = delete;
+
+        void createKernel          ();
+        void createPipeline        ();
+        void createDescriptorLayout();
+        void createDescriptors     ();
+        //points the gbuffer and output bindings at the current images
+        void updateAttachmentDescriptors();
+
+        VkPipeline                                         m_pipeline;
+        VkPipelineLayout                                   m_pipeline_layout;
+        VkDescriptorSetLayout                              m_descriptor_set_layout;
+        VkDescriptorPool                                   m_descriptor_pool;
+        std::array<VkDescriptorSet, kMAX_NUMBER_OF_FRAMES> m_descriptor_sets; //one per slot, they differ in the per frame buffer
+
+        VkBuffer         m_kernel_buffer; //hemisphere samples, written once
+        MemoryAllocation m_kernel_memory;
+
+        //the render graph images are recreated in place on resize
+        const ImageBlock& m_in_position_depth_attachment;
+        const ImageBlock& m_in_normal_attachment;
+        const ImageBlock& m_out_ssao;
+    };
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "vulkan/renderPassVK.h"
+
+namespace MiniEngine
+{
+    struct Runtime;
+
+    //box blur of a single channel image in a compute dispatch, removes the per pixel rotation noise of the ssao
+    class BlurComputePassVK final : public RenderPassVK
+    {
+    public:
+        BlurComputePassVK(
+                            const Runtime& i_runtime,
+                            const ImageBlock& i_in_image,
+                            const ImageBlock& i_out_image
+                         );
+        virtual ~BlurComputePassVK();
+
+        bool            initialize() override;
+        void            shutdown  () override;
+        VkCommandBuffer draw      ( const Frame& i_frame ) override;
+        void            resize    () override;
+
+        bool isCompute() const override
+        {
+            return true;
+        }
+
+    private:
+        BlurComputePassVK( const BlurComputePassVK& ) = delete;
+        BlurComputePassVK& operator=(const BlurComputePassVK& ) = delete;
+
+        void createPipeline        ();
+        void createDescriptorLayout();
+        void createDescriptors     ();
+        void updateAttachmentDescriptors();
+
+        VkPipeline            m_pipeline;
+        VkPipelineLayout      m_pipeline_layout;
+        VkDescriptorSetLayout m_descriptor_set_layout;
+        VkDescriptorPool      m_descriptor_pool;
+        VkDescriptorSet       m_descriptor_set; //only images, shared by every frame slot
+
+        const ImageBlock& m_in_image;
+        const ImageBlock& m_out_image;
+    };
+};
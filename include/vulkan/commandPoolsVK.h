@@ -0,0 +1,46 @@
+#pragma once
+
+#include "common.h"
+
+namespace MiniEngine
+{
+    struct Runtime;
+
+    //one command pool per recording thread and slot, so threads never share a pool and a whole slot
+    //is recycled with a single reset. slots are frame slots for per frame recording, or whatever key
+    //a pass caches its command buffers by. the command buffers can only go to queues of i_queue_family_index
+    class CommandPoolsVK final
+    {
+    public:
+        CommandPoolsVK( const Runtime& i_runtime, const uint32_t i_thread_count, const uint32_t i_slot_count, const bool i_transient, const uint32_t i_queue_family_index );
+        ~CommandPoolsVK() = default;
+
+        bool initialize();
+        void shutdown  ();
+
+        //resets every pool of the slot, the gpu must be done with its command buffers
+        void reset( const uint32_t i_slot );
+
+        //command buffer from the calling thread's pool, valid until the slot is reset again
+        VkCommandBuffer getCommandBuffer( const uint32_t i_slot, const VkCommandBufferLevel i_level = VK_COMMAND_BUFFER_LEVEL_PRIMARY );
+
+    private:
+        CommandPoolsVK( const CommandPoolsVK& ) = delete;
+        CommandPoolsVK& operator=(const CommandPoolsVK& ) = delete;
+
+        struct ThreadPoolVK
+        {
+            VkCommandPool                               m_pool = VK_NULL_HANDLE;
+            std::array<std::vector<VkCommandBuffer>, 2> m_buffers; //primary and secondary, reused after every reset
+            std::array<uint32_t                    , 2> m_used    = { 0, 0 };
+        };
+
+        const Runtime& m_runtime;
+        const uint32_t m_thread_count;
+        const uint32_t m_slot_count;
+        const bool     m_transient;
+        const uint32_t m_queue_family_index;
+
+        std::vector<ThreadPoolVK> m_pools; //[slot * thread count + thread]
+    };
+};
@@ -18,14 +18,16 @@ namespace MiniEngine
                             const ImageBlock& i_in_normal_attachment,
                             const ImageBlock& i_in_material_attachment,
 			                const ImageBlock& i_in_shadow_attachment,
+                            const ImageBlock& i_in_ambient_occlusion,
                             const VkAccelerationStructureKHR& i_tlas,
-                            const std::array<ImageBlock, 3>& i_output_swap_images 
+                            const std::vector<ImageBlock>& i_output_swap_images 
                           );
         virtual ~CompositionPassVK();
 
         bool            initialize() override;
         void            shutdown  () override;
         VkCommandBuffer draw      ( const Frame& i_frame ) override;
+        void            resize    () override;
 
     private:
         CompositionPassVK( const CompositionPassVK& ) = delete;
@@ -36,6 +38,8 @@ namespace MiniEngine
         void createPipelines       ();
         void createDescriptorLayout();
         void createDescriptors     ();
+        //points the gbuffer, shadow and ambient occlusion bindings at the current images
+        void updateAttachmentDescriptors();
 
         struct DescriptorsSets
         {
@@ -43,8 +47,7 @@ namespace MiniEngine
         };
 
         VkRenderPass                   m_render_pass;
-        std::array<VkCommandBuffer, 3> m_command_buffer;
-        std::array<VkFramebuffer  , 3> m_fbos;
+        std::vector<VkFramebuffer                        > m_fbos; //one per swap chain image
 
         // prepare the different render supported depending on the material
         VkPipeline                                                         m_composition_pipeline;
@@ -56,12 +59,14 @@ namespace MiniEngine
     
         MeshVKPtr m_plane;
 
-        ImageBlock m_in_color_attachment;
-        ImageBlock m_in_position_depth_attachment;
-        ImageBlock m_in_normal_attachment;
-        ImageBlock m_in_material_attachment;
-		ImageBlock m_in_shadow_attachment;
+        //the render graph images and the swap chain images are recreated in place on resize
+        const ImageBlock& m_in_color_attachment;
+        const ImageBlock& m_in_position_depth_attachment;
+        const ImageBlock& m_in_normal_attachment;
+        const ImageBlock& m_in_material_attachment;
+		const ImageBlock& m_in_shadow_attachment;
+        const ImageBlock& m_in_ambient_occlusion;
         VkAccelerationStructureKHR m_tlas;
-        std::array<ImageBlock, 3> m_output_swap_images;
+        const std::vector<ImageBlock>& m_output_swap_images;
     };
 };
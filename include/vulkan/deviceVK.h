@@ -5,6 +5,8 @@
 namespace MiniEngine
 {
     class RendererVK;
+    class MemoryAllocatorVK;
+    class UploadManagerVK;
 
     class DeviceVK final
     {
@@ -27,11 +29,101 @@ namespace MiniEngine
             return m_graphics_queue;
         }
 
+        uint32_t getGraphicsQueueFamilyIndex() const
+        {
+            return m_graphics_queue_index;
+        }
+
+        //the graphics queue when the device has no transfer only family
+        VkQueue getTransferQueue() const
+        {
+            return m_transfer_queue;
+        }
+
+        uint32_t getTransferQueueFamilyIndex() const
+        {
+            return m_transfer_queue_index;
+        }
+
+        //resources written on the transfer queue change family before the graphics queue uses them
+        bool hasDedicatedTransferQueue() const
+        {
+            return m_transfer_queue_index != m_graphics_queue_index;
+        }
+
+        //the graphics queue when the device has no compute family without graphics
+        VkQueue getComputeQueue() const
+        {
+            return m_compute_queue;
+        }
+
+        uint32_t getComputeQueueFamilyIndex() const
+        {
+            return m_compute_queue_index;
+        }
+
+        //compute work submitted here runs next to the graphics queue instead of after it
+        bool hasAsyncComputeQueue() const
+        {
+            return m_compute_queue_index != m_graphics_queue_index;
+        }
+
         VkCommandPool getCommandPool() const
         {
             return m_command_pool;
         }
 
+        const VkPhysicalDeviceProperties& getPhysicalDeviceProperties() const
+        {
+            return m_phyisical_device_properties;
+        }
+
+        //supported features, all of them are enabled on the logical device
+        const VkPhysicalDeviceFeatures& getPhysicalDeviceFeatures() const
+        {
+            return m_physical_device_features;
+        }
+
+        const VkQueueFamilyProperties& getGraphicsQueueFamilyProperties() const
+        {
+            return m_queue_family_properties[ m_graphics_queue_index ];
+        }
+
+        const VkQueueFamilyProperties& getComputeQueueFamilyProperties() const
+        {
+            return m_queue_family_properties[ m_compute_queue_index ];
+        }
+
+        const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const
+        {
+            return m_physical_device_memory_properties;
+        }
+
+        //buffers can be given device addresses, linear memory is then allocated with the flag for it
+        bool supportsBufferDeviceAddress() const
+        {
+            return m_buffer_device_address;
+        }
+
+        //acceleration structures and ray queries, without them no BLAS or TLAS is built and the
+        //composition reads the shadow maps only
+        bool supportsRayTracing() const
+        {
+            return m_ray_tracing;
+        }
+
+        //every buffer and image of the engine takes its memory from here
+        MemoryAllocatorVK& getAllocator() const
+        {
+            return *m_allocator;
+        }
+
+        //staged copies into device local buffers and images
+        UploadManagerVK& getUploadManager() const
+        {
+            return *m_upload_manager;
+        }
+
         uint32_t getMemoryTypeIndex( uint32_t typeBits, VkMemoryPropertyFlags properties ) const;
 
     private:
@@ -48,13 +140,19 @@ namespace MiniEngine
         void destroyDevice();
         void destroyCommandPool();
 
-        uint32_t getQueueFamilyIndex( VkQueueFlagBits i_queue_flags ) const;
+        uint32_t getQueueFamilyIndex        ( VkQueueFlagBits i_queue_flags ) const;
+        uint32_t getTransferQueueFamilyIndex( const uint32_t i_fallback_index ) const;
+        uint32_t getComputeQueueFamilyIndex ( const uint32_t i_fallback_index ) const;
     
         const RendererVK& m_renderer;
 
         uint32_t                                         m_graphics_queue_index;
+        uint32_t                                         m_transfer_queue_index;
+        uint32_t                                         m_compute_queue_index;
         VkCommandPool                                    m_command_pool;
         VkQueue                                          m_graphics_queue;
+        VkQueue                                          m_transfer_queue;
+        VkQueue                                          m_compute_queue;
         VkPhysicalDeviceProperties                       m_phyisical_device_properties;
         VkPhysicalDeviceFeatures                         m_physical_device_features;
         VkPhysicalDeviceMemoryProperties                 m_physical_device_memory_properties;
@@ -64,6 +162,10 @@ namespace MiniEngine
         std::vector<VkQueueFamilyProperties>             m_queue_family_properties;
         std::vector<std::string>                         m_supported_extensions;
         std::vector<const char*>                         m_extensions;
+        std::unique_ptr<MemoryAllocatorVK>               m_allocator;
+        std::unique_ptr<UploadManagerVK>                 m_upload_manager;
+        bool                                             m_buffer_device_address;
+        bool                                             m_ray_tracing;
 
         friend class RendererVK;
     };
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "common.h"
+#include "vertexLayout.h"
+#include <mutex>
+
+namespace MiniEngine
+{
+    struct Runtime;
+
+    //buffers a command buffer has bound, draws of meshes living in the same blocks skip the binds
+    struct GeometryBinding
+    {
+        VkBuffer     m_vertices = VK_NULL_HANDLE;
+        VkBuffer     m_indices  = VK_NULL_HANDLE;
+        VertexStream m_stream   = VertexStream::Interleaved;
+    };
+
+    //packs the vertices and indices of every mesh in a few large buffers instead of two buffers per mesh.
+    //each vertex format has its own blocks, the vertex offset of a draw counts vertices of the bound stride,
+    //and so does each index type, a block is bound with the type of the indices it holds.
+    //the position stream of a block mirrors its interleaved buffer, so a mesh has the same vertex offset in
+    //both and the culled commands serve every pass
+    class GeometryArenaVK final
+    {
+    public:
+        //where a mesh lives, its draws add the offsets to their index and vertex ranges
+        struct Allocation
+        {
+            VertexFormat m_format        = VertexFormat::Float;
+            uint32_t     m_vertex_block  = UINT32_MAX;
+            uint32_t     m_vertex_offset = 0; //in vertices
+            uint32_t     m_vertex_count  = 0;
+            VkIndexType  m_index_type    = VK_INDEX_TYPE_UINT32;
+            uint32_t     m_index_block   = UINT32_MAX;
+            uint32_t     m_first_index   = 0;
+            uint32_t     m_index_count   = 0;
+        };
+
+        struct Stats
+        {
+            uint32_t     m_blocks      = 0;
+            uint32_t     m_allocations = 0;
+            VkDeviceSize m_reserved    = 0; //bytes of the block buffers
+            VkDeviceSize m_used        = 0; //bytes handed out to meshes
+        };
+
+        explicit GeometryArenaVK( const Runtime& i_runtime );
+        ~GeometryArenaVK() = default;
+
+        bool initialize();
+        void shutdown  ();
+
+        //thread safe. i_position_stream places the mesh in a block with a position buffer
+        Allocation allocate( const VertexFormat i_format, const uint32_t i_vertex_count, const uint32_t i_index_count, const VkIndexType i_index_type, const bool i_position_stream );
+        //the gpu must be done with the ranges, a block left empty releases its buffers
+        void       free    ( Allocation& io_allocation );
+
+        //buffers and byte offsets of the ranges of an allocation, for the uploads and the acceleration structures
+        VkBuffer     getVertexBuffer( const Allocation& i_allocation, const VertexStream i_stream ) const;
+        VkDeviceSize getVertexOffset( const Allocation& i_allocation, const VertexStream i_stream ) const;
+        VkBuffer     getIndexBuffer ( const Allocation& i_allocation ) const;
+        VkDeviceSize getIndexOffset ( const Allocation& i_allocation ) const;
+
+        //binds the blocks of the allocation unless io_binding says they already are
+        void bind( VkCommandBuffer i_command_buffer, const Allocation& i_allocation, const VertexStream i_stream, GeometryBinding& io_binding ) const;
+
+        Stats getStats  () const;
+        void  printStats( std::ostream& o_stream ) const;
+
+    private:
+        GeometryArenaVK( const GeometryArenaVK& ) = delete;
+        GeometryArenaVK& operator=(const GeometryArenaVK& ) = delete;
+
+        struct Block
+        {
+            VkBuffer                     m_buffer          = VK_NULL_HANDLE;
+            MemoryAllocation             m_memory;
+            VkBuffer                     m_position_buffer = VK_NULL_HANDLE; //vertex blocks only, null without position streams
+            MemoryAllocation             m_position_memory;
+            uint32_t                     m_capacity        = 0; //in vertices or indices
+            uint32_t                     m_allocations     = 0;
+            std::map<uint32_t, uint32_t> m_free; //offset to count, sorted so a freed range merges with its neighbours
+        };
+
+        //finds room in the blocks or opens a new one, at least as big as the range
+        uint32_t allocateRange( std::vector<Block>& io_blocks, const uint32_t i_count, const uint32_t i_block_capacity, const uint32_t i_stride, const uint32_t i_position_stride,
+                                const VkBufferUsageFlags i_usage, uint32_t& o_offset );
+        void     freeRange    ( Block& io_block, const uint32_t i_offset, const uint32_t i_count );
+        void     releaseBlock ( Block& io_block );
+
+        static bool     suballocate ( Block& io_block, const uint32_t i_count, uint32_t& o_offset );
+        static uint32_t getIndexPool( const VkIndexType i_index_type );
+
+        const Runtime& m_runtime;
+
+        std::array<std::vector<Block>, kVERTEX_FORMAT_COUNT> m_vertex_blocks; //released blocks stay as empty slots, allocations keep their index
+        std::array<std::vector<Block>, 2>                    m_index_blocks;  //16 and 32 bit
+
+        mutable std::mutex m_mutex;
+    };
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "common.h"
+#include <mutex>
+
+namespace MiniEngine
+{
+    class DeviceVK;
+
+    //hands out ranges of a few large VkDeviceMemory blocks instead of allocating memory for every resource.
+    //each memory type keeps buffers and optimal images in different blocks, so a linear and a non linear
+    //resource never share a bufferImageGranularity page
+    class MemoryAllocatorVK final
+    {
+    public:
+        struct Stats
+        {
+            uint32_t     m_blocks       = 0;
+            uint32_t     m_dedicated    = 0; //resources too big for a block, allocated on their own
+            uint32_t     m_allocations  = 0;
+            uint32_t     m_free_ranges  = 0;
+            VkDeviceSize m_reserved     = 0; //device memory the allocator holds
+            VkDeviceSize m_used         = 0; //handed out to resources
+            VkDeviceSize m_largest_free = 0;
+
+            //0 when the free memory of the blocks is a single range, close to 1 when it is scattered
+            float getFragmentation() const;
+        };
+
+        explicit MemoryAllocatorVK( const DeviceVK& i_device );
+        ~MemoryAllocatorVK();
+
+        //host visible memory comes back persistently mapped, m_mapped already points at the offset
+        MemoryAllocation allocate( const VkMemoryRequirements& i_requirements, const VkMemoryPropertyFlags i_properties, const bool i_linear );
+        void             free    ( MemoryAllocation& io_allocation );
+
+        void shutdown();
+
+        Stats getStats  () const;
+        void  printStats( std::ostream& o_stream ) const;
+
+    private:
+        MemoryAllocatorVK( const MemoryAllocatorVK& ) = delete;
+        MemoryAllocatorVK& operator=(const MemoryAllocatorVK& ) = delete;
+
+        struct Block
+        {
+            VkDeviceMemory                       m_memory      = VK_NULL_HANDLE;
+            VkDeviceSize                         m_size        = 0;
+            uint32_t                             m_type        = 0;
+            bool                                 m_linear      = true;
+            uint8_t*                             m_mapped      = nullptr;
+            uint32_t                             m_allocations = 0;
+            std::map<VkDeviceSize, VkDeviceSize> m_free; //offset to size, sorted so a freed range merges with its neighbours
+        };
+
+        VkDeviceMemory allocateMemory( const uint32_t i_type, const VkDeviceSize i_size, const bool i_linear, void** o_mapped );
+        bool           suballocate   ( Block& io_block, const VkMemoryRequirements& i_requirements, VkDeviceSize& o_offset );
+        void           releaseBlock  ( const uint32_t i_block );
+
+        const DeviceVK&    m_device;
+
+        std::vector<Block> m_blocks; //released blocks stay as empty slots, allocations keep their index
+        uint32_t           m_dedicated_count;
+        VkDeviceSize       m_dedicated_size;
+
+        mutable std::mutex m_mutex;
+    };
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "common.h"
+#include "meshCache.h"
+#include "vertexLayout.h"
+#include "vulkan/geometryArenaVK.h"
 
 
 namespace MiniEngine
@@ -10,42 +13,120 @@ namespace MiniEngine
     class MeshVK final
     {
     public:
-        explicit MeshVK( const Runtime& i_runtime, const std::string& i_path, const std::vector<uint32_t> i_indices, const std::vector<Vertex> i_vertices );
+        //the arrays of i_geometry are uploaded by initialize in i_format and only need to live until it returns.
+        //i_position_stream keeps the positions in a buffer of their own as well, for the depth only passes.
+        //16 bit indices need fewer than 65535 vertices
+        explicit MeshVK( const Runtime& i_runtime, const std::string& i_path, const MeshCache::View& i_geometry, const VertexFormat i_format = VertexFormat::Float, const bool i_position_stream = false,
+                         const VkIndexType i_index_type = VK_INDEX_TYPE_UINT32 );
         ~MeshVK() = default;
     
         bool initialize();
         void shutdown();
 
-        void draw( VkCommandBuffer& i_command_buffer, const uint32_t i_instance_id );
+        //i_stream has to match the vertex input of the bound pipeline. io_binding is what the command buffer has bound
+        //so far, the arena blocks are only bound again when they change
+        void draw( VkCommandBuffer& i_command_buffer, const uint32_t i_instance_id, const uint32_t i_lod = 0, const VertexStream i_stream = VertexStream::Interleaved, GeometryBinding* io_binding = nullptr );
+
+        //i_draw_count commands of i_buffer from i_offset on, each one draws a range of the arena index block
+        void drawIndirect( VkCommandBuffer& i_command_buffer, VkBuffer i_buffer, const VkDeviceSize i_offset, const uint32_t i_draw_count, const bool i_multi_draw, const VertexStream i_stream = VertexStream::Interleaved,
+                           GeometryBinding* io_binding = nullptr );
+
+        //clusters of lod 0, kept on the cpu to lay out the culled draws
+        inline const std::vector<Meshlet>& getMeshlets() const
+        {
+            return m_meshlets;
+        }
+
+        inline uint32_t getLodCount() const
+        {
+            return m_geometry.m_lod_count;
+        }
+
+        inline const MeshLod& getLod( const uint32_t i_lod ) const
+        {
+            return m_geometry.m_lods[ i_lod ];
+        }
+
+        inline const Vector3f& getBoundsMin() const
+        {
+            return m_geometry.m_bounds_min;
+        }
+
+        inline const Vector3f& getBoundsMax() const
+        {
+            return m_geometry.m_bounds_max;
+        }
+
+        inline VertexFormat getVertexFormat() const
+        {
+            return m_format;
+        }
+
+        inline bool hasPositionStream() const
+        {
+            return m_position_stream;
+        }
+
+        inline VkIndexType getIndexType() const
+        {
+            return m_index_type;
+        }
+
+        //where the ranges of the mesh start in the arena blocks, added to the lod and meshlet ranges by every draw
+        inline uint32_t getFirstIndex() const
+        {
+            return m_allocation.m_first_index;
+        }
+
+        inline int32_t getVertexOffset() const
+        {
+            return static_cast<int32_t>( m_allocation.m_vertex_offset );
+        }
+
+        //written to the per object data of the entities drawing the mesh
+        inline const VertexDequantization& getDequantization() const
+        {
+            return m_dequantization;
+        }
 
         inline VkAccelerationStructureKHR getBLAS()
         {
             return m_blas_structure;
         }
 
+        //the buffers can already be used by anything submitted after the upload batch, this tells when the copies are done
+        bool isUploaded() const;
+
+        //built once the uploads of the scene have been submitted, the build reads the vertex and index buffers
+        void createBLASBuffer();
+
     private:
         MeshVK( const MeshVK& ) = delete;
         MeshVK& operator=(const MeshVK& ) = delete;
 
-        VkBuffer createVertexBuffer( const std::vector<Vertex>& i_data, VkDeviceMemory& i_memory );
-        void createIndexBuffer ();
-        void createBLASBuffer();
+        //packs the stream of the vertices in the format of the mesh into its arena range
+        void uploadVertices( const Vertex* i_data, const uint32_t i_count, const VertexStream i_stream );
+        void uploadIndices ();
 
         const Runtime& m_runtime;
 
         std::string m_path;
 
-        std::vector<uint32_t> m_indices;
-        std::vector<Vertex>   m_vertices;
+        MeshCache::View m_geometry; //counts and bounds, the arrays are cleared once uploaded
+
+        std::vector<Meshlet> m_meshlets;
+
+        VertexFormat         m_format;
+        VertexDequantization m_dequantization;
+        bool                 m_position_stream;
+        VkIndexType          m_index_type;
 
-        VkBuffer                                       m_indices_buffer;
-        VkBuffer                                       m_data_buffer;
-        VkDeviceMemory                                 m_indices_memory;
-        VkDeviceMemory                                 m_data_memory;
+        GeometryArenaVK::Allocation                    m_allocation;
+        uint64_t                                       m_upload_ticket;
 
         VkAccelerationStructureKHR                     m_blas_structure; 
         VkBuffer                                       m_blas_buffer;
-        VkDeviceMemory                                 m_blas_memory;
+        MemoryAllocation                               m_blas_memory;
 
     
     };
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "common.h"
+#include "vertexLayout.h"
+
+namespace MiniEngine
+{
+    struct Runtime;
+    struct Frame;
+    class Entity;
+    struct GeometryBinding;
+
+    //culls the meshlets of every entity against the camera frustum, and optionally their normal cones, in a
+    //compute dispatch that writes one indexed indirect draw per meshlet. a culled meshlet keeps its command
+    //with no instances, so the draws of an entity stay one contiguous range that cached command buffers replay
+    class MeshletCullingVK final
+    {
+    public:
+        explicit MeshletCullingVK( const Runtime& i_runtime );
+        ~MeshletCullingVK() = default;
+
+        bool initialize();
+        void shutdown  ();
+
+        //lays out the meshlets and the commands of the entities, called again when the scene changes
+        void build( const std::vector<std::shared_ptr<Entity>>& i_entities );
+
+        //recorded outside a render pass, the barrier makes the commands visible to later draws on the queue
+        void cull( VkCommandBuffer i_command_buffer, const Frame& i_frame ) const;
+
+        //false when the entity has no culled commands and has to be drawn as a whole
+        bool drawEntity( VkCommandBuffer i_command_buffer, const Frame& i_frame, const Entity& i_entity, const VertexStream i_stream, GeometryBinding* io_binding = nullptr ) const;
+
+        //backfacing clusters are only hidden when the meshes are closed and seen from outside,
+        //the passes draw both faces so this is off by default
+        inline void enableConeCulling( const bool i_enable )
+        {
+            m_cone_culling = i_enable;
+        }
+
+        inline bool isEnabled() const
+        {
+            return m_enabled && m_entry_count > 0;
+        }
+
+    private:
+        MeshletCullingVK( const MeshletCullingVK& ) = delete;
+        MeshletCullingVK& operator=(const MeshletCullingVK& ) = delete;
+
+        struct DrawEntry
+        {
+            uint32_t m_meshlet;
+            uint32_t m_object;
+        };
+
+        struct DrawRange
+        {
+            uint32_t m_first = 0;
+            uint32_t m_count = 0;
+        };
+
+        void createPipeline   ();
+        void createDescriptors();
+        void freeBuffers      ();
+
+        const Runtime& m_runtime;
+
+        bool     m_enabled;       //indirect draws need drawIndirectFirstInstance to pass the object id
+        bool     m_multi_draw;    //one indirect call per entity instead of one per meshlet
+        bool     m_cone_culling;
+        uint32_t m_entry_count;
+
+        VkPipeline                                         m_pipeline;
+        VkPipelineLayout                                   m_pipeline_layout;
+        VkDescriptorSetLayout                              m_descriptor_set_layout;
+        VkDescriptorPool                                   m_descriptor_pool;
+        std::array<VkDescriptorSet, kMAX_NUMBER_OF_FRAMES> m_descriptor_sets;
+
+        VkBuffer         m_meshlet_buffer; //meshlets of every mesh, written once per build
+        MemoryAllocation m_meshlet_memory;
+        VkBuffer         m_entry_buffer;
+        MemoryAllocation m_entry_memory;
+
+        //one per slot, a frame in flight may still draw from the previous one
+        std::array<VkBuffer, kMAX_NUMBER_OF_FRAMES>         m_command_buffers;
+        std::array<MemoryAllocation, kMAX_NUMBER_OF_FRAMES> m_command_memory;
+
+        std::vector<DrawRange> m_draw_ranges; //indexed by entity offset
+    };
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "common.h"
+#include <chrono>
+#include <mutex>
+
+namespace MiniEngine
+{
+    struct Runtime;
+    struct Frame;
+
+    class ProfilerVK final
+    {
+    public:
+        explicit ProfilerVK( const Runtime& i_runtime );
+        ~ProfilerVK() = default;
+
+        bool initialize();
+        void shutdown  ();
+
+        //called once the fence of the frame slot has been waited, resolves the timestamps the slot wrote last time
+        void beginFrame( const Frame& i_frame );
+        //called right after the submit, gpu events of the frame are placed on the cpu timeline from here
+        void endFrame  ( const Frame& i_frame );
+
+        //timestamps around a pass region, the name is also used for the debug marker.
+        //every name keeps the same query pair in a frame slot, so recorded command buffers can be submitted again.
+        //regions recorded for the compute queue pass its family, its timestamps may differ from the graphics ones
+        uint32_t beginRegion( VkCommandBuffer i_cmd_buffer, const Frame& i_frame, const char* i_name, const Vector4f& i_color, const uint32_t i_queue_family = UINT32_MAX );
+        void     endRegion  ( VkCommandBuffer i_cmd_buffer, const Frame& i_frame, const uint32_t i_scope_id );
+
+        //a command buffer holding the region is submitted again without being recorded, read its queries too
+        void     submitRegion( const Frame& i_frame, const uint32_t i_scope_id );
+
+        void addCpuScope( const char* i_name, const double i_start_us, const double i_end_us );
+
+        //chrome://tracing / perfetto json
+        void enableTrace     ( const bool i_enable );
+        bool writeChromeTrace( const std::string& i_path ) const;
+
+        //rolling averages in milliseconds over the last kPROFILER_AVERAGE_WINDOW samples
+        float getGpuAverage( const std::string& i_name ) const;
+        float getCpuAverage( const std::string& i_name ) const;
+        void  printAverages( std::ostream& o_stream ) const;
+
+        double now() const;
+
+        //times the enclosing cpu block
+        class CpuScope final
+        {
+        public:
+            CpuScope( ProfilerVK& i_profiler, const char* i_name ) :
+                m_profiler( i_profiler ),
+                m_name    ( i_name     ),
+                m_start   ( i_profiler.now() )
+            {}
+
+            ~CpuScope()
+            {
+                m_profiler.addCpuScope( m_name, m_start, m_profiler.now() );
+            }
+
+        private:
+            CpuScope( const CpuScope& ) = delete;
+            CpuScope& operator=(const CpuScope& ) = delete;
+
+            ProfilerVK& m_profiler;
+            const char* m_name;
+            double      m_start;
+        };
+
+    private:
+        ProfilerVK( const ProfilerVK& ) = delete;
+        ProfilerVK& operator=(const ProfilerVK& ) = delete;
+
+        struct TraceEvent
+        {
+            std::string m_name;
+            const char* m_category;
+            double      m_start_us;
+            double      m_duration_us;
+            uint32_t    m_thread;
+        };
+
+        struct FrameQueries
+        {
+            std::vector<uint32_t> m_scopes; //scopes submitted since the slot was last resolved
+            double                m_submit_us = 0.0;
+        };
+
+        struct RollingAverage
+        {
+            std::array<float, kPROFILER_AVERAGE_WINDOW> m_samples{};
+            uint32_t                                    m_count = 0;
+            uint32_t                                    m_next  = 0;
+            float                                       m_sum   = 0.0f;
+
+            void  add    ( const float i_sample );
+            float average() const;
+        };
+
+        uint32_t getQuery        ( const Frame& i_frame, const uint32_t i_scope_id ) const;
+        uint64_t getTimestampMask( const uint32_t i_queue_family ) const;
+
+        void addTraceEvent( const std::string& i_name, const char* i_category, const double i_start_us, const double i_duration_us, const uint32_t i_thread );
+
+        const Runtime& m_runtime;
+
+        VkQueryPool                                          m_query_pool;
+        bool                                                 m_gpu_timing;
+        float                                                m_timestamp_period; //ns per tick
+        uint64_t                                             m_graphics_mask;    //valid bits of each queue family, 0 without timestamps
+        uint64_t                                             m_compute_mask;
+        std::array<FrameQueries, kMAX_NUMBER_OF_FRAMES>      m_frames;
+        std::vector<std::string>                             m_scope_names;
+        std::vector<uint64_t>                                m_scope_masks;      //of the queue family the scope is recorded for
+        std::unordered_map<std::string, uint32_t>            m_scope_ids;
+
+        bool                                                 m_trace_enabled;
+        std::vector<TraceEvent>                              m_trace;
+        std::map<std::string, RollingAverage>                m_gpu_averages;
+        std::map<std::string, RollingAverage>                m_cpu_averages;
+        std::chrono::high_resolution_clock::time_point       m_origin;
+
+        mutable std::mutex                                   m_mutex;
+    };
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "common.h"
+
+namespace MiniEngine
+{
+    struct Runtime;
+    struct Frame;
+    class RenderPassVK;
+    class CommandPoolsVK;
+
+    //passes declare the images they read and write by name. compiling orders them, drops the ones whose
+    //results nobody uses, records the barriers between them and lets transient images whose lifetimes do
+    //not overlap share the same memory.
+    //compute passes go to the async compute queue when the device has one. the frame is then split in
+    //submits at every queue change, and a submit that needs the results of the other queue waits on the
+    //semaphore of its latest submit
+    class RenderGraphVK final
+    {
+    public:
+        enum class Access
+        {
+            ColorWrite,     //cleared color attachment
+            DepthWrite,     //cleared depth attachment
+            DepthReadWrite, //depth attachment tested against what a previous pass wrote
+            Sampled,        //read in the fragment shader
+            ComputeSampled, //read in a compute shader
+            StorageWrite,   //written by a compute shader, the previous contents are dropped
+            External        //image synchronized by the pass itself, like the swap chain
+        };
+
+        struct ImageDesc
+        {
+            VkFormat          m_format  = VK_FORMAT_UNDEFINED;
+            VkImageUsageFlags m_usage   = 0;
+            uint32_t          m_width   = 0; //0 follows the window size
+            uint32_t          m_height  = 0;
+            uint32_t          m_layers  = 1;
+            VkSampler         m_sampler = VK_NULL_HANDLE;
+        };
+
+        struct ResourceAccess
+        {
+            std::string m_name;
+            Access      m_access;
+        };
+
+        explicit RenderGraphVK( const Runtime& i_runtime );
+        ~RenderGraphVK() = default;
+
+        //image owned by the graph, the block keeps its address and is filled on compile
+        const ImageBlock& addImage   ( const std::string& i_name, const ImageDesc& i_desc );
+        //image owned outside the graph, it only orders and keeps alive the passes using it
+        void              addExternal( const std::string& i_name );
+
+        void addPass  ( const std::string& i_name, const std::shared_ptr<RenderPassVK>& i_pass, const std::vector<ResourceAccess>& i_accesses );
+        void setOutput( const std::string& i_name );
+
+        void compile ();
+        //recreates the images and the barriers once the window changed size, the passes resize after
+        void resize  ();
+        void shutdown();
+
+        //passes that survived culling, in execution order
+        inline const std::vector<std::shared_ptr<RenderPassVK>>& getPasses() const
+        {
+            return m_passes;
+        }
+
+        //barriers to submit right before the pass, VK_NULL_HANDLE when it needs none
+        inline VkCommandBuffer getBarriers( const size_t i_pass ) const
+        {
+            return m_barriers[ i_pass ];
+        }
+
+        //submits the recorded passes, in the order of getPasses, with their barriers. the last submit of the
+        //frame waits on i_wait_semaphore, signals i_signal_semaphore and i_fence, both semaphores are optional
+        void submit( const Frame& i_frame, const std::vector<VkCommandBuffer>& i_pass_cmds, VkSemaphore i_wait_semaphore, VkSemaphore i_signal_semaphore, VkFence i_fence ) const;
+
+        inline uint32_t getSubmitCount() const
+        {
+            return static_cast<uint32_t>( m_submits.size() );
+        }
+
+        inline uint32_t getCulledPassCount() const
+        {
+            return static_cast<uint32_t>( m_declared_passes.size() - m_passes.size() );
+        }
+
+        //device memory behind the graph images, and what they would take without aliasing
+        inline VkDeviceSize getAllocatedMemory() const
+        {
+            return m_allocated_memory;
+        }
+
+        inline VkDeviceSize getRequiredMemory() const
+        {
+            return m_required_memory;
+        }
+
+    private:
+        RenderGraphVK( const RenderGraphVK& ) = delete;
+        RenderGraphVK& operator=(const RenderGraphVK& ) = delete;
+
+        struct Resource
+        {
+            std::string                 m_name;
+            ImageDesc                   m_desc;
+            bool                        m_external = false;
+            std::unique_ptr<ImageBlock> m_image;
+            bool                        m_sampled  = false;
+            bool                        m_storage  = false;
+            bool                        m_async    = false; //used on the compute queue, never aliased
+            uint32_t                    m_first    = UINT32_MAX; //lifetime in executed passes
+            uint32_t                    m_last     = 0;
+            uint32_t                    m_block    = UINT32_MAX;
+            VkMemoryRequirements        m_requirements{};
+        };
+
+        struct PassAccess
+        {
+            uint32_t m_resource;
+            Access   m_access;
+        };
+
+        struct Pass
+        {
+            std::string                   m_name;
+            std::shared_ptr<RenderPassVK> m_pass;
+            std::vector<PassAccess>       m_accesses;
+            bool                          m_async = false; //runs on the compute queue
+        };
+
+        //consecutive executed passes sharing a queue and a wait
+        struct Submit
+        {
+            bool     m_async  = false;
+            uint32_t m_first  = 0;
+            uint32_t m_count  = 0;
+            uint32_t m_wait   = UINT32_MAX; //submit whose semaphore this one waits on
+            bool     m_signal = false;
+        };
+
+        struct MemoryBlock
+        {
+            MemoryAllocation      m_memory;
+            VkDeviceSize          m_size      = 0;
+            VkDeviceSize          m_alignment = 1;
+            uint32_t              m_type_bits = UINT32_MAX;
+            std::vector<uint32_t> m_resources; //by lifetime
+        };
+
+        uint32_t getResource( const std::string& i_name ) const;
+
+        void sortPasses     ();
+        void cullPasses     ();
+        void assignQueues   ();
+        void createImages   ();
+        void destroyImages  ();
+        void recordBarriers ();
+        void createSubmits  ();
+        void destroySubmits ();
+
+        const Runtime& m_runtime;
+
+        std::vector<Resource>                     m_resources;
+        std::unordered_map<std::string, uint32_t> m_resource_ids;
+        std::vector<uint32_t>                     m_outputs;
+        std::vector<Pass>                         m_declared_passes;
+        std::vector<uint32_t>                     m_order; //declared pass indices that execute
+
+        std::vector<std::shared_ptr<RenderPassVK>> m_passes;
+        std::vector<VkCommandBuffer>               m_barriers;
+        std::vector<bool>                          m_cross_queue; //the pass uses what the other queue did before it
+        std::vector<MemoryBlock>                   m_blocks;
+        std::unique_ptr<CommandPoolsVK>            m_command_pools;
+        std::unique_ptr<CommandPoolsVK>            m_compute_command_pools;
+        bool                                       m_async;
+
+        std::vector<Submit>                                         m_submits;
+        std::array<std::vector<VkSemaphore>, kMAX_NUMBER_OF_FRAMES> m_semaphores; //per submit, set when it signals
+
+        VkDeviceSize m_allocated_memory;
+        VkDeviceSize m_required_memory;
+    };
+};
@@ -1,22 +1,23 @@
 #pragma once
 
 #include "common.h"
+#include "vertexLayout.h"
+#include <functional>
 
 namespace MiniEngine
 {
     struct Runtime;
     class Entity;
     struct Frame;
+    class CommandPoolsVK;
+    struct GeometryBinding;
     typedef std::shared_ptr<Entity> EntityPtr;
 
     class RenderPassVK
     {
     public:
-        RenderPassVK( const Runtime& i_runtime, const std::shared_ptr<RenderPassVK> i_prev_pass = nullptr ) : 
-            m_runtime( i_runtime ),
-            m_prev_render_pass( i_prev_pass )
-        {}
-        virtual ~RenderPassVK() = default;
+        RenderPassVK( const Runtime& i_runtime, const std::shared_ptr<RenderPassVK> i_prev_pass = nullptr );
+        virtual ~RenderPassVK();
 
         virtual bool            initialize() = 0;
         virtual void            shutdown  () = 0;
@@ -26,12 +27,79 @@ namespace MiniEngine
         {
         }
 
+        //the window sized attachments and swap chain images were rebuilt in place, passes recreate what points at them
+        virtual void resize();
+
+        //drops the recorded command buffers, the next draw of every key records again
+        void invalidate();
+
+        //compute passes only dispatch, so the render graph may run them on the async compute queue
+        virtual bool isCompute() const
+        {
+            return false;
+        }
+
+        //levels of detail the entities of the pass are drawn with
+        inline LodView getLodView() const
+        {
+            return m_lod_view;
+        }
+
+        //family of the queue the graph submits the pass to, set before initialize
+        void setQueueFamilyIndex( const uint32_t i_queue_family_index );
+
     protected:
+        //recorded command buffers are kept per key and submitted again until invalidated. offscreen passes
+        //key by frame slot, passes writing the swap chain also need the image in the key
+        void initializeCommandBuffers( const uint32_t i_key_count );
+        void shutdownCommandBuffers  ();
+
+        //the buffer recorded for the key, or VK_NULL_HANDLE when it has to be recorded again
+        VkCommandBuffer getCachedCommandBuffer( const Frame& i_frame, const uint32_t i_key );
+        //a primary buffer to record the key into, the previous recording of the key is recycled
+        VkCommandBuffer allocateCommandBuffer ( const uint32_t i_key );
+        //keeps the recorded buffer and the profiler region it contains
+        void            cacheCommandBuffer    ( const uint32_t i_key, VkCommandBuffer i_cmd_buffer, const uint32_t i_profiler_scope );
+
+        //true when the entities are better split in secondary command buffers, which needs workers to record them
+        //and enough entities to fill more than one chunk. the render pass must then begin with secondary contents
+        bool useSecondaryCommandBuffers( const size_t i_entity_count ) const;
+
+        //binds the state and draws the entities, inline when i_inheritance is null, otherwise in chunks of
+        //kENTITIES_PER_SECONDARY_BUFFER recorded as secondary command buffers on the worker threads.
+        //i_bind_state runs once per command buffer since secondaries do not inherit bound state
+        void drawEntities( 
+            VkCommandBuffer                              i_cmd_buffer, 
+            const Frame&                                 i_frame, 
+            const uint32_t                               i_key,
+            const char*                                  i_region_name,
+            const std::vector<EntityPtr>&                i_entities,
+            const VkCommandBufferInheritanceInfo*        i_inheritance,
+            const std::function<void( VkCommandBuffer )>& i_bind_state ) const;
+
+        //pipelines leave viewport and scissor dynamic, so a resize does not rebuild them
+        static void setViewportAndScissor( VkCommandBuffer i_cmd_buffer, const VkExtent2D& i_extent );
+
         const Runtime& m_runtime;
         const std::shared_ptr<RenderPassVK> m_prev_render_pass;
+        LodView        m_lod_view;
+        bool           m_meshlet_draws; //full detail entities draw the meshlets left by the culling of the frame
+        VertexStream   m_vertex_stream; //the vertex buffers the pipelines of the pass read
 
     private:
         RenderPassVK( const RenderPassVK& ) = delete;
         RenderPassVK& operator=(const RenderPassVK& ) = delete;
+
+        struct CachedCommandBuffer
+        {
+            VkCommandBuffer m_cmd_buffer     = VK_NULL_HANDLE;
+            uint32_t        m_profiler_scope = UINT32_MAX;
+        };
+
+        void drawEntity( VkCommandBuffer i_cmd_buffer, const Frame& i_frame, Entity& i_entity, GeometryBinding& io_binding ) const;
+
+        std::unique_ptr<CommandPoolsVK>  m_command_pools;
+        std::vector<CachedCommandBuffer> m_cached_command_buffers;
+        uint32_t                         m_queue_family_index; //UINT32_MAX for the graphics family
     };
-};
\ No newline at end of file
+};
@@ -16,7 +16,7 @@ namespace MiniEngine
         {}
         ~RendererVK() = default;
 
-        bool initialize();
+        bool initialize( const bool i_headless = false );
         void shutdown  ();
 
         VkInstance getInstance() const
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vulkan/renderPassVK.h"
+#include "vertexLayout.h"
 
 namespace MiniEngine
 
@@ -21,6 +22,7 @@ namespace MiniEngine
 		bool initialize() override;
 		void shutdown() override;
 		VkCommandBuffer draw(const Frame& i_frame) override;
+		void resize() override;
 
 		void addEntityToDraw(const EntityPtr i_entity) override;
 
@@ -42,10 +44,10 @@ namespace MiniEngine
 
 		struct MaterialPipeline
 		{
-			VkPipeline m_pipeline;
+			std::array<VkPipeline, kVERTEX_FORMAT_COUNT> m_pipeline; //one per vertex format
 			VkPipelineLayout m_pipeline_layouts;
 			std::array<VkDescriptorSetLayout, 2> m_descriptor_set_layout;
-			std::array<DescriptorSets, 3> m_descriptor_sets;
+			std::array<DescriptorSets, kMAX_NUMBER_OF_FRAMES> m_descriptor_sets;
 			std::array<VkPipelineShaderStageCreateInfo, 2> m_shader_stages;
 
 		};
@@ -53,13 +55,12 @@ namespace MiniEngine
 		std::array<MaterialPipeline, 2> m_pipelines;
 
 		VkRenderPass m_render_pass;
-		std::array<VkCommandBuffer, 3> m_command_buffer;
-		std::array<VkFramebuffer, 3> m_fbos;
+		std::array<VkFramebuffer, kMAX_NUMBER_OF_FRAMES> m_fbos;
 		VkDescriptorPool m_descriptor_pool;
 
 		std::unordered_map<uint32_t, std::vector<EntityPtr>> m_entities_to_draw;
 
-		const ImageBlock m_shadow_output;
+		const ImageBlock& m_shadow_output; //owned by the render graph
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "common.h"
+#include <mutex>
+
+namespace MiniEngine
+{
+    class DeviceVK;
+
+    //records the copies into device local resources in batches that share one command buffer and one fence.
+    //the data goes through a persistently mapped staging ring, so nothing waits for the gpu while the
+    //ring has room. batches run on the transfer queue of the device; with a dedicated transfer family every
+    //batch releases its resources to the graphics family and a small graphics submit acquires them, waiting
+    //on the copies with a semaphore. either way work submitted to the graphics queue after a batch sees the
+    //data without waiting for its ticket.
+    //the destinations are expected to be fresh resources, an ownership change does not keep what the
+    //graphics queue wrote to them before
+    class UploadManagerVK final
+    {
+    public:
+        explicit UploadManagerVK( const DeviceVK& i_device );
+        ~UploadManagerVK() = default;
+
+        void initialize();
+        void shutdown  ();
+
+        //the returned ticket completes once the copy is done on the gpu
+        uint64_t uploadBuffer( VkBuffer i_dst_buffer, const void* i_data, const VkDeviceSize i_size, const VkDeviceSize i_dst_offset = 0 );
+        //transitions the whole image from undefined, copies the first mip and leaves it in i_final_layout
+        uint64_t uploadImage ( VkImage i_dst_image, const void* i_data, const VkDeviceSize i_size, const uint32_t i_width, const uint32_t i_height, const VkImageLayout i_final_layout );
+
+        //submits the batch being recorded and returns its ticket
+        uint64_t flush     ();
+        bool     isComplete( const uint64_t i_ticket );
+        void     wait      ( const uint64_t i_ticket );
+
+    private:
+        UploadManagerVK( const UploadManagerVK& ) = delete;
+        UploadManagerVK& operator=(const UploadManagerVK& ) = delete;
+
+        struct Batch
+        {
+            VkCommandBuffer                                     m_command_buffer         = VK_NULL_HANDLE;
+            VkCommandBuffer                                     m_acquire_command_buffer = VK_NULL_HANDLE; //graphics side of the ownership transfers
+            VkSemaphore                                         m_semaphore              = VK_NULL_HANDLE; //copies done, the acquire may start
+            VkFence                                             m_fence                  = VK_NULL_HANDLE; //signaled by the last submit of the batch
+            uint64_t                                            m_ring_end               = 0; //ring position to release once the fence signals
+            VkDeviceSize                                        m_bytes                  = 0;
+            std::vector<std::pair<VkBuffer, MemoryAllocation>> m_oversized;                  //staging for copies larger than the ring
+            std::vector<VkBufferMemoryBarrier>                  m_buffer_releases;
+            std::vector<VkImageMemoryBarrier>                   m_image_releases;
+        };
+
+        //staging range for the copy of the batch being recorded, opens the batch if needed
+        VkBuffer stage              ( const void* i_data, const VkDeviceSize i_size, VkDeviceSize& o_offset );
+        Batch&   getRecordingBatch  ();
+        //accounts a recorded copy, big batches are submitted right away so the gpu starts on them
+        uint64_t recordCopy         ( const VkDeviceSize i_size );
+        void     retire             ( const uint64_t i_ticket, const bool i_wait );
+        void     submit             ();
+        //hands the resources of the batch to the graphics family, its fence signals after the acquire
+        void     submitWithTransfers( Batch& io_batch );
+
+        const DeviceVK&                          m_device;
+
+        VkCommandPool                            m_command_pool;         //transfer family
+        VkCommandPool                            m_acquire_command_pool; //graphics family, only with a dedicated transfer queue
+        std::array<Batch, kUPLOAD_BATCHES>       m_batches;     //a ticket records into m_batches[ ticket % kUPLOAD_BATCHES ]
+        uint64_t                                 m_recording;   //ticket being recorded, 0 when there is none
+        uint64_t                                 m_submitted;
+        uint64_t                                 m_completed;
+
+        VkBuffer                                 m_ring_buffer;
+        MemoryAllocation                         m_ring_memory;
+        VkDeviceSize                             m_ring_alignment;
+        uint64_t                                 m_ring_head;   //both grow without wrapping, the ring offset is the value modulo its size
+        uint64_t                                 m_ring_tail;
+
+        std::mutex                               m_mutex;
+    };
+};
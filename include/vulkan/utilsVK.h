@@ -25,7 +25,10 @@ namespace MiniEngine
 
         VkShaderModule loadShader( const std::string i_filename, const VkDevice i_device );
 
-        void createBuffer( const DeviceVK& i_device, VkDeviceSize i_size, VkBufferUsageFlags i_usage, VkMemoryPropertyFlags i_properties, VkBuffer& o_buffer, VkDeviceMemory& o_buffer_memory );
+        //i_compute_shared lets the async compute queue read the buffer without ownership transfers
+        void createBuffer( const DeviceVK& i_device, VkDeviceSize i_size, VkBufferUsageFlags i_usage, VkMemoryPropertyFlags i_properties, VkBuffer& o_buffer, MemoryAllocation& o_buffer_memory, const bool i_compute_shared = false );
+
+        void freeBuffer( const DeviceVK& i_device, VkBuffer& io_buffer, MemoryAllocation& io_buffer_memory );
 
         void copyBuffer( const DeviceVK& i_device, VkBuffer i_src_buffer, VkBuffer i_dst_buffer, VkDeviceSize i_size );
         
@@ -42,11 +45,14 @@ namespace MiniEngine
         VkCommandBuffer initOneTimeCommandBuffer( const DeviceVK& device );
         void            endOneTimeCommandBuffer ( const DeviceVK& device, VkCommandBuffer io_command_buffer );
         
-        void createBLAS( const DeviceVK &i_device, VkBuffer i_vertex_buffer, VkBuffer i_index_buffer, const std::vector<Vertex>& m_vertices, 
-            const std::vector<uint32_t>& i_indices, VkAccelerationStructureKHR& o_blas, VkBuffer& o_buffer, VkDeviceMemory& o_memory );
+        //the positions are read with i_vertex_format at i_vertex_stride, i_transform_buffer optionally holds a
+        //VkTransformMatrixKHR applied to them during the build
+        void createBLAS( const DeviceVK &i_device, VkBuffer i_vertex_buffer, const VkDeviceSize i_vertex_offset, VkBuffer i_index_buffer, const VkDeviceSize i_index_offset, const VkIndexType i_index_type, const uint32_t i_vertex_count, 
+            const uint32_t i_index_count, const VkFormat i_vertex_format, const uint32_t i_vertex_stride, VkBuffer i_transform_buffer,
+            VkAccelerationStructureKHR& o_blas, VkBuffer& o_buffer, MemoryAllocation& o_memory );
 
         void createTLAS( const DeviceVK &i_device, std::vector<Matrix4f>& i_transforms, std::vector<VkAccelerationStructureKHR>& i_blas_instances,
-             VkAccelerationStructureKHR& o_tlas, VkBuffer& o_buffer, VkDeviceMemory& o_memory );
+             VkAccelerationStructureKHR& o_tlas, VkBuffer& o_buffer, MemoryAllocation& o_memory );
 
         uint64_t get_device_address( VkDevice i_device, VkBuffer i_buffer );
     };
@@ -9,7 +9,7 @@ namespace MiniEngine
     class WindowVK final
     {
     public:
-        WindowVK( const RendererVK& i_renderer, const std::string& i_name, const uint32_t i_width, const uint32_t i_height );
+        WindowVK( const RendererVK& i_renderer, const std::string& i_name, const uint32_t i_width, const uint32_t i_height, const bool i_headless = false );
         ~WindowVK() = default;
 
         uint32 prepareFrame( VkSemaphore i_presentation_semaphore );
@@ -30,11 +30,23 @@ namespace MiniEngine
             return m_color_space;
         }
 
-        std::array<ImageBlock, 3> getSwapChainImages() const
+        const std::vector<ImageBlock>& getSwapChainImages() const
         {
             return m_swap_chain_images;
         }
 
+        //layout the final pass leaves the output image in
+        VkImageLayout getOutputLayout() const
+        {
+            return m_headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        }
+
+        //no glfw window, surface or swap chain, frames are rendered to a ring of offscreen images
+        bool isHeadless() const
+        {
+            return m_headless;
+        }
+
         VkFormat getDepthFormat() const
         {
             return m_depth_format;
@@ -71,6 +83,9 @@ namespace MiniEngine
         void destroySwapChain   ();
         void destroySurface     ();
 
+        void createOffscreenImages ();
+        void destroyOffscreenImages();
+
         bool loop   ();
         void wait   ();
         void resize ();
@@ -91,10 +106,11 @@ namespace MiniEngine
         VkColorSpaceKHR                              m_color_space;
         uint32_t                                     m_image_count;
         uint32_t                                     m_image_index;
-        std::array<ImageBlock,                    3> m_swap_chain_images;
+        std::vector<ImageBlock>                      m_swap_chain_images;
         uint32_t                                     m_queue_node_index = 0xFFFFFFFF;
         bool                                         m_prepared;
         bool                                         m_fullscreen;
+        bool                                         m_headless;
         
         //window
         GLFWwindow*      m_window;
@@ -3,12 +3,58 @@
 
 using namespace MiniEngine;
 
+// usage: Practica5 <scene.xml> [--headless] [--frames-in-flight N] [--frames N] [--profile trace.json] [--threads N] [--lod-error PIXELS] [--cone-culling] [--no-position-streams]
 int main( int argc, char* argv[] )
 {
     
-    if( argc == 2 )
+    if( argc >= 2 )
     {
-        Engine::instance().initialize();
+        bool headless = false;
+
+        for( int idx = 2; idx < argc; idx++ )
+        {
+            const std::string option( argv[ idx ] );
+
+            if( option == "--headless" )
+            {
+                headless = true;
+            }
+            else if( option == "--frames-in-flight" && idx + 1 < argc )
+            {
+                Engine::instance().setFramesInFlight( static_cast<uint32_t>( std::stoul( argv[ ++idx ] ) ) );
+            }
+            else if( option == "--frames" && idx + 1 < argc )
+            {
+                Engine::instance().setFrameLimit( static_cast<uint32_t>( std::stoul( argv[ ++idx ] ) ) );
+            }
+            else if( option == "--profile" && idx + 1 < argc )
+            {
+                Engine::instance().setTraceFile( argv[ ++idx ] );
+            }
+            else if( option == "--threads" && idx + 1 < argc )
+            {
+                Engine::instance().setWorkerThreads( static_cast<uint32_t>( std::stoul( argv[ ++idx ] ) ) );
+            }
+            else if( option == "--lod-error" && idx + 1 < argc )
+            {
+                Engine::instance().setLodErrorThreshold( std::stof( argv[ ++idx ] ) );
+            }
+            else if( option == "--cone-culling" )
+            {
+                Engine::instance().setMeshletConeCulling( true );
+            }
+            else if( option == "--no-position-streams" )
+            {
+                Engine::instance().setPositionStreams( false );
+            }
+            else
+            {
+                std::cerr << "Unknown option " << option << std::endl;
+                return 1;
+            }
+        }
+
+        Engine::instance().initialize( headless );
         Engine::instance().loadScene( std::string(argv[1] ) );
         Engine::instance().run       ();
         Engine::instance().shutdown  ();
@@ -1,8 +1,12 @@
 C:\VulkanSDK\1.4.309.0\Bin\glslc.exe vert.vert -o vert.spv
+C:\VulkanSDK\1.4.309.0\Bin\glslc.exe depth_v.vert -o depth_v.spv
 C:\VulkanSDK\1.4.309.0\Bin\glslc.exe diffuse.frag -o diffuse.spv
 C:\VulkanSDK\1.4.309.0\Bin\glslc.exe composition_v.vert -o composition_v.spv
-C:\VulkanSDK\1.4.309.0\Bin\glslc.exe composition_f.frag -o composition_f.spv
+C:\VulkanSDK\1.4.309.0\Bin\glslc.exe -DRTX composition_f.frag -o composition_f.spv
+C:\VulkanSDK\1.4.309.0\Bin\glslc.exe composition_f.frag -o composition_f_raster.spv
 C:\VulkanSDK\1.4.309.0\Bin\glslc.exe microfacets.frag -o microfacets.spv
 C:\VulkanSDK\1.4.309.0\Bin\glslc.exe shadows_g.geom -o shadows_g.spv
-C:\VulkanSDK\1.4.309.0\Bin\glslc.exe shadows_v.vert -o shadows_v.spv
+C:\VulkanSDK\1.4.309.0\Bin\glslc.exe ssao.comp -o ssao_c.spv
+C:\VulkanSDK\1.4.309.0\Bin\glslc.exe blur.comp -o blur_c.spv
+C:\VulkanSDK\1.4.309.0\Bin\glslc.exe meshlet_cull.comp -o meshlet_cull_c.spv
 pause
@@ -1,10 +1,12 @@
 #version 460
 
+//compiled with -DRTX for the devices with ray queries, without it the TLAS and the traced visibility are left out
+#ifdef RTX
 #extension GL_EXT_ray_query : enable
+#endif
 #extension GL_ARB_shader_draw_parameters : enable
 #define INV_PI 0.31830988618
 #define PI   3.14159265358979323846264338327950288
-#define RTX
 
 layout( location = 0 ) in vec2 f_uvs;
 
@@ -37,7 +39,10 @@ layout ( set = 0, binding = 2 ) uniform sampler2D i_position_and_depth;
 layout ( set = 0, binding = 3 ) uniform sampler2D i_normal;
 layout ( set = 0, binding = 4 ) uniform sampler2D i_material;
 layout ( set = 0, binding = 5 ) uniform sampler2DArray i_shadow_maps;
+#ifdef RTX
 layout(set = 0, binding = 6) uniform accelerationStructureEXT TLAS;
+#endif
+layout ( set = 0, binding = 7 ) uniform sampler2D i_ambient_occlusion;
 
 layout(location = 0) out vec4 out_color;
 
@@ -64,6 +69,7 @@ vec3 sampleDirectionInCone(vec3 coneDirection, float coneAngle, uint seed) {
     return normalize(tangent * direction.x + bitangent * direction.y + coneDirection * direction.z);
 }
 
+#ifdef RTX
 //Ray Tracing defines
 #define NUM_SOFT_SHADOW_RAYS 16
 #define LIGHT_RADIUS 0.5   
@@ -156,6 +162,7 @@ float evalVisibility(vec3 frag_pos, vec3 normal, vec3 light_dir) {
 
     return hit ? 0.0 : 1.0;
 }
+#endif
 
 // Shadow Mapping Visibility Evaluation
 float evalVisibility(vec3 frag_pos, uint id_light, vec3 normal) {
@@ -231,7 +238,7 @@ vec3 evalDiffuse()
             }
             case 2: //ambient
             {
-                shading += light.m_radiance.rgb * albedo.rgb;
+                shading += light.m_radiance.rgb * albedo.rgb * texture( i_ambient_occlusion, f_uvs ).r;
                 break;
             }
         }
@@ -290,7 +297,7 @@ vec3 evalMicrofacets()
                 radiance = light.m_radiance.rgb * att;
                 break;
             case 2: // ambient
-                shading += light.m_radiance.rgb * albedo.rgb;
+                shading += light.m_radiance.rgb * albedo.rgb * texture( i_ambient_occlusion, f_uvs ).r;
                 continue; // Skip BRDF calculation for ambient
         }
         
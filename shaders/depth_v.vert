@@ -2,10 +2,8 @@
 
 #extension GL_ARB_shader_draw_parameters : enable
 
-//inputs
+//inputs, the position stream or the first attribute of the interleaved one
 layout( location = 0 ) in vec3 v_positions;
-layout( location = 1 ) in vec3 v_normals;
-layout( location = 2 ) in vec2 v_uvs;
 
 //globals
 struct LightData
@@ -35,6 +33,8 @@ struct ObjectData
     mat4 m_model;
     vec4 m_albedo; 
     vec4 m_metallic_roughness;
+    vec4 m_dequantize_scale;
+    vec4 m_dequantize_offset;
 };
 
 //all object matrices
@@ -44,25 +44,20 @@ layout(std140,set = 1, binding = 0) readonly buffer ObjectBufferData
 } per_object_data;
 
 
+//world position, what the shadow geometry shader projects to every light
 layout( location = 0 ) out vec3 f_position;
-layout( location = 1 ) out vec3 f_normal;
-layout( location = 2 ) out vec2 f_uv;
-layout( location = 3 ) out flat int f_instance;
 
-void main() {
-    //pos in view space
-    vec4 pos = per_object_data.objects[ gl_BaseInstance ].m_model * vec4(v_positions, 1.0);
-    f_position = pos.xyz;
+//the gbuffer pass tests against this depth with vert.vert, both compute it the same way
+invariant gl_Position;
 
-    //normal in view space
-    mat3 normal_matrix = transpose( inverse( mat3( per_frame_data.m_view * per_object_data.objects[ gl_BaseInstance ].m_model ) ) );
-    f_normal = normal_matrix * v_normals;
+void main() {
+    ObjectData object = per_object_data.objects[ gl_BaseInstance ];
 
-    // uv
-    f_uv = v_uvs;
+    //quantized formats store the positions within the mesh bounds
+    vec3 position = v_positions * object.m_dequantize_scale.xyz + object.m_dequantize_offset.xyz;
 
-    //progate the id
-    f_instance = gl_BaseInstance;
+    vec4 pos = object.m_model * vec4(position, 1.0);
+    f_position = pos.xyz;
 
     gl_Position = per_frame_data.m_projection * per_frame_data.m_view * pos;
-}
\ No newline at end of file
+}
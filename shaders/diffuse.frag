@@ -37,6 +37,8 @@ struct ObjectData
     mat4 m_model;
     vec4 m_albedo; 
     vec4 m_metallic_roughness;
+    vec4 m_dequantize_scale;
+    vec4 m_dequantize_offset;
 };
 
 //all object matrices
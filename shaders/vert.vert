@@ -35,6 +35,8 @@ struct ObjectData
     mat4 m_model;
     vec4 m_albedo; 
     vec4 m_metallic_roughness;
+    vec4 m_dequantize_scale;
+    vec4 m_dequantize_offset;
 };
 
 //all object matrices
@@ -49,14 +51,37 @@ layout( location = 1 ) out vec3 f_normal;
 layout( location = 2 ) out vec2 f_uv;
 layout( location = 3 ) out flat int f_instance;
 
+//the depth prepass computes the same position in depth_v.vert
+invariant gl_Position;
+
+//the w of the scale tells the normals were folded onto the octahedron
+vec3 decodeNormal( vec3 i_normal, float i_octahedral )
+{
+    if( i_octahedral == 0.0 )
+    {
+        return i_normal;
+    }
+
+    vec3  normal = vec3( i_normal.xy, 1.0 - abs( i_normal.x ) - abs( i_normal.y ) );
+    float fold   = max( -normal.z, 0.0 );
+    normal.xy   += vec2( normal.x >= 0.0 ? -fold : fold, normal.y >= 0.0 ? -fold : fold );
+
+    return normalize( normal );
+}
+
 void main() {
+    ObjectData object = per_object_data.objects[ gl_BaseInstance ];
+
+    //quantized formats store the positions within the mesh bounds
+    vec3 position = v_positions * object.m_dequantize_scale.xyz + object.m_dequantize_offset.xyz;
+
     //pos in view space
-    vec4 pos = per_object_data.objects[ gl_BaseInstance ].m_model * vec4(v_positions, 1.0);
+    vec4 pos = object.m_model * vec4(position, 1.0);
     f_position = pos.xyz;
 
     //normal in view space
     mat3 normal_matrix = transpose( inverse( mat3( per_frame_data.m_view * per_object_data.objects[ gl_BaseInstance ].m_model ) ) );
-    f_normal = normal_matrix * v_normals;
+    f_normal = normal_matrix * decodeNormal( v_normals, object.m_dequantize_scale.w );
 
     // uv
     f_uv = v_uvs;
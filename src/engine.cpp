@@ -11,6 +11,7 @@
 #include "material.h"
 #include "diffuse.h"
 #include "microfacets.h"
+#include "threadPool.h"
 
 
 // vulkan includes
@@ -20,10 +21,19 @@
 #include "vulkan/deferredPassVK.h"
 #include "vulkan/shadowsPassVK.h"
 #include "vulkan/compositionPassVK.h"
+#include "vulkan/SSAOComputePassVK.h"
+#include "vulkan/blurComputePassVK.h"
 #include "vulkan/windowVK.h"
 #include "vulkan/deviceVK.h"
 #include "vulkan/utilsVK.h"
 #include "vulkan/meshVK.h"
+#include "vulkan/profilerVK.h"
+#include "vulkan/commandPoolsVK.h"
+#include "vulkan/renderGraphVK.h"
+#include "vulkan/memoryAllocatorVK.h"
+#include "vulkan/uploadManagerVK.h"
+#include "vulkan/meshletCullingVK.h"
+#include "vulkan/geometryArenaVK.h"
 
 
 
@@ -34,6 +44,39 @@ using namespace MiniEngine;
 namespace
 {
     Engine* m_instance = nullptr;
+
+    //screen pixels one object space unit covers at the point of the bounding sphere closest to the view.
+    //w grows with the distance for a perspective projection and stays 1 for an orthographic one
+    float getPixelsPerUnit( const Matrix4f& i_view_projection, const float i_resolution, const Vector3f& i_center, const float i_radius )
+    {
+        const Vector3f row_x( i_view_projection[ 0 ][ 0 ], i_view_projection[ 1 ][ 0 ], i_view_projection[ 2 ][ 0 ] );
+        const Vector3f row_y( i_view_projection[ 0 ][ 1 ], i_view_projection[ 1 ][ 1 ], i_view_projection[ 2 ][ 1 ] );
+        const Vector3f row_w( i_view_projection[ 0 ][ 3 ], i_view_projection[ 1 ][ 3 ], i_view_projection[ 2 ][ 3 ] );
+
+        const float w = ( i_view_projection * Vector4f( i_center, 1.0f ) ).w - i_radius * glm::length( row_w );
+
+        //the sphere reaches the eye, only the full mesh is safe
+        if( w <= kEPSILON )
+        {
+            return kINFINITY;
+        }
+
+        return std::max( glm::length( row_x ), glm::length( row_y ) ) / w * i_resolution * 0.5f;
+    }
+
+    //coarsest level whose error stays under the threshold
+    uint32_t selectLod( const MeshVK& i_mesh, const float i_pixels_per_unit, const float i_threshold )
+    {
+        for( uint32_t lod = i_mesh.getLodCount() - 1; lod > 0; lod-- )
+        {
+            if( i_mesh.getLod( lod ).m_error * i_pixels_per_unit <= i_threshold )
+            {
+                return lod;
+            }
+        }
+
+        return 0;
+    }
 }
 
 
@@ -49,9 +92,15 @@ Engine& Engine::instance()
 
 
 Engine::Engine() : 
-    m_current_frame( 0     ),
-    m_close        ( false ),
-    m_resize       ( false )
+    m_current_frame   ( 0                         ),
+    m_frames_in_flight( kDEFAULT_FRAMES_IN_FLIGHT ),
+    m_frame_limit     ( 0                         ),
+    m_worker_threads  ( std::min( std::max( std::thread::hardware_concurrency(), 1u ) - 1, kMAX_WORKER_THREADS ) ),
+    m_lod_error_threshold( kDEFAULT_LOD_ERROR_PIXELS ),
+    m_meshlet_cone_culling( false ),
+    m_position_streams( true ),
+    m_close           ( false                     ),
+    m_resize          ( false                     )
 {
 
 }
@@ -63,20 +112,37 @@ Engine::~Engine()
 }
 
 
-bool Engine::initialize()
+bool Engine::initialize( const bool i_headless )
 {
     //init vulkan 
     m_runtime.m_renderer = std::make_unique<RendererVK>();
     RendererVK& renderer = *m_runtime.m_renderer;
 
-    renderer.initialize();
+    renderer.initialize( i_headless );
+
+    //the meshes take their ranges from it as they load
+    m_runtime.m_geometry_arena = std::make_unique<GeometryArenaVK>( m_runtime );
+    m_runtime.m_geometry_arena->initialize();
 
     m_runtime.m_mesh_registry   = std::make_unique<MeshRegistry  >( m_runtime );
     m_runtime.m_shader_registry = std::make_unique<ShaderRegistry>( m_runtime );
 
     m_runtime.m_mesh_registry->initialize();
+    m_runtime.m_mesh_registry->enablePositionStreams( m_position_streams );
     m_runtime.m_shader_registry->initialize();
 
+    m_runtime.m_profiler = std::make_unique<ProfilerVK>( m_runtime );
+    m_runtime.m_profiler->initialize();
+    m_runtime.m_profiler->enableTrace( !m_trace_file.empty() );
+
+    m_runtime.m_thread_pool   = std::make_unique<ThreadPool    >( m_worker_threads );
+    m_runtime.m_command_pools = std::make_unique<CommandPoolsVK>( m_runtime, m_runtime.m_thread_pool->getThreadCount(), kMAX_NUMBER_OF_FRAMES, true, m_runtime.m_renderer->getDevice()->getGraphicsQueueFamilyIndex() );
+    m_runtime.m_command_pools->initialize();
+
+    m_runtime.m_meshlet_culling = std::make_unique<MeshletCullingVK>( m_runtime );
+    m_runtime.m_meshlet_culling->initialize();
+    m_runtime.m_meshlet_culling->enableConeCulling( m_meshlet_cone_culling );
+
     createSyncObjects ();
     
     return true;
@@ -86,73 +152,105 @@ bool Engine::initialize()
 void Engine::run()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
+    ProfilerVK& profiler = *m_runtime.m_profiler;
+
+    //headless frames are not presented, so there is no acquire/present semaphore to wait on or signal
+    const bool present = !renderer.getWindow().isHeadless();
+
+    uint32_t rendered_frames = 0;
 
     bool loop = true;
-    while( loop && m_scene ) 
+    while( loop && m_scene && ( m_frame_limit == 0 || rendered_frames < m_frame_limit ) ) 
     {
-        uint32_t clamped_idx = m_current_frame % 3;
-        renderer.getWindow().prepareFrame( m_frame_semaphore[ clamped_idx ].m_presentation_semaphore );
-        
-        vkWaitForFences( renderer.getDevice()->getLogicalDevice(), 1, &m_frame_fence[ clamped_idx ], VK_TRUE, 1000000000 );
-        
+        const uint32_t frame_idx = m_current_frame % m_frames_in_flight;
+
+        //wait till the gpu retires the last frame that used this slot, the only cpu/gpu sync point of the frame
+        {
+            ProfilerVK::CpuScope scope( profiler, "Fence Wait" );
+            vkWaitForFences( renderer.getDevice()->getLogicalDevice(), 1, &m_frame_fence[ frame_idx ], VK_TRUE, UINT64_MAX );
+        }
+
+        uint32_t result;
+        {
+            ProfilerVK::CpuScope scope( profiler, "Acquire" );
+            result = renderer.getWindow().prepareFrame( m_frame_semaphore[ frame_idx ].m_presentation_semaphore );
+        }
+
+        if( result == VK_ERROR_OUT_OF_DATE_KHR )
+        {
+            recreateSwapChain();
+            loop = renderer.getWindow().loop();
+            continue;
+        }
+
+        //passes pick command buffers, descriptors and uniforms by frame slot, only the output fbo depends on the image
+        Frame frame;
+        frame.m_frame_index = frame_idx;
+        frame.m_image_index = renderer.getWindow().getCurrentImageId();
+
+        //the slot fence is signaled, its timestamps from the last use can be read without stalling
+        profiler.beginFrame( frame );
+        m_runtime.m_command_pools->reset( frame.m_frame_index );
+
         //update global uniforms buffers 
-        updateGlobalBuffers(); 
-
-        //prepare pipeline stages
-        VkSubmitInfo submit_info{};
-        VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-
-        submit_info.sType                   = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit_info.pNext                   = nullptr;
-        submit_info.pWaitDstStageMask       = &wait_stage;
-        submit_info.waitSemaphoreCount      = 1;
-        submit_info.pWaitSemaphores         = &m_frame_semaphore[ clamped_idx ].m_presentation_semaphore;
-        submit_info.signalSemaphoreCount    = 1;
-        submit_info.pSignalSemaphores       = &m_frame_semaphore[ clamped_idx ].m_render_semaphore;
-
-        // draw render passes
-        std::vector<VkCommandBuffer> cmds;
-        for( auto& pass : m_render_passes )
         {
-            cmds.push_back( pass->draw( {} ) );
+            ProfilerVK::CpuScope scope( profiler, "Update Global Buffers" );
+            updateGlobalBuffers( frame ); 
         }
 
-        submit_info.commandBufferCount = static_cast<uint32_t>(cmds.size());
-        submit_info.pCommandBuffers    = cmds.data();
+        //before recording, a changed level has to reach the cached command buffers of this frame
+        {
+            ProfilerVK::CpuScope scope( profiler, "Select LODs" );
+            updateLods();
+        }
 
-        vkResetFences  ( renderer.getDevice()->getLogicalDevice(), 1, &m_frame_fence[ clamped_idx ] );
+        // draw render passes, recorded in parallel and submitted in pass order
+        std::vector<VkCommandBuffer> cmds( m_render_passes.size() );
+        {
+            ProfilerVK::CpuScope scope( profiler, "Record Passes" );
 
-        vkQueueSubmit( renderer.getDevice()->getGraphicsQueue(), 1, &submit_info, m_frame_fence[ clamped_idx ] );
+            std::vector<ThreadPool::Job> jobs;
+            jobs.reserve( m_render_passes.size() );
 
-        uint32_t result = renderer.getWindow().renderFrame( m_frame_semaphore[ clamped_idx ].m_render_semaphore );
-        
-        vkQueueWaitIdle( renderer.getDevice()->getGraphicsQueue() );
+            for( size_t idx = 0; idx < m_render_passes.size(); idx++ )
+            {
+                jobs.push_back( [ this, &cmds, &frame, idx ]() { cmds[ idx ] = m_render_passes[ idx ]->draw( frame ); } );
+            }
+
+            m_runtime.m_thread_pool->run( jobs );
+        }
+
+        vkResetFences  ( renderer.getDevice()->getLogicalDevice(), 1, &m_frame_fence[ frame_idx ] );
+
+        //uploads recorded since the last frame have to reach the queue before the frame reading them
+        renderer.getDevice()->getUploadManager().flush();
+
+        {
+            ProfilerVK::CpuScope scope( profiler, "Submit" );
+            m_render_graph->submit( frame, cmds,
+                                    present ? m_frame_semaphore[ frame_idx ].m_presentation_semaphore : VK_NULL_HANDLE,
+                                    present ? m_frame_semaphore[ frame_idx ].m_render_semaphore       : VK_NULL_HANDLE,
+                                    m_frame_fence[ frame_idx ] );
+        }
+
+        profiler.endFrame( frame );
+
+        {
+            ProfilerVK::CpuScope scope( profiler, "Present" );
+            result = renderer.getWindow().renderFrame( m_frame_semaphore[ frame_idx ].m_render_semaphore );
+        }
 
         //
         //check if we need to resize the window               
         // Recreate the swapchain if it's no longer compatible with the surface (OUT_OF_DATE) or no longer optimal for presentation (SUBOPTIMAL)
         if( ( result == VK_ERROR_OUT_OF_DATE_KHR ) || ( result == VK_SUBOPTIMAL_KHR ) )
         {
-           renderer.getWindow().wait();
-
-            vkDeviceWaitIdle( renderer.getDevice()->getLogicalDevice() );
-                       
-            destroySamplers    ();
-            destroyRenderPasses();
-            destroyAttachments ();
-            destroySyncObjects ();
-            renderer.getWindow ().resize();        
-
-            createSyncObjects ();
-            createSamplers    ();
-            createAttachments ();
-            updateTLAS();
-            createRenderPasses();
-           
+            recreateSwapChain();
         }                   
 
 
         m_current_frame++;
+        rendered_frames++;
         //check if the window is closed and poll input events
         loop = renderer.getWindow().loop();
 
@@ -160,12 +258,64 @@ void Engine::run()
 }
 
 
+void Engine::recreateSwapChain()
+{
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    renderer.getWindow().wait();
+
+    vkDeviceWaitIdle( renderer.getDevice()->getLogicalDevice() );
+               
+    //pipelines use dynamic viewport and scissor, so passes, samplers, sync objects and the tlas survive the resize.
+    //only the render graph images and whatever references them are rebuilt
+    renderer.getWindow().resize();        
+    m_render_graph->resize();
+
+    for( auto& pass : m_render_passes )
+    {
+        pass->resize();
+    }
+}
+
+
+void Engine::setFramesInFlight( const uint32_t i_frames_in_flight )
+{
+    const uint32_t frames_in_flight = std::clamp( i_frames_in_flight, 1u, kMAX_NUMBER_OF_FRAMES );
+
+    if( frames_in_flight == m_frames_in_flight )
+    {
+        return;
+    }
+
+    //changing the ring size while frames are in flight would skip slots whose fences are pending
+    if( m_runtime.m_renderer )
+    {
+        vkDeviceWaitIdle( m_runtime.m_renderer->getDevice()->getLogicalDevice() );
+    }
+
+    m_frames_in_flight = frames_in_flight;
+    m_current_frame    = 0;
+}
+
+
+void Engine::setWorkerThreads( const uint32_t i_worker_threads )
+{
+    assert( !m_runtime.m_thread_pool );
+
+    m_worker_threads = std::min( i_worker_threads, kMAX_WORKER_THREADS );
+}
+
+
 void Engine::shutdown()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
 
     vkDeviceWaitIdle( renderer.getDevice()->getLogicalDevice() );
+
+    //what the scene held at its peak, everything is released below
+    renderer.getDevice()->getAllocator().printStats( std::cout );
+    m_runtime.m_geometry_arena->printStats( std::cout );
     
     m_runtime.freeResources();
 
@@ -175,7 +325,6 @@ void Engine::shutdown()
     }
 
     destroyRenderPasses();
-    destroyAttachments ();
     destroySamplers    ();
     destroySyncObjects ();
 
@@ -185,20 +334,30 @@ void Engine::shutdown()
         vkDeviceWaitIdle(m_runtime.m_renderer->getDevice()->getLogicalDevice());
 
         vkDestroyAccelerationStructure(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_tlas_structure, nullptr);
-        vkFreeMemory(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_tlas_memory, nullptr);
-        vkDestroyBuffer(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_tlas_buffer, nullptr);
+        UtilsVK::freeBuffer(*m_runtime.m_renderer->getDevice(), m_tlas_buffer, m_tlas_memory);
 
         // Tambin limpia los buffers de instancias si los tienes
         if (m_instances_buffer != VK_NULL_HANDLE) {
-            vkDestroyBuffer(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_instances_buffer, nullptr);
-            vkFreeMemory(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_instances_memory, nullptr);
+            UtilsVK::freeBuffer(*m_runtime.m_renderer->getDevice(), m_instances_buffer, m_instances_memory);
         }
     }
 #endif
 
+    m_runtime.m_meshlet_culling->shutdown();
     m_runtime.m_mesh_registry->shutdown();
+    m_runtime.m_geometry_arena->shutdown();
     m_runtime.m_shader_registry->shutdown();
 
+    m_runtime.m_profiler->printAverages( std::cout );
+    if( !m_trace_file.empty() )
+    {
+        m_runtime.m_profiler->writeChromeTrace( m_trace_file );
+    }
+    m_runtime.m_profiler->shutdown();
+
+    m_runtime.m_command_pools->shutdown();
+    m_runtime.m_thread_pool.reset();
+
     m_runtime.m_renderer->shutdown();
 }
 
@@ -209,24 +368,43 @@ void Engine::loadScene( const std::string& i_path )
 
     assert( m_scene );
 
+    //the meshes only recorded their copies while the scene was parsed, the acceleration structures read them
+    //from commands submitted after this, so the last batch goes out now without waiting for it
+    m_runtime.m_renderer->getDevice()->getUploadManager().flush();
+#ifdef RTX
+    if( m_runtime.m_renderer->getDevice()->supportsRayTracing() )
+    {
+        m_runtime.m_mesh_registry->createBLAS();
+    }
+#endif
+
     if( !m_render_passes.empty() )
     {
-        destroySamplers    ();
-        destroyAttachments ();
         destroyRenderPasses();
+        destroySamplers    ();
     }
     else //create uniform buffers just once
     {
         m_runtime.createResources();
     }
 
+    //offscreen outputs take the camera size right away, a window catches up when its swap chain is recreated
+    RendererVK& renderer = *m_runtime.m_renderer;
+    if( renderer.getWindow().isHeadless() )
+    {
+        renderer.getWindow().resize( m_scene->getCamera().getWidth(), m_scene->getCamera().getHeight() );
+    }
+
     createSamplers    ();
-    createAttachments ();
     updateTLAS();
+    //reads the per frame buffers, and the passes record draws from its commands
+    m_runtime.m_meshlet_culling->build( m_scene->getMeshes() );
     createRenderPasses();
 
-    RendererVK& renderer = *m_runtime.m_renderer;
-    renderer.getWindow().resize( m_scene->getCamera().getWidth(), m_scene->getCamera().getHeight() );
+    if( !renderer.getWindow().isHeadless() )
+    {
+        renderer.getWindow().resize( m_scene->getCamera().getWidth(), m_scene->getCamera().getHeight() );
+    }
 
 }
 
@@ -236,7 +414,7 @@ void Engine::createSyncObjects()
     RendererVK& renderer = *m_runtime.m_renderer;
 
     //create sync objects
-    for( uint32_t idx = 0; idx < 3; idx++ )
+    for( uint32_t idx = 0; idx < kMAX_NUMBER_OF_FRAMES; idx++ )
     {
         VkSemaphoreCreateInfo semaphore_info{};
         semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -251,8 +429,10 @@ void Engine::createSyncObjects()
             throw MiniEngineException( "Cannot create presentation semaphore" );
         }
 
+        //created signaled so the first wait on every slot returns immediately
         VkFenceCreateInfo fence_info{};
         fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
         if( vkCreateFence( renderer.getDevice()->getLogicalDevice(), &fence_info, nullptr, &m_frame_fence[ idx ] ) )
         {
@@ -266,7 +446,7 @@ void Engine::destroySyncObjects()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
-    for( uint32_t idx = 0; idx < 3; idx++ )
+    for( uint32_t idx = 0; idx < kMAX_NUMBER_OF_FRAMES; idx++ )
     {
         vkDestroySemaphore( renderer.getDevice()->getLogicalDevice(), m_frame_semaphore[ idx ].m_render_semaphore      , nullptr );
         vkDestroySemaphore( renderer.getDevice()->getLogicalDevice(), m_frame_semaphore[ idx ].m_presentation_semaphore, nullptr );
@@ -278,50 +458,124 @@ void Engine::destroySyncObjects()
 void Engine::createRenderPasses ()
 { 
     //temp
-    for( auto pass : m_render_passes )
-    {
-        pass->shutdown();
-    }
-    m_render_passes.clear();
-    
+    destroyRenderPasses();
+
+    m_render_graph = std::make_unique<RenderGraphVK>( m_runtime );
+    RenderGraphVK& graph = *m_render_graph;
+
+    RenderGraphVK::ImageDesc color_desc;
+    color_desc.m_format  = VK_FORMAT_R8G8B8A8_UNORM;
+    color_desc.m_usage   = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    color_desc.m_sampler = m_global_samplers[ 0 ];
+
+    RenderGraphVK::ImageDesc position_desc = color_desc;
+    position_desc.m_format = VK_FORMAT_R32G32B32A32_SFLOAT;
+
+    RenderGraphVK::ImageDesc depth_desc = color_desc;
+    depth_desc.m_format = VK_FORMAT_D32_SFLOAT_S8_UINT;
+    depth_desc.m_usage  = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+    //written by compute and sampled afterwards, the graph adds both usages
+    RenderGraphVK::ImageDesc occlusion_desc = color_desc;
+    occlusion_desc.m_format = VK_FORMAT_R32_SFLOAT;
+    occlusion_desc.m_usage  = 0;
+
+    RenderGraphVK::ImageDesc shadow_desc = depth_desc;
+    shadow_desc.m_width  = SHADOW_MAP_SIZE;
+    shadow_desc.m_height = SHADOW_MAP_SIZE;
+    shadow_desc.m_layers = SHADOW_MAP_LAYERS;
+
+    const ImageBlock& color_attachment    = graph.addImage( "Image Color Attachment"   , color_desc    );
+    const ImageBlock& normal_attachment   = graph.addImage( "Image Normal Attachment"  , color_desc    );
+    const ImageBlock& position_attachment = graph.addImage( "Image Position Attachment", position_desc );
+    const ImageBlock& material_attachment = graph.addImage( "Image Material Attachment", color_desc    );
+    const ImageBlock& depth_attachment    = graph.addImage( "Image Depth Buffer"       , depth_desc    );
+    const ImageBlock& shadow_attachment   = graph.addImage( "Image Shadow Attachment"  , shadow_desc   );
+    const ImageBlock& ssao_image          = graph.addImage( "Image SSAO"               , occlusion_desc );
+    const ImageBlock& ssao_blur_image     = graph.addImage( "Image SSAO Blur"          , occlusion_desc );
+    graph.addExternal( "Swap Chain" );
+    graph.setOutput  ( "Swap Chain" );
+
+    //passes only keep references to the images, they are created when the graph compiles
 	auto depth_pass = std::make_shared<DepthPassVK>(
         m_runtime, 
-        m_render_target_attachments.m_depth_attachment);
-	depth_pass->initialize();
+        depth_attachment);
 
-	m_render_passes.push_back(depth_pass);
+    graph.addPass( "Depth", depth_pass, { { "Image Depth Buffer", RenderGraphVK::Access::DepthWrite } } );
 
     auto gbuffer_pass = std::make_shared<DeferredPassVK>(
         m_runtime, 
-        m_render_target_attachments.m_depth_attachment, 
-        m_render_target_attachments.m_color_attachment, 
-        m_render_target_attachments.m_normal_attachment, 
-        m_render_target_attachments.m_position_depth_attachment, 
-        m_render_target_attachments.m_material_attachment );
-    gbuffer_pass->initialize();
-
-    m_render_passes.push_back( gbuffer_pass );
+        depth_attachment, 
+        color_attachment, 
+        normal_attachment, 
+        position_attachment, 
+        material_attachment );
+
+    graph.addPass( "GBuffer", gbuffer_pass, { 
+        { "Image Color Attachment"   , RenderGraphVK::Access::ColorWrite     },
+        { "Image Normal Attachment"  , RenderGraphVK::Access::ColorWrite     },
+        { "Image Position Attachment", RenderGraphVK::Access::ColorWrite     },
+        { "Image Material Attachment", RenderGraphVK::Access::ColorWrite     },
+        { "Image Depth Buffer"       , RenderGraphVK::Access::DepthReadWrite } } );
     
+    //declared before the shadows so the async compute queue works on them while the shadow maps rasterize
+    auto ssao_pass = std::make_shared<SSAOComputePassVK>(
+        m_runtime,
+        position_attachment,
+        normal_attachment,
+        ssao_image );
+
+    graph.addPass( "SSAO", ssao_pass, {
+        { "Image Position Attachment", RenderGraphVK::Access::ComputeSampled },
+        { "Image Normal Attachment"  , RenderGraphVK::Access::ComputeSampled },
+        { "Image SSAO"               , RenderGraphVK::Access::StorageWrite   } } );
+
+    auto blur_pass = std::make_shared<BlurComputePassVK>(
+        m_runtime,
+        ssao_image,
+        ssao_blur_image );
+
+    graph.addPass( "SSAO Blur", blur_pass, {
+        { "Image SSAO"     , RenderGraphVK::Access::ComputeSampled },
+        { "Image SSAO Blur", RenderGraphVK::Access::StorageWrite   } } );
+
 	auto shadow_pass = std::make_shared<ShadowPassVK>
         (m_runtime, 
-       m_render_target_attachments.m_shadow_attachment);
-    shadow_pass->initialize();
-    
-	m_render_passes.push_back(shadow_pass);
+       shadow_attachment);
+
+    graph.addPass( "Shadow", shadow_pass, { { "Image Shadow Attachment", RenderGraphVK::Access::DepthWrite } } );
 
     auto composition_pass = std::make_shared<CompositionPassVK>( 
         m_runtime, 
-        m_render_target_attachments.m_color_attachment, 
-        m_render_target_attachments.m_position_depth_attachment,
-        m_render_target_attachments.m_normal_attachment, 
-        m_render_target_attachments.m_material_attachment,  
-		m_render_target_attachments.m_shadow_attachment,
+        color_attachment, 
+        position_attachment,
+        normal_attachment, 
+        material_attachment,  
+		shadow_attachment,
+        ssao_blur_image,
 		m_tlas_structure,
         m_runtime.m_renderer->getWindow().getSwapChainImages() );
-    composition_pass->initialize();
 
-    m_render_passes.push_back( composition_pass );
+    graph.addPass( "Composition", composition_pass, { 
+        { "Image Color Attachment"   , RenderGraphVK::Access::Sampled  },
+        { "Image Position Attachment", RenderGraphVK::Access::Sampled  },
+        { "Image Normal Attachment"  , RenderGraphVK::Access::Sampled  },
+        { "Image Material Attachment", RenderGraphVK::Access::Sampled  },
+        { "Image Shadow Attachment"  , RenderGraphVK::Access::Sampled  },
+        { "Image SSAO Blur"          , RenderGraphVK::Access::Sampled  },
+        { "Swap Chain"               , RenderGraphVK::Access::External } } );
+
+    graph.compile();
+
+    m_render_passes = graph.getPasses();
+    for( auto pass : m_render_passes )
+    {
+        pass->initialize();
+    }
 
+    std::cout << "render graph: " << m_render_passes.size() << " passes, " << graph.getCulledPassCount() << " culled, " 
+              << ( graph.getAllocatedMemory() >> 20 ) << " MB of attachments (" << ( graph.getRequiredMemory() >> 20 ) << " MB without aliasing), "
+              << graph.getSubmitCount() << " submits" << std::endl;
 
     if( m_scene )
     {
@@ -338,8 +592,6 @@ void Engine::createRenderPasses ()
 
 void Engine::destroyRenderPasses()
 {
-    RendererVK& renderer = *m_runtime.m_renderer;
-
     for( auto pass : m_render_passes )
     {
         pass->shutdown();
@@ -347,12 +599,77 @@ void Engine::destroyRenderPasses()
     }
 
     m_render_passes.clear();
+
+    if( m_render_graph )
+    {
+        m_render_graph->shutdown();
+        m_render_graph = nullptr;
+    }
 }
 
 
-void Engine::updateGlobalBuffers()
+void Engine::updateLods()
 {
-    assert( m_runtime.m_per_frame_buffer[ m_current_frame % 3 ] );
+    Camera& camera = const_cast< Camera& >( m_scene->getCamera() );
+
+    const Matrix4f camera_view_projection = camera.getProjection() * camera.getView();
+
+    //only lights that render into the shadow map
+    std::vector<Matrix4f> light_view_projections;
+    for( size_t idx = 0; idx < m_scene->getLights().size() && idx < kMAX_NUMBER_LIGHTS; idx++ )
+    {
+        const auto& light = m_scene->getLights()[ idx ];
+
+        if( light->m_data.m_type == Light::LightType::Point || light->m_data.m_type == Light::LightType::Directional )
+        {
+            light_view_projections.push_back( Light::getLightSpaceMatrix( light, camera ) );
+        }
+    }
+
+    std::array<bool, static_cast<uint32_t>( LodView::Count )> changed{};
+
+    for( const auto& entity : m_scene->getMeshes() )
+    {
+        const MeshVK&   mesh  = entity->getMesh();
+        const Matrix4f& model = entity->getTransform().getTransform();
+
+        if( mesh.getLodCount() < 2 )
+        {
+            continue;
+        }
+
+        //the errors are in object space, the largest axis scale bounds how much the transform stretches them
+        const float    scale  = std::max( { glm::length( Vector3f( model[ 0 ] ) ), glm::length( Vector3f( model[ 1 ] ) ), glm::length( Vector3f( model[ 2 ] ) ) } );
+        const Vector3f center = Vector3f( model * Vector4f( ( mesh.getBoundsMin() + mesh.getBoundsMax() ) * 0.5f, 1.0f ) );
+        const float    radius = glm::length( mesh.getBoundsMax() - mesh.getBoundsMin() ) * 0.5f * scale;
+
+        const float camera_pixels = getPixelsPerUnit( camera_view_projection, static_cast<float>( camera.getHeight() ), center, radius ) * scale;
+
+        //one draw fills every light layer, so the light that sees the entity largest decides
+        float shadow_pixels = 0.0f;
+        for( const auto& light_view_projection : light_view_projections )
+        {
+            shadow_pixels = std::max( shadow_pixels, getPixelsPerUnit( light_view_projection, static_cast<float>( SHADOW_MAP_SIZE ), center, radius ) * scale );
+        }
+
+        changed[ static_cast<uint32_t>( LodView::Camera ) ] |= entity->setLod( LodView::Camera, selectLod( mesh, camera_pixels, m_lod_error_threshold ) );
+        changed[ static_cast<uint32_t>( LodView::Shadow ) ] |= entity->setLod( LodView::Shadow, selectLod( mesh, shadow_pixels, m_lod_error_threshold ) );
+    }
+
+    for( auto& pass : m_render_passes )
+    {
+        if( changed[ static_cast<uint32_t>( pass->getLodView() ) ] )
+        {
+            pass->invalidate();
+        }
+    }
+}
+
+
+void Engine::updateGlobalBuffers( const Frame& i_frame )
+{
+    assert( i_frame.m_frame_index < kMAX_NUMBER_OF_FRAMES );
+    assert( m_runtime.m_per_frame_buffer[ i_frame.m_frame_index ] );
     assert( m_scene );
 
     //global settings
@@ -397,96 +714,54 @@ void Engine::updateGlobalBuffers()
     }
 
 
-    //material buffers
-    void* data;
-    vkMapMemory( m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_runtime.m_per_frame_buffer_memory[ m_current_frame  % 3 ], 0, sizeof( PerFrameData ), 0, &data );
+    //the per frame data changes every frame, it goes in one copy to the mapped buffer
+    memcpy( m_runtime.m_per_frame_buffer_memory[ i_frame.m_frame_index ].m_mapped, &perframe_data, sizeof( PerFrameData ) );
 
-    memcpy( data, &perframe_data, sizeof( PerFrameData ) );
+    //per object records are only rebuilt when the entity changed since this frame slot last wrote them,
+    //every run of consecutive rebuilt records reaches the mapped buffer in a single memcpy
+    const auto&    entities       = m_scene->getMeshes();
+    PerObjectData* mapped_objects = static_cast<PerObjectData*>( m_runtime.m_per_object_buffer_memory[ i_frame.m_frame_index ].m_mapped );
+    uint32_t       run_start      = UINT32_MAX;
 
-    vkUnmapMemory( m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_runtime.m_per_frame_buffer_memory[ m_current_frame % 3 ] );
-    
-    for( uint32_t idx = 0; idx < m_scene->getMeshes().size(); idx++ )
+    m_per_object_data.resize( entities.size() );
+
+    for( uint32_t idx = 0; idx <= entities.size(); idx++ )
     {
-        PerObjectData* data_object;
-        std::shared_ptr<Entity> entity = m_scene->getMeshes()[ idx ];
-        
-        vkMapMemory( m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_runtime.m_per_object_buffer_memory[ m_current_frame % 3 ], sizeof( PerObjectData ) * idx, sizeof( PerObjectData ), 0, reinterpret_cast<void**>( &data_object ) );
+        if( idx < entities.size() && entities[ idx ]->consumeDirty( i_frame.m_frame_index ) )
+        {
+            const std::shared_ptr<Entity>& entity      = entities[ idx ];
+            PerObjectData&                 data_object = m_per_object_data[ idx ];
 
-        data_object->m_model = entity->getTransform().getTransform();
+            data_object.m_model             = entity->getTransform().getTransform();
+            data_object.m_dequantize_scale  = entity->getMesh().getDequantization().m_scale;
+            data_object.m_dequantize_offset = entity->getMesh().getDequantization().m_offset;
 
-        switch( entity->getMaterial().getType() )
-        {
-            case Material::TMaterial::Diffuse:
+            switch( entity->getMaterial().getType() )
             {
-                Diffuse& diffuse = reinterpret_cast<Diffuse&>( entity->getMaterial() );
-                data_object->m_albedo  = Vector4f( diffuse.getData().m_albedo.x, diffuse.getData().m_albedo.y, diffuse.getData().m_albedo.z, 0.0f );
+                case Material::TMaterial::Diffuse:
+                {
+                    Diffuse& diffuse = reinterpret_cast<Diffuse&>( entity->getMaterial() );
+                    data_object.m_albedo  = Vector4f( diffuse.getData().m_albedo.x, diffuse.getData().m_albedo.y, diffuse.getData().m_albedo.z, 0.0f );
 
-                break;
-            }
-            case Material::TMaterial::Microfacets: 
-            {
-                Microfacets& microfacets = reinterpret_cast<Microfacets&>( entity->getMaterial() );
-                data_object->m_albedo             = Vector4f( microfacets.getData().m_albedo.x, microfacets.getData().m_albedo.y , microfacets.getData().m_albedo.z, 0.0f );
-                data_object->m_metallic_roughness = Vector4f( microfacets.getData().m_metallic, microfacets.getData().m_roughness,                             0.0f, 0.0f );
-                break;
+                    break;
+                }
+                case Material::TMaterial::Microfacets: 
+                {
+                    Microfacets& microfacets = reinterpret_cast<Microfacets&>( entity->getMaterial() );
+                    data_object.m_albedo             = Vector4f( microfacets.getData().m_albedo.x, microfacets.getData().m_albedo.y , microfacets.getData().m_albedo.z, 0.0f );
+                    data_object.m_metallic_roughness = Vector4f( microfacets.getData().m_metallic, microfacets.getData().m_roughness,                             0.0f, 0.0f );
+                    break;
+                }
             }
-        }        
 
-        vkUnmapMemory( m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_runtime.m_per_object_buffer_memory[ m_current_frame % 3 ] );
+            run_start = std::min( run_start, idx );
+        }
+        else if( run_start != UINT32_MAX )
+        {
+            memcpy( mapped_objects + run_start, m_per_object_data.data() + run_start, sizeof( PerObjectData ) * ( idx - run_start ) );
+            run_start = UINT32_MAX;
+        }
     }
-    
-}
-
-
-void Engine::createAttachments()
-{
-    uint32_t width, height;
-
-	const uint32_t DEPTH_LAYERS = 10;
-    const uint32_t MIP_LEVELS = 1;
-
-    m_runtime.m_renderer->getWindow().getWindowSize( width, height );
-
-    UtilsVK::createImage( *m_runtime.m_renderer->getDevice(), VK_FORMAT_R8G8B8A8_UNORM     , VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT        , width, height, m_render_target_attachments.m_color_attachment          );
-    UtilsVK::createImage( *m_runtime.m_renderer->getDevice(), VK_FORMAT_R8G8B8A8_UNORM     , VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT        , width, height, m_render_target_attachments.m_normal_attachment         );
-    UtilsVK::createImage( *m_runtime.m_renderer->getDevice(), VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT        , width, height, m_render_target_attachments.m_position_depth_attachment );
-    UtilsVK::createImage( *m_runtime.m_renderer->getDevice(), VK_FORMAT_R8G8B8A8_UNORM     , VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT        , width, height, m_render_target_attachments.m_material_attachment       );
-    UtilsVK::createImage( *m_runtime.m_renderer->getDevice(), VK_FORMAT_D32_SFLOAT_S8_UINT , VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, width, height, m_render_target_attachments.m_depth_attachment          );
-    UtilsVK::createImage( *m_runtime.m_renderer->getDevice(), VK_FORMAT_R8_UNORM           , VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT        , width, height, m_render_target_attachments.m_ssao_attachment           );
-    UtilsVK::createImage( *m_runtime.m_renderer->getDevice(), VK_FORMAT_R8_UNORM           , VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT        , width, height, m_render_target_attachments.m_ssao_blur_attachment      );
-    UtilsVK::createImage( *m_runtime.m_renderer->getDevice(), VK_FORMAT_D32_SFLOAT_S8_UINT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, DEPTH_LAYERS, MIP_LEVELS, 
-        IMAGE_BLOCK_2D_ARRAY, m_render_target_attachments.m_shadow_attachment);
-
-    m_render_target_attachments.m_color_attachment.m_sampler            = m_global_samplers[ 0 ];         
-    m_render_target_attachments.m_normal_attachment.m_sampler           = m_global_samplers[ 0 ];        
-    m_render_target_attachments.m_position_depth_attachment.m_sampler   = m_global_samplers[ 0 ];
-    m_render_target_attachments.m_material_attachment.m_sampler         = m_global_samplers[ 0 ];      
-    m_render_target_attachments.m_depth_attachment.m_sampler            = m_global_samplers[ 0 ];         
-    m_render_target_attachments.m_ssao_attachment.m_sampler             = m_global_samplers[ 0 ];          
-    m_render_target_attachments.m_ssao_blur_attachment.m_sampler        = m_global_samplers[ 0 ]; 
-	m_render_target_attachments.m_shadow_attachment.m_sampler = m_global_samplers[0];
-
-    UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t)( m_render_target_attachments.m_color_attachment.m_image          ), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image Color Attachment"    );
-    UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t)( m_render_target_attachments.m_normal_attachment.m_image         ), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image Normal Attachment "  );
-    UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t)( m_render_target_attachments.m_position_depth_attachment.m_image ), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image Position Attachment ");
-    UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t)( m_render_target_attachments.m_material_attachment.m_image       ), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image Material Attachment ");
-    UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t)( m_render_target_attachments.m_depth_attachment.m_image          ), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image Depth Buffer"        );
-    UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t)( m_render_target_attachments.m_ssao_attachment.m_image           ), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image SSAO attachment"     );
-    UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t)( m_render_target_attachments.m_ssao_blur_attachment.m_image      ), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image SSAO blur "          );
-	UtilsVK::setObjectName(m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t)(m_render_target_attachments.m_shadow_attachment.m_image), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image Shadow Attachment");
-}
-
-
-void Engine::destroyAttachments()
-{
-    UtilsVK::freeImageBlock( *m_runtime.m_renderer->getDevice(), m_render_target_attachments.m_color_attachment          );
-    UtilsVK::freeImageBlock( *m_runtime.m_renderer->getDevice(), m_render_target_attachments.m_normal_attachment         );
-    UtilsVK::freeImageBlock( *m_runtime.m_renderer->getDevice(), m_render_target_attachments.m_position_depth_attachment );
-    UtilsVK::freeImageBlock( *m_runtime.m_renderer->getDevice(), m_render_target_attachments.m_material_attachment       );
-    UtilsVK::freeImageBlock( *m_runtime.m_renderer->getDevice(), m_render_target_attachments.m_depth_attachment          );
-    UtilsVK::freeImageBlock( *m_runtime.m_renderer->getDevice(), m_render_target_attachments.m_ssao_attachment           );
-    UtilsVK::freeImageBlock( *m_runtime.m_renderer->getDevice(), m_render_target_attachments.m_ssao_blur_attachment      );
-	UtilsVK::freeImageBlock(*m_runtime.m_renderer->getDevice(), m_render_target_attachments.m_shadow_attachment);
 }
 
 
@@ -526,6 +801,14 @@ void Engine::destroySamplers()
 //TLAS
 void Engine::updateTLAS() {
 #ifdef RTX
+    //the composition then shades with the shadow maps only
+    if( !m_runtime.m_renderer->getDevice()->supportsRayTracing() )
+    {
+        return;
+    }
+
+    ProfilerVK::CpuScope scope( *m_runtime.m_profiler, "Update TLAS" );
+
     try {
         // Verificar inicializacin
         if (!m_runtime.m_renderer || !m_runtime.m_renderer->getDevice()) {
@@ -540,19 +823,13 @@ void Engine::updateTLAS() {
             vkDeviceWaitIdle(m_runtime.m_renderer->getDevice()->getLogicalDevice());
 
             vkDestroyAccelerationStructure(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_tlas_structure, nullptr);
-            vkFreeMemory(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_tlas_memory, nullptr);
-            vkDestroyBuffer(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_tlas_buffer, nullptr);
+            UtilsVK::freeBuffer(*m_runtime.m_renderer->getDevice(), m_tlas_buffer, m_tlas_memory);
 
             // Tambin limpia los buffers de instancias si los tienes
             if (m_instances_buffer != VK_NULL_HANDLE) {
-                vkDestroyBuffer(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_instances_buffer, nullptr);
-                vkFreeMemory(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_instances_memory, nullptr);
+                UtilsVK::freeBuffer(*m_runtime.m_renderer->getDevice(), m_instances_buffer, m_instances_memory);
             }
 
-			m_tlas_buffer = VK_NULL_HANDLE;
-			m_tlas_memory = VK_NULL_HANDLE;
-			m_instances_buffer = VK_NULL_HANDLE;
-			m_instances_memory = VK_NULL_HANDLE;
 			m_tlas_structure = VK_NULL_HANDLE;
         }
 
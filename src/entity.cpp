@@ -24,7 +24,7 @@ std::shared_ptr<Entity> Entity::createEntity(  const Runtime& i_runtime, const p
     auto entity = std::make_shared<Entity>( i_runtime );
     std::string path = i_node.find_child_by_attribute( "name", "filename" ).attribute("value").value();
     
-    entity->m_mesh = i_runtime.m_mesh_registry->loadMesh( path );
+    entity->m_mesh = i_runtime.m_mesh_registry->loadMesh( path, getVertexFormat( i_node ) );
 
     for (pugi::xml_node node = i_node.child("transform"); node; node = node.next_sibling("transform") )
     {
@@ -47,6 +47,13 @@ std::shared_ptr<Entity> Entity::createEntity(  const Runtime& i_runtime, const p
     return  entity;
 }
 
+VertexFormat Entity::getVertexFormat( const pugi::xml_node& i_node )
+{
+    //<string name="vertex_format" value="compact"/>, float when missing
+    return VertexLayouts::parseFormat( i_node.find_child_by_attribute( "string", "name", "vertex_format" ).attribute( "value" ).value() );
+}
+
+
 bool Entity::initialize()
 {
     assert( m_material  != nullptr );
@@ -60,12 +67,42 @@ void Entity::shutdown()
 }
 
 
-void Entity::draw( CommandBuffer& i_command_buffer, const Frame& i_frame )
+bool Entity::consumeDirty( const uint32_t i_frame_index )
+{
+    assert( i_frame_index < kMAX_NUMBER_OF_FRAMES );
+
+    const uint32_t version = m_transform.getVersion();
+    if( m_uploaded_version[ i_frame_index ] == version )
+    {
+        return false;
+    }
+
+    m_uploaded_version[ i_frame_index ] = version;
+    return true;
+}
+
+
+bool Entity::setLod( const LodView i_view, const uint32_t i_lod )
+{
+    assert( i_lod < m_mesh->getLodCount() );
+
+    uint32_t& lod = m_lods[ static_cast<uint32_t>( i_view ) ];
+    if( lod == i_lod )
+    {
+        return false;
+    }
+
+    lod = i_lod;
+    return true;
+}
+
+
+void Entity::draw( CommandBuffer& i_command_buffer, const Frame& i_frame, const LodView i_view, const VertexStream i_stream, GeometryBinding* io_binding )
 {
     //make the draw
     const RendererVK& renderer = *m_runtime.m_renderer;
     
-    m_mesh->draw( i_command_buffer, m_entity_offset );
+    m_mesh->draw( i_command_buffer, m_entity_offset, getLod( i_view ), i_stream, io_binding );
 }
 
 
@@ -0,0 +1,440 @@
+#include "meshCache.h"
+
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    constexpr uint32_t kCACHE_MAGIC     = 0x4853454d; //"MESH"
+    constexpr uint32_t kCACHE_VERSION   = 5; //2: vertices deduplicated on every attribute, 3: optimized index and vertex order, 4: lods, 5: meshlets
+    constexpr uint64_t kCACHE_ALIGNMENT = 16;
+
+    //the source path follows the header, then the vertex, index and meshlet arrays at aligned offsets
+    struct Header
+    {
+        uint32_t m_magic;
+        uint32_t m_version;
+        uint32_t m_vertex_stride; //catches a changed Vertex layout without a version bump
+        uint32_t m_path_size;
+        uint64_t m_source_size;
+        int64_t  m_source_mtime;
+        uint64_t m_source_hash;
+        uint32_t m_vertex_count;
+        uint32_t m_index_count;
+        uint64_t m_vertices_offset;
+        uint64_t m_indices_offset;
+        float    m_bounds_min[ 3 ];
+        float    m_bounds_max[ 3 ];
+        uint32_t m_lod_count;
+        MeshLod  m_lods[ kMAX_MESH_LODS ];
+        uint32_t m_meshlet_count;
+        uint64_t m_meshlets_offset;
+    };
+
+    struct SourceInfo
+    {
+        uint64_t m_size  = 0;
+        int64_t  m_mtime = 0;
+    };
+
+    bool getSourceInfo( const std::string& i_path, SourceInfo& o_info )
+    {
+#ifdef _WIN32
+        struct _stat64 info;
+        if( _stat64( i_path.c_str(), &info ) != 0 )
+#else
+        struct stat info;
+        if( stat( i_path.c_str(), &info ) != 0 )
+#endif
+        {
+            return false;
+        }
+
+        o_info.m_size  = static_cast<uint64_t>( info.st_size  );
+        o_info.m_mtime = static_cast<int64_t> ( info.st_mtime );
+        return true;
+    }
+
+    //reads 8 bytes per step, hashing a large obj costs a fraction of parsing it
+    uint64_t hashBytes( const uint8_t* i_data, const size_t i_size )
+    {
+        uint64_t hash = 0xcbf29ce484222325ull ^ i_size;
+        size_t   idx  = 0;
+
+        for( ; idx + sizeof( uint64_t ) <= i_size; idx += sizeof( uint64_t ) )
+        {
+            uint64_t word;
+            memcpy( &word, i_data + idx, sizeof( uint64_t ) );
+
+            hash  = ( hash ^ word ) * 0x9e3779b97f4a7c15ull;
+            hash ^= hash >> 29;
+        }
+
+        for( ; idx < i_size; idx++ )
+        {
+            hash = ( hash ^ i_data[ idx ] ) * 0x100000001b3ull;
+        }
+
+        return hash ^ ( hash >> 32 );
+    }
+
+    bool hashFile( const std::string& i_path, uint64_t& o_hash )
+    {
+        MappedFile file;
+        if( !file.open( i_path ) )
+        {
+            return false;
+        }
+
+        o_hash = hashBytes( file.getData(), file.getSize() );
+        return true;
+    }
+
+    uint64_t alignUp( const uint64_t i_value, const uint64_t i_alignment )
+    {
+        return ( i_value + i_alignment - 1 ) / i_alignment * i_alignment;
+    }
+
+    bool readHeader( const MappedFile& i_file, const std::string& i_source_path, Header& o_header )
+    {
+        if( i_file.getSize() < sizeof( Header ) )
+        {
+            return false;
+        }
+
+        memcpy( &o_header, i_file.getData(), sizeof( Header ) );
+
+        if( o_header.m_magic != kCACHE_MAGIC || o_header.m_version != kCACHE_VERSION || o_header.m_vertex_stride != sizeof( Vertex ) )
+        {
+            return false;
+        }
+
+        //a cache copied along with its scene to another place is rebuilt there
+        if( o_header.m_path_size != i_source_path.size() || sizeof( Header ) + o_header.m_path_size > i_file.getSize() ||
+            memcmp( i_file.getData() + sizeof( Header ), i_source_path.data(), i_source_path.size() ) != 0 )
+        {
+            return false;
+        }
+
+        const uint64_t vertices_end = o_header.m_vertices_offset + uint64_t( o_header.m_vertex_count ) * sizeof( Vertex );
+        const uint64_t indices_end  = o_header.m_indices_offset  + uint64_t( o_header.m_index_count  ) * sizeof( uint32_t );
+        const uint64_t meshlets_end = o_header.m_meshlets_offset + uint64_t( o_header.m_meshlet_count ) * sizeof( Meshlet );
+
+        if( o_header.m_vertices_offset % kCACHE_ALIGNMENT != 0 || o_header.m_indices_offset % kCACHE_ALIGNMENT != 0 || o_header.m_meshlets_offset % kCACHE_ALIGNMENT != 0 ||
+            vertices_end > i_file.getSize() || indices_end > i_file.getSize() || meshlets_end > i_file.getSize() || o_header.m_index_count % 3 != 0 ||
+            o_header.m_lod_count == 0 || o_header.m_lod_count > kMAX_MESH_LODS )
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    //what the header says fits in the file, this checks that the content stays inside its own arrays. a cache
+    //from an older build or cut short keeps a valid header and would have the gpu read past the vertices
+    bool checkRanges( const MappedFile& i_file, const Header& i_header )
+    {
+        if( i_header.m_vertex_count == 0 || i_header.m_index_count == 0 )
+        {
+            return false;
+        }
+
+        for( uint32_t lod = 0; lod < i_header.m_lod_count; lod++ )
+        {
+            const MeshLod& level = i_header.m_lods[ lod ];
+            if( uint64_t( level.m_index_offset ) + level.m_index_count > i_header.m_index_count || level.m_index_offset % 3 != 0 || level.m_index_count % 3 != 0 )
+            {
+                return false;
+            }
+        }
+
+        //the meshlets cover lod 0 and are stored relative to the mesh
+        const MeshLod& full     = i_header.m_lods[ 0 ];
+        const Meshlet* meshlets = reinterpret_cast<const Meshlet*>( i_file.getData() + i_header.m_meshlets_offset );
+        for( uint32_t meshlet = 0; meshlet < i_header.m_meshlet_count; meshlet++ )
+        {
+            const Meshlet& cluster = meshlets[ meshlet ];
+            if( cluster.m_index_offset < full.m_index_offset || uint64_t( cluster.m_index_offset ) + cluster.m_index_count > uint64_t( full.m_index_offset ) + full.m_index_count ||
+                cluster.m_index_count % 3 != 0 || cluster.m_vertex_offset != 0 )
+            {
+                return false;
+            }
+        }
+
+        const uint32_t* indices = reinterpret_cast<const uint32_t*>( i_file.getData() + i_header.m_indices_offset );
+        for( uint32_t index = 0; index < i_header.m_index_count; index++ )
+        {
+            if( indices[ index ] >= i_header.m_vertex_count )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void padTo( std::ofstream& io_file, const uint64_t i_offset )
+    {
+        static const char zeros[ kCACHE_ALIGNMENT ] = {};
+
+        const uint64_t position = static_cast<uint64_t>( io_file.tellp() );
+        if( position < i_offset )
+        {
+            io_file.write( zeros, static_cast<std::streamsize>( i_offset - position ) );
+        }
+    }
+}
+
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+
+bool MappedFile::open( const std::string& i_path )
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA( i_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+    if( file == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    if( mapping == nullptr )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    const void* data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    if( data == nullptr )
+    {
+        CloseHandle( mapping );
+        CloseHandle( file );
+        return false;
+    }
+
+    m_file    = file;
+    m_mapping = mapping;
+    m_data    = static_cast<const uint8_t*>( data );
+    m_size    = static_cast<size_t>( size.QuadPart );
+#else
+    const int file = ::open( i_path.c_str(), O_RDONLY );
+    if( file < 0 )
+    {
+        return false;
+    }
+
+    struct stat info;
+    if( fstat( file, &info ) != 0 || info.st_size == 0 )
+    {
+        ::close( file );
+        return false;
+    }
+
+    void* data = mmap( nullptr, static_cast<size_t>( info.st_size ), PROT_READ, MAP_PRIVATE, file, 0 );
+
+    //the mapping keeps the file alive on its own
+    ::close( file );
+
+    if( data == MAP_FAILED )
+    {
+        return false;
+    }
+
+    //read front to back by the upload or the hash
+    posix_madvise( data, static_cast<size_t>( info.st_size ), POSIX_MADV_SEQUENTIAL );
+
+    m_data = static_cast<const uint8_t*>( data );
+    m_size = static_cast<size_t>( info.st_size );
+#endif
+
+    return true;
+}
+
+
+void MappedFile::close()
+{
+    if( m_data == nullptr )
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile( m_data );
+    CloseHandle( m_mapping );
+    CloseHandle( m_file );
+
+    m_mapping = nullptr;
+    m_file    = nullptr;
+#else
+    munmap( const_cast<uint8_t*>( m_data ), m_size );
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+
+std::string MeshCache::getCachePath( const std::string& i_source_path )
+{
+    return i_source_path + ".meshcache";
+}
+
+
+bool MeshCache::load( const std::string& i_source_path, MappedFile& o_file, View& o_view )
+{
+    SourceInfo source;
+    if( !getSourceInfo( i_source_path, source ) )
+    {
+        return false;
+    }
+
+    const std::string cache_path = getCachePath( i_source_path );
+
+    Header header;
+    if( !o_file.open( cache_path ) || !readHeader( o_file, i_source_path, header ) || header.m_source_size != source.m_size )
+    {
+        o_file.close();
+        return false;
+    }
+
+    //touched but maybe not modified, the content decides
+    if( header.m_source_mtime != source.m_mtime )
+    {
+        uint64_t hash = 0;
+        if( !hashFile( i_source_path, hash ) || hash != header.m_source_hash )
+        {
+            o_file.close();
+            return false;
+        }
+
+        //the next start takes the fast path again
+        o_file.close();
+        {
+            std::fstream file( cache_path, std::ios::in | std::ios::out | std::ios::binary );
+            file.seekp( offsetof( Header, m_source_mtime ) );
+            file.write( reinterpret_cast<const char*>( &source.m_mtime ), sizeof( source.m_mtime ) );
+        }
+
+        if( !o_file.open( cache_path ) || !readHeader( o_file, i_source_path, header ) )
+        {
+            o_file.close();
+            return false;
+        }
+    }
+
+    //read once per mapping, a failure reparses the source like any other invalid cache
+    if( !checkRanges( o_file, header ) )
+    {
+        o_file.close();
+        return false;
+    }
+
+    o_view.m_vertices     = reinterpret_cast<const Vertex*>  ( o_file.getData() + header.m_vertices_offset );
+    o_view.m_vertex_count = header.m_vertex_count;
+    o_view.m_indices      = reinterpret_cast<const uint32_t*>( o_file.getData() + header.m_indices_offset  );
+    o_view.m_index_count  = header.m_index_count;
+    o_view.m_bounds_min   = Vector3f( header.m_bounds_min[ 0 ], header.m_bounds_min[ 1 ], header.m_bounds_min[ 2 ] );
+    o_view.m_bounds_max   = Vector3f( header.m_bounds_max[ 0 ], header.m_bounds_max[ 1 ], header.m_bounds_max[ 2 ] );
+    o_view.m_lod_count    = header.m_lod_count;
+    std::copy( header.m_lods, header.m_lods + header.m_lod_count, o_view.m_lods.begin() );
+    o_view.m_meshlets      = reinterpret_cast<const Meshlet*>( o_file.getData() + header.m_meshlets_offset );
+    o_view.m_meshlet_count = header.m_meshlet_count;
+
+    return true;
+}
+
+
+void MeshCache::store( const std::string& i_source_path, const View& i_view )
+{
+    SourceInfo source;
+    uint64_t   hash = 0;
+
+    if( !getSourceInfo( i_source_path, source ) || !hashFile( i_source_path, hash ) )
+    {
+        std::cerr << tfm::format( "Mesh cache: could not read %s back to key its cache\n", i_source_path );
+        return;
+    }
+
+    Header header{};
+    header.m_magic           = kCACHE_MAGIC;
+    header.m_version         = kCACHE_VERSION;
+    header.m_vertex_stride   = sizeof( Vertex );
+    header.m_path_size       = static_cast<uint32_t>( i_source_path.size() );
+    header.m_source_size     = source.m_size;
+    header.m_source_mtime    = source.m_mtime;
+    header.m_source_hash     = hash;
+    header.m_vertex_count    = i_view.m_vertex_count;
+    header.m_index_count     = i_view.m_index_count;
+    header.m_vertices_offset = alignUp( sizeof( Header ) + header.m_path_size, kCACHE_ALIGNMENT );
+    header.m_indices_offset  = alignUp( header.m_vertices_offset + uint64_t( i_view.m_vertex_count ) * sizeof( Vertex ), kCACHE_ALIGNMENT );
+    header.m_meshlet_count   = i_view.m_meshlet_count;
+    header.m_meshlets_offset = alignUp( header.m_indices_offset + uint64_t( i_view.m_index_count ) * sizeof( uint32_t ), kCACHE_ALIGNMENT );
+
+    for( uint32_t axis = 0; axis < 3; axis++ )
+    {
+        header.m_bounds_min[ axis ] = i_view.m_bounds_min[ axis ];
+        header.m_bounds_max[ axis ] = i_view.m_bounds_max[ axis ];
+    }
+
+    header.m_lod_count = i_view.m_lod_count;
+    std::copy( i_view.m_lods.begin(), i_view.m_lods.begin() + i_view.m_lod_count, header.m_lods );
+
+    const std::string cache_path = getCachePath( i_source_path );
+    const std::string temp_path  = cache_path + ".tmp";
+
+    //written aside and renamed, so a crash never leaves a truncated cache under the real name
+    {
+        std::ofstream file( temp_path, std::ios::binary | std::ios::trunc );
+
+        file.write( reinterpret_cast<const char*>( &header ), sizeof( Header ) );
+        file.write( i_source_path.data(), static_cast<std::streamsize>( i_source_path.size() ) );
+        padTo     ( file, header.m_vertices_offset );
+        file.write( reinterpret_cast<const char*>( i_view.m_vertices ), static_cast<std::streamsize>( uint64_t( i_view.m_vertex_count ) * sizeof( Vertex ) ) );
+        padTo     ( file, header.m_indices_offset );
+        file.write( reinterpret_cast<const char*>( i_view.m_indices ), static_cast<std::streamsize>( uint64_t( i_view.m_index_count ) * sizeof( uint32_t ) ) );
+        padTo     ( file, header.m_meshlets_offset );
+        file.write( reinterpret_cast<const char*>( i_view.m_meshlets ), static_cast<std::streamsize>( uint64_t( i_view.m_meshlet_count ) * sizeof( Meshlet ) ) );
+
+        if( !file )
+        {
+            std::cerr << tfm::format( "Mesh cache: could not write %s\n", temp_path );
+            file.close();
+            std::remove( temp_path.c_str() );
+            return;
+        }
+    }
+
+    std::remove( cache_path.c_str() );
+    if( std::rename( temp_path.c_str(), cache_path.c_str() ) != 0 )
+    {
+        std::cerr << tfm::format( "Mesh cache: could not move %s into place\n", temp_path );
+        std::remove( temp_path.c_str() );
+    }
+}
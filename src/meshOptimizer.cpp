@@ -0,0 +1,683 @@
+#include "meshOptimizer.h"
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    constexpr uint32_t kNONE = std::numeric_limits<uint32_t>::max();
+    constexpr float    kOVERDRAW_MAX_ACMR_LOSS = 1.05f;
+
+    //triangles using each vertex, as ranges of one flat list
+    struct Adjacency
+    {
+        std::vector<uint32_t> m_offsets;   //vertex count + 1
+        std::vector<uint32_t> m_triangles;
+    };
+
+    void buildAdjacency( const std::vector<uint32_t>& i_indices, const uint32_t i_vertex_count, Adjacency& o_adjacency )
+    {
+        o_adjacency.m_offsets.assign( i_vertex_count + 1, 0 );
+        o_adjacency.m_triangles.resize( i_indices.size() );
+
+        for( const uint32_t index : i_indices )
+        {
+            o_adjacency.m_offsets[ index + 1 ]++;
+        }
+
+        for( uint32_t vertex = 0; vertex < i_vertex_count; vertex++ )
+        {
+            o_adjacency.m_offsets[ vertex + 1 ] += o_adjacency.m_offsets[ vertex ];
+        }
+
+        std::vector<uint32_t> cursor( o_adjacency.m_offsets.begin(), o_adjacency.m_offsets.end() - 1 );
+
+        for( uint32_t idx = 0; idx < i_indices.size(); idx++ )
+        {
+            o_adjacency.m_triangles[ cursor[ i_indices[ idx ] ]++ ] = idx / 3;
+        }
+    }
+
+    //most recently used vertex that still has triangles left, or the next one in index order
+    uint32_t skipDeadEnd( std::vector<uint32_t>& io_dead_end, const std::vector<uint32_t>& i_live, uint32_t& io_cursor )
+    {
+        while( !io_dead_end.empty() )
+        {
+            const uint32_t vertex = io_dead_end.back();
+            io_dead_end.pop_back();
+
+            if( i_live[ vertex ] > 0 )
+            {
+                return vertex;
+            }
+        }
+
+        for( ; io_cursor < i_live.size(); io_cursor++ )
+        {
+            if( i_live[ io_cursor ] > 0 )
+            {
+                return io_cursor;
+            }
+        }
+
+        return kNONE;
+    }
+
+    //sum of squared distances to a set of planes, stored as the upper half of the symmetric 4x4 matrix
+    struct Quadric
+    {
+        double m_a2 = 0.0, m_ab = 0.0, m_ac = 0.0, m_ad = 0.0;
+        double m_b2 = 0.0, m_bc = 0.0, m_bd = 0.0;
+        double m_c2 = 0.0, m_cd = 0.0;
+        double m_d2 = 0.0;
+
+        void addPlane( const double i_a, const double i_b, const double i_c, const double i_d )
+        {
+            m_a2 += i_a * i_a; m_ab += i_a * i_b; m_ac += i_a * i_c; m_ad += i_a * i_d;
+            m_b2 += i_b * i_b; m_bc += i_b * i_c; m_bd += i_b * i_d;
+            m_c2 += i_c * i_c; m_cd += i_c * i_d;
+            m_d2 += i_d * i_d;
+        }
+
+        void add( const Quadric& i_other )
+        {
+            m_a2 += i_other.m_a2; m_ab += i_other.m_ab; m_ac += i_other.m_ac; m_ad += i_other.m_ad;
+            m_b2 += i_other.m_b2; m_bc += i_other.m_bc; m_bd += i_other.m_bd;
+            m_c2 += i_other.m_c2; m_cd += i_other.m_cd;
+            m_d2 += i_other.m_d2;
+        }
+
+        double evaluate( const Vector3f& i_point ) const
+        {
+            const double x = i_point.x, y = i_point.y, z = i_point.z;
+
+            const double error = m_a2 * x * x + 2.0 * m_ab * x * y + 2.0 * m_ac * x * z + 2.0 * m_ad * x
+                               + m_b2 * y * y + 2.0 * m_bc * y * z + 2.0 * m_bd * y
+                               + m_c2 * z * z + 2.0 * m_cd * z
+                               + m_d2;
+
+            return std::max( error, 0.0 );
+        }
+    };
+
+    struct Collapse
+    {
+        uint32_t m_from;
+        uint32_t m_to;
+        double   m_cost;
+    };
+
+    //vertices a collapse may not move: they share their position with another vertex, so moving one
+    //would open a seam, or they sit on an open border of the mesh
+    std::vector<bool> findLockedVertices( const std::vector<uint32_t>& i_indices, const std::vector<Vertex>& i_vertices )
+    {
+        std::vector<uint32_t>                   canonical( i_vertices.size() );
+        std::vector<bool>                       locked   ( i_vertices.size(), false );
+        std::unordered_map<Vector3f, uint32_t>  positions;
+
+        for( uint32_t vertex = 0; vertex < i_vertices.size(); vertex++ )
+        {
+            const auto inserted = positions.insert( { i_vertices[ vertex ].m_position, vertex } );
+            canonical[ vertex ] = inserted.first->second;
+
+            if( !inserted.second )
+            {
+                locked[ vertex ] = locked[ canonical[ vertex ] ] = true;
+            }
+        }
+
+        //an edge used by a single triangle is a border, counted on positions so seams do not look like borders
+        std::unordered_map<uint64_t, uint32_t> edges;
+        edges.reserve( i_indices.size() );
+
+        for( size_t idx = 0; idx < i_indices.size(); idx++ )
+        {
+            const uint32_t a = canonical[ i_indices[ idx ] ];
+            const uint32_t b = canonical[ i_indices[ idx % 3 == 2 ? idx - 2 : idx + 1 ] ];
+
+            edges[ ( uint64_t( std::min( a, b ) ) << 32 ) | std::max( a, b ) ]++;
+        }
+
+        for( const auto& edge : edges )
+        {
+            if( edge.second == 1 )
+            {
+                locked[ static_cast<uint32_t>( edge.first >> 32 ) ] = true;
+                locked[ static_cast<uint32_t>( edge.first       ) ] = true;
+            }
+        }
+
+        //a seam vertex is locked with all the vertices at its position
+        for( uint32_t vertex = 0; vertex < i_vertices.size(); vertex++ )
+        {
+            locked[ vertex ] = locked[ vertex ] || locked[ canonical[ vertex ] ];
+        }
+
+        return locked;
+    }
+
+    //false when moving i_from onto i_to folds one of the triangles that stay around i_from
+    bool keepsOrientation( const std::vector<uint32_t>& i_indices, const std::vector<Vertex>& i_vertices, const Adjacency& i_adjacency, const uint32_t i_from, const uint32_t i_to )
+    {
+        for( uint32_t adj = i_adjacency.m_offsets[ i_from ]; adj < i_adjacency.m_offsets[ i_from + 1 ]; adj++ )
+        {
+            const uint32_t* triangle = &i_indices[ i_adjacency.m_triangles[ adj ] * 3 ];
+
+            if( triangle[ 0 ] == i_to || triangle[ 1 ] == i_to || triangle[ 2 ] == i_to )
+            {
+                continue; //collapses away
+            }
+
+            Vector3f before[ 3 ];
+            Vector3f after [ 3 ];
+            for( uint32_t corner = 0; corner < 3; corner++ )
+            {
+                before[ corner ] = i_vertices[ triangle[ corner ] ].m_position;
+                after [ corner ] = triangle[ corner ] == i_from ? i_vertices[ i_to ].m_position : before[ corner ];
+            }
+
+            const Vector3f normal_before = glm::cross( before[ 1 ] - before[ 0 ], before[ 2 ] - before[ 0 ] );
+            const Vector3f normal_after  = glm::cross( after [ 1 ] - after [ 0 ], after [ 2 ] - after [ 0 ] );
+
+            if( glm::dot( normal_before, normal_after ) <= 0.0f )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //bounding sphere around the box of the vertices and the narrowest cone around the average normal
+    void computeMeshletBounds( const std::vector<uint32_t>& i_indices, const std::vector<Vertex>& i_vertices, Meshlet& io_meshlet )
+    {
+        const uint32_t begin = io_meshlet.m_index_offset;
+        const uint32_t end   = io_meshlet.m_index_offset + io_meshlet.m_index_count;
+
+        Vector3f box_min( i_vertices[ i_indices[ begin ] ].m_position );
+        Vector3f box_max( box_min );
+        Vector3f axis   ( 0.0f );
+
+        std::vector<Vector3f> normals;
+        normals.reserve( io_meshlet.m_index_count / 3 );
+
+        for( uint32_t idx = begin; idx < end; idx += 3 )
+        {
+            const Vector3f& p0 = i_vertices[ i_indices[ idx + 0 ] ].m_position;
+            const Vector3f& p1 = i_vertices[ i_indices[ idx + 1 ] ].m_position;
+            const Vector3f& p2 = i_vertices[ i_indices[ idx + 2 ] ].m_position;
+
+            box_min = glm::min( box_min, glm::min( p0, glm::min( p1, p2 ) ) );
+            box_max = glm::max( box_max, glm::max( p0, glm::max( p1, p2 ) ) );
+
+            const Vector3f cross  = glm::cross( p1 - p0, p2 - p0 );
+            const float    length = glm::length( cross );
+
+            if( length > 0.0f )
+            {
+                normals.push_back( cross / length );
+                axis += cross; //area weighted
+            }
+        }
+
+        const Vector3f center = ( box_min + box_max ) * 0.5f;
+        float          radius = 0.0f;
+
+        for( uint32_t idx = begin; idx < end; idx++ )
+        {
+            radius = std::max( radius, glm::length( i_vertices[ i_indices[ idx ] ].m_position - center ) );
+        }
+
+        io_meshlet.m_sphere = Vector4f( center, radius );
+
+        const float axis_length = glm::length( axis );
+        if( axis_length <= 0.0f )
+        {
+            return;
+        }
+
+        axis /= axis_length;
+
+        float min_dot = 1.0f;
+        for( const auto& normal : normals )
+        {
+            min_dot = std::min( min_dot, glm::dot( normal, axis ) );
+        }
+
+        //normals spread over more than a hemisphere, some triangle always faces the camera
+        io_meshlet.m_cone = Vector4f( axis, min_dot <= 0.0f ? 1.0f : std::sqrt( 1.0f - min_dot * min_dot ) );
+    }
+}
+
+
+void MeshOptimizer::optimizeVertexCache( std::vector<uint32_t>& io_indices, const uint32_t i_vertex_count, std::vector<uint32_t>& o_clusters )
+{
+    const uint32_t triangle_count = static_cast<uint32_t>( io_indices.size() / 3 );
+    const uint32_t cache_size     = kVERTEX_CACHE_SIZE;
+
+    o_clusters.clear();
+
+    if( triangle_count == 0 )
+    {
+        return;
+    }
+
+    Adjacency adjacency;
+    buildAdjacency( io_indices, i_vertex_count, adjacency );
+
+    std::vector<uint32_t> live( i_vertex_count );
+    for( uint32_t vertex = 0; vertex < i_vertex_count; vertex++ )
+    {
+        live[ vertex ] = adjacency.m_offsets[ vertex + 1 ] - adjacency.m_offsets[ vertex ];
+    }
+
+    std::vector<uint32_t> cache_time( i_vertex_count, 0 );
+    std::vector<bool>     emitted   ( triangle_count, false );
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve( io_indices.size() );
+
+    uint32_t time   = cache_size + 1;
+    uint32_t cursor = 0;
+    uint32_t fan    = skipDeadEnd( dead_end, live, cursor );
+
+    o_clusters.push_back( 0 );
+
+    while( fan != kNONE )
+    {
+        candidates.clear();
+
+        for( uint32_t adj = adjacency.m_offsets[ fan ]; adj < adjacency.m_offsets[ fan + 1 ]; adj++ )
+        {
+            const uint32_t triangle = adjacency.m_triangles[ adj ];
+            if( emitted[ triangle ] )
+            {
+                continue;
+            }
+
+            for( uint32_t corner = 0; corner < 3; corner++ )
+            {
+                const uint32_t vertex = io_indices[ triangle * 3 + corner ];
+
+                result    .push_back( vertex );
+                dead_end  .push_back( vertex );
+                candidates.push_back( vertex );
+                live[ vertex ]--;
+
+                if( time - cache_time[ vertex ] > cache_size )
+                {
+                    cache_time[ vertex ] = time++;
+                }
+            }
+
+            emitted[ triangle ] = true;
+        }
+
+        //the candidate that stays in the cache longest, with a fan of its own still to emit
+        uint32_t next     = kNONE;
+        uint32_t priority = 0;
+
+        for( const uint32_t vertex : candidates )
+        {
+            if( live[ vertex ] == 0 )
+            {
+                continue;
+            }
+
+            uint32_t candidate_priority = 0;
+            if( time - cache_time[ vertex ] + 2 * live[ vertex ] <= cache_size )
+            {
+                candidate_priority = time - cache_time[ vertex ];
+            }
+
+            if( next == kNONE || candidate_priority > priority )
+            {
+                next     = vertex;
+                priority = candidate_priority;
+            }
+        }
+
+        //nothing left around the fan is cached, the next run starts cold and may go anywhere in the draw
+        if( next == kNONE )
+        {
+            next = skipDeadEnd( dead_end, live, cursor );
+
+            if( next != kNONE )
+            {
+                o_clusters.push_back( static_cast<uint32_t>( result.size() / 3 ) );
+            }
+        }
+
+        fan = next;
+    }
+
+    assert( result.size() == io_indices.size() );
+    io_indices.swap( result );
+}
+
+
+void MeshOptimizer::optimizeOverdraw( std::vector<uint32_t>& io_indices, const std::vector<Vertex>& i_vertices, const std::vector<uint32_t>& i_clusters )
+{
+    const uint32_t triangle_count = static_cast<uint32_t>( io_indices.size() / 3 );
+
+    if( i_clusters.size() < 2 )
+    {
+        return;
+    }
+
+    struct Cluster
+    {
+        uint32_t m_begin;
+        uint32_t m_end;
+        Vector3f m_centroid;
+        Vector3f m_normal;
+        float    m_sort_key;
+    };
+
+    std::vector<Cluster> clusters( i_clusters.size() );
+
+    Vector3f mesh_centroid( 0.0f );
+    float    mesh_area = 0.0f;
+
+    for( size_t idx = 0; idx < clusters.size(); idx++ )
+    {
+        Cluster& cluster = clusters[ idx ];
+        cluster.m_begin    = i_clusters[ idx ];
+        cluster.m_end      = idx + 1 < i_clusters.size() ? i_clusters[ idx + 1 ] : triangle_count;
+        cluster.m_centroid = Vector3f( 0.0f );
+        cluster.m_normal   = Vector3f( 0.0f );
+
+        float area = 0.0f;
+
+        //area weighted, so slivers do not pull the cluster around
+        for( uint32_t triangle = cluster.m_begin; triangle < cluster.m_end; triangle++ )
+        {
+            const Vector3f& p0 = i_vertices[ io_indices[ triangle * 3 + 0 ] ].m_position;
+            const Vector3f& p1 = i_vertices[ io_indices[ triangle * 3 + 1 ] ].m_position;
+            const Vector3f& p2 = i_vertices[ io_indices[ triangle * 3 + 2 ] ].m_position;
+
+            const Vector3f cross         = glm::cross( p1 - p0, p2 - p0 );
+            const float    triangle_area = glm::length( cross ) * 0.5f;
+
+            cluster.m_centroid += ( p0 + p1 + p2 ) * ( triangle_area / 3.0f );
+            cluster.m_normal   += cross;
+            area               += triangle_area;
+        }
+
+        mesh_centroid += cluster.m_centroid;
+        mesh_area     += area;
+
+        if( area > 0.0f )
+        {
+            cluster.m_centroid /= area;
+        }
+    }
+
+    if( mesh_area > 0.0f )
+    {
+        mesh_centroid /= mesh_area;
+    }
+
+    for( auto& cluster : clusters )
+    {
+        const float length = glm::length( cluster.m_normal );
+        cluster.m_sort_key = length > 0.0f ? glm::dot( cluster.m_centroid - mesh_centroid, cluster.m_normal / length ) : 0.0f;
+    }
+
+    //the clusters mostly start with a cold cache, so reordering them costs few cache hits
+    std::stable_sort( clusters.begin(), clusters.end(), []( const Cluster& i_a, const Cluster& i_b ) { return i_a.m_sort_key > i_b.m_sort_key; } );
+
+    std::vector<uint32_t> result;
+    result.reserve( io_indices.size() );
+
+    for( const auto& cluster : clusters )
+    {
+        result.insert( result.end(), io_indices.begin() + cluster.m_begin * 3, io_indices.begin() + cluster.m_end * 3 );
+    }
+
+    //a run can start on a vertex that is still cached, when splitting those loses too much the order is kept
+    const uint32_t vertex_count = static_cast<uint32_t>( i_vertices.size() );
+    if( analyze( result, vertex_count ).m_acmr <= analyze( io_indices, vertex_count ).m_acmr * kOVERDRAW_MAX_ACMR_LOSS )
+    {
+        io_indices.swap( result );
+    }
+}
+
+
+void MeshOptimizer::optimizeVertexFetch( std::vector<uint32_t>& io_indices, std::vector<Vertex>& io_vertices )
+{
+    std::vector<uint32_t> remap( io_vertices.size(), kNONE );
+    std::vector<Vertex>   vertices;
+    vertices.reserve( io_vertices.size() );
+
+    for( auto& index : io_indices )
+    {
+        if( remap[ index ] == kNONE )
+        {
+            remap[ index ] = static_cast<uint32_t>( vertices.size() );
+            vertices.push_back( io_vertices[ index ] );
+        }
+
+        index = remap[ index ];
+    }
+
+    //vertices no triangle uses are dropped
+    io_vertices.swap( vertices );
+}
+
+
+MeshOptimizer::Stats MeshOptimizer::analyze( const std::vector<uint32_t>& i_indices, const uint32_t i_vertex_count )
+{
+    Stats stats;
+
+    if( i_indices.empty() || i_vertex_count == 0 )
+    {
+        return stats;
+    }
+
+    //a vertex is cached while fewer than kVERTEX_CACHE_SIZE misses happened since it was loaded
+    std::vector<uint32_t> loaded_at( i_vertex_count, 0 );
+    uint32_t              misses = 0;
+
+    for( const uint32_t index : i_indices )
+    {
+        if( loaded_at[ index ] == 0 || misses - loaded_at[ index ] >= kVERTEX_CACHE_SIZE )
+        {
+            misses++;
+            loaded_at[ index ] = misses;
+        }
+    }
+
+    stats.m_acmr = static_cast<float>( misses ) / static_cast<float>( i_indices.size() / 3 );
+    stats.m_atvr = static_cast<float>( misses ) / static_cast<float>( i_vertex_count );
+
+    return stats;
+}
+
+
+float MeshOptimizer::simplify( const std::vector<uint32_t>& i_indices, const std::vector<Vertex>& i_vertices, const uint32_t i_target_index_count, std::vector<uint32_t>& o_indices )
+{
+    const uint32_t    vertex_count = static_cast<uint32_t>( i_vertices.size() );
+    std::vector<bool> locked       = findLockedVertices( i_indices, i_vertices );
+
+    //unit planes, so the error of a collapse is in squared object space units
+    std::vector<Quadric> quadrics( vertex_count );
+
+    for( size_t idx = 0; idx < i_indices.size(); idx += 3 )
+    {
+        const Vector3f& p0 = i_vertices[ i_indices[ idx + 0 ] ].m_position;
+        const Vector3f& p1 = i_vertices[ i_indices[ idx + 1 ] ].m_position;
+        const Vector3f& p2 = i_vertices[ i_indices[ idx + 2 ] ].m_position;
+
+        const Vector3f cross  = glm::cross( p1 - p0, p2 - p0 );
+        const float    length = glm::length( cross );
+
+        if( length <= 0.0f )
+        {
+            continue;
+        }
+
+        const Vector3f normal = cross / length;
+
+        for( uint32_t corner = 0; corner < 3; corner++ )
+        {
+            quadrics[ i_indices[ idx + corner ] ].addPlane( normal.x, normal.y, normal.z, -glm::dot( normal, p0 ) );
+        }
+    }
+
+    o_indices = i_indices;
+
+    double                max_cost = 0.0;
+    Adjacency             adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap  ( vertex_count );
+    std::vector<bool>     touched( vertex_count );
+
+    //every pass collapses the cheapest edges that do not share a neighbourhood, then rebuilds the triangles
+    while( o_indices.size() > i_target_index_count )
+    {
+        buildAdjacency( o_indices, vertex_count, adjacency );
+
+        collapses.clear();
+        for( size_t idx = 0; idx < o_indices.size(); idx++ )
+        {
+            const uint32_t from = o_indices[ idx ];
+            const uint32_t to   = o_indices[ idx % 3 == 2 ? idx - 2 : idx + 1 ];
+
+            for( const auto& edge : { std::make_pair( from, to ), std::make_pair( to, from ) } )
+            {
+                if( !locked[ edge.first ] )
+                {
+                    Quadric quadric = quadrics[ edge.first ];
+                    quadric.add( quadrics[ edge.second ] );
+
+                    collapses.push_back( { edge.first, edge.second, quadric.evaluate( i_vertices[ edge.second ].m_position ) } );
+                }
+            }
+        }
+
+        std::sort( collapses.begin(), collapses.end(), []( const Collapse& i_a, const Collapse& i_b ) { return i_a.m_cost < i_b.m_cost; } );
+
+        for( uint32_t vertex = 0; vertex < vertex_count; vertex++ )
+        {
+            remap[ vertex ] = vertex;
+        }
+        std::fill( touched.begin(), touched.end(), false );
+
+        //a collapse removes about two triangles, stop at the target instead of overshooting it
+        const size_t budget = ( o_indices.size() - i_target_index_count ) / 6 + 1;
+        size_t       done   = 0;
+
+        for( const auto& collapse : collapses )
+        {
+            if( done >= budget )
+            {
+                break;
+            }
+
+            if( touched[ collapse.m_from ] || touched[ collapse.m_to ] || !keepsOrientation( o_indices, i_vertices, adjacency, collapse.m_from, collapse.m_to ) )
+            {
+                continue;
+            }
+
+            remap[ collapse.m_from ] = collapse.m_to;
+            quadrics[ collapse.m_to ].add( quadrics[ collapse.m_from ] );
+            max_cost = std::max( max_cost, collapse.m_cost );
+
+            //the orientation test of the next collapses assumes the triangles around them did not change
+            for( uint32_t adj = adjacency.m_offsets[ collapse.m_from ]; adj < adjacency.m_offsets[ collapse.m_from + 1 ]; adj++ )
+            {
+                for( uint32_t corner = 0; corner < 3; corner++ )
+                {
+                    touched[ o_indices[ adjacency.m_triangles[ adj ] * 3 + corner ] ] = true;
+                }
+            }
+
+            done++;
+        }
+
+        if( done == 0 )
+        {
+            break;
+        }
+
+        size_t write = 0;
+        for( size_t idx = 0; idx < o_indices.size(); idx += 3 )
+        {
+            const uint32_t a = remap[ o_indices[ idx + 0 ] ];
+            const uint32_t b = remap[ o_indices[ idx + 1 ] ];
+            const uint32_t c = remap[ o_indices[ idx + 2 ] ];
+
+            if( a != b && b != c && a != c )
+            {
+                o_indices[ write++ ] = a;
+                o_indices[ write++ ] = b;
+                o_indices[ write++ ] = c;
+            }
+        }
+
+        o_indices.resize( write );
+    }
+
+    return static_cast<float>( std::sqrt( max_cost ) );
+}
+
+
+void MeshOptimizer::buildMeshlets( const std::vector<uint32_t>& i_indices, const uint32_t i_index_offset, const uint32_t i_index_count, const std::vector<Vertex>& i_vertices, std::vector<Meshlet>& o_meshlets )
+{
+    o_meshlets.clear();
+
+    //last meshlet each vertex was counted in
+    std::vector<uint32_t> seen( i_vertices.size(), kNONE );
+
+    Meshlet  meshlet;
+    uint32_t vertex_count = 0;
+
+    meshlet.m_index_offset = i_index_offset;
+
+    const auto close = [ & ]()
+    {
+        if( meshlet.m_index_count > 0 )
+        {
+            computeMeshletBounds( i_indices, i_vertices, meshlet );
+            o_meshlets.push_back( meshlet );
+        }
+    };
+
+    for( uint32_t idx = i_index_offset; idx < i_index_offset + i_index_count; idx += 3 )
+    {
+        const uint32_t id = static_cast<uint32_t>( o_meshlets.size() );
+
+        uint32_t new_vertices = 0;
+        for( uint32_t corner = 0; corner < 3; corner++ )
+        {
+            new_vertices += seen[ i_indices[ idx + corner ] ] != id ? 1 : 0;
+        }
+
+        //a repeated corner of a degenerate triangle counts twice, which only closes the meshlet a bit early
+        if( vertex_count + new_vertices > kMESHLET_MAX_VERTICES || meshlet.m_index_count / 3 + 1 > kMESHLET_MAX_TRIANGLES )
+        {
+            close();
+
+            meshlet                = Meshlet();
+            meshlet.m_index_offset = idx;
+            vertex_count           = 0;
+        }
+
+        const uint32_t current = static_cast<uint32_t>( o_meshlets.size() );
+        for( uint32_t corner = 0; corner < 3; corner++ )
+        {
+            uint32_t& vertex_meshlet = seen[ i_indices[ idx + corner ] ];
+            if( vertex_meshlet != current )
+            {
+                vertex_meshlet = current;
+                vertex_count++;
+            }
+        }
+
+        meshlet.m_index_count += 3;
+    }
+
+    close();
+}
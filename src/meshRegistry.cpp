@@ -1,11 +1,165 @@
 #include "meshRegistry.h"
+#include "meshCache.h"
+#include "meshOptimizer.h"
+#include "runtime.h"
+#include "threadPool.h"
 #include "vulkan/meshVK.h"
+#include <cstring>
+#include <limits>
+#ifdef BENCHMARK_VERTEX_DEDUP
+#include <chrono>
+#endif
 
 using namespace MiniEngine;
 
 
 namespace 
 {
+    static_assert( sizeof( Vertex ) == 8 * sizeof( float ), "the vertex table hashes and compares vertices as 8 packed floats" );
+
+    //open addressing with linear probing over ids into the vertex array. it is sized once from the index
+    //count, which bounds the number of unique vertices, so it never grows and stays at most half full
+    class VertexTable final
+    {
+    public:
+        explicit VertexTable( const size_t i_max_vertices )
+        {
+            size_t capacity = 16;
+            while( capacity < i_max_vertices * 2 )
+            {
+                capacity *= 2;
+            }
+
+            m_slots.assign( capacity, kEMPTY );
+            m_mask = capacity - 1;
+        }
+
+        //id of a vertex equal in position, normal and uv, appending it to io_vertices when there is none
+        uint32_t insert( const Vertex& i_vertex, std::vector<Vertex>& io_vertices )
+        {
+            for( size_t slot = hash( i_vertex ) & m_mask; ; slot = ( slot + 1 ) & m_mask )
+            {
+                const uint32_t id = m_slots[ slot ];
+
+                if( id == kEMPTY )
+                {
+                    m_slots[ slot ] = static_cast<uint32_t>( io_vertices.size() );
+                    io_vertices.push_back( i_vertex );
+                    return m_slots[ slot ];
+                }
+
+                //bitwise, a vertex only merges with an exact copy of itself
+                if( memcmp( &io_vertices[ id ], &i_vertex, sizeof( Vertex ) ) == 0 )
+                {
+                    return id;
+                }
+            }
+        }
+
+    private:
+        static constexpr uint32_t kEMPTY = std::numeric_limits<uint32_t>::max();
+
+        static size_t hash( const Vertex& i_vertex )
+        {
+            uint32_t words[ 8 ];
+            memcpy( words, &i_vertex, sizeof( words ) );
+
+            uint64_t hash = 0;
+            for( const uint32_t word : words )
+            {
+                hash = ( hash ^ word ) * 0x9e3779b97f4a7c15ull;
+            }
+
+            return static_cast<size_t>( hash ^ ( hash >> 32 ) );
+        }
+
+        std::vector<uint32_t> m_slots;
+        size_t                m_mask = 0;
+    };
+
+    Vertex getVertex( const tinyobj::attrib_t& i_attrib, const tinyobj::index_t& i_index )
+    {
+        Vertex vertex;
+        vertex.m_position =
+        {
+             i_attrib.vertices[ 3 * i_index.vertex_index + 0 ],
+             i_attrib.vertices[ 3 * i_index.vertex_index + 1 ],
+             i_attrib.vertices[ 3 * i_index.vertex_index + 2 ] 
+        };
+
+        if( i_index.normal_index >= 0 )
+        {
+            vertex.m_normal =
+            {
+                 i_attrib.normals[ 3 * i_index.normal_index + 0 ],
+                 i_attrib.normals[ 3 * i_index.normal_index + 1 ],
+                 i_attrib.normals[ 3 * i_index.normal_index + 2 ]
+            };
+        }
+        
+        if( i_index.texcoord_index >= 0 )
+        {
+            vertex.m_uv =
+            {
+                i_attrib.texcoords[ 2 * i_index.texcoord_index + 0 ],
+                i_attrib.texcoords[ 2 * i_index.texcoord_index + 1 ]
+            };
+        }
+
+        return vertex;
+    }
+
+#ifdef BENCHMARK_VERTEX_DEDUP
+    //runs the former position only dedup next to the current one and prints time and vertex counts of both
+    void benchmarkDedup( const std::string& i_path, const tinyobj::attrib_t& i_attrib, const std::vector<tinyobj::shape_t>& i_shapes, const size_t i_index_count )
+    {
+        typedef std::chrono::high_resolution_clock Clock;
+
+        const auto legacy_start = Clock::now();
+
+        std::vector<Vertex>   legacy_vertices;
+        std::vector<uint32_t> legacy_indices;
+        std::unordered_map<glm::vec3, uint32_t> unique_vertices;
+
+        for( const auto& shape : i_shapes )
+        {
+            for( const auto& index : shape.mesh.indices )
+            {
+                const Vertex vertex = getVertex( i_attrib, index );
+
+                if( unique_vertices.count( vertex.m_position ) == 0 )
+                {
+                    unique_vertices[ vertex.m_position ] = static_cast< uint32_t >( legacy_vertices.size() );
+                    legacy_vertices.push_back( vertex );
+                }
+
+                legacy_indices.push_back( unique_vertices[ vertex.m_position ] );
+            }
+        }
+
+        const auto table_start = Clock::now();
+
+        std::vector<Vertex>   vertices;
+        std::vector<uint32_t> indices;
+        indices.reserve( i_index_count );
+
+        VertexTable table( i_index_count );
+        for( const auto& shape : i_shapes )
+        {
+            for( const auto& index : shape.mesh.indices )
+            {
+                indices.push_back( table.insert( getVertex( i_attrib, index ), vertices ) );
+            }
+        }
+
+        const auto table_end = Clock::now();
+
+        std::cout << tfm::format( "Dedup %s, %d indices\n", i_path, i_index_count );
+        std::cout << tfm::format( "    position map:  %8.2f ms, %d vertices\n", std::chrono::duration<double, std::milli>( table_start - legacy_start ).count(), legacy_vertices.size() );
+        std::cout << tfm::format( "    vertex table:  %8.2f ms, %d vertices\n", std::chrono::duration<double, std::milli>( table_end   - table_start  ).count(), vertices.size()        );
+    }
+#endif
+
     bool loadOBJ( const std::string& i_path, std::vector<Vertex>& o_vertices, std::vector<uint32>& o_indices )
     {
         tinyobj::attrib_t attrib;
@@ -25,69 +179,150 @@ namespace
         {
             throw MiniEngineException( "Failed to load/parse .obj.\n");
         }
-        
-        std::vector<Vertex> vertices;
-        std::vector<uint32_t> indices;
-        std::unordered_map<glm::vec3, uint32_t> unique_vertices;
+
+        size_t index_count = 0;
+        for( const auto& shape : shapes )
+        {
+            index_count += shape.mesh.indices.size();
+        }
+
+#ifdef BENCHMARK_VERTEX_DEDUP
+        benchmarkDedup( i_path, attrib, shapes, index_count );
+#endif
+
+        o_vertices.clear();
+        o_indices.clear();
+        o_indices.reserve( index_count );
+
+        VertexTable table( index_count );
 
         for( const auto& shape : shapes )
         {
             for( const auto& index : shape.mesh.indices )
             {   
-                Vertex vertex;
-                vertex.m_position =
-                {
-                     attrib.vertices[ 3 * index.vertex_index + 0 ],
-                     attrib.vertices[ 3 * index.vertex_index + 1 ],
-                     attrib.vertices[ 3 * index.vertex_index + 2 ] 
-                };
+                const Vertex vertex = getVertex( attrib, index );
+#ifdef PRINT_VERTICES
+                const size_t vertex_count = o_vertices.size();
+#endif
 
-                if( index.normal_index >= 0 )
-                {
-                    vertex.m_normal =
-                    {
-                         attrib.normals[ 3 * index.normal_index + 0 ],
-                         attrib.normals[ 3 * index.normal_index + 1 ],
-                         attrib.normals[ 3 * index.normal_index + 2 ]
-                    };
-                }
-                
-                if( index.texcoord_index >= 0 )
-                {
-                    vertex.m_uv =
-                    {
-                        attrib.texcoords[ 2 * index.texcoord_index + 0 ],
-                        attrib.texcoords[ 2 * index.texcoord_index + 1 ]
-                    };
-                }
+                o_indices.push_back( table.insert( vertex, o_vertices ) );
 
-                if( unique_vertices.count( vertex.m_position ) == 0 )
-                {
-                    unique_vertices[ vertex.m_position ] = static_cast< uint32_t >( vertices.size() );
-                    vertices.push_back( vertex );
 #ifdef PRINT_VERTICES
+                if( o_vertices.size() != vertex_count )
+                {
                     std::cout << "NEW VERTEX" << std::endl;
                     std::cout << "pos: x: " << vertex.m_position.x << ", y: " << vertex.m_position.y << ", z: " << vertex.m_position.z << std::endl;
-                    std::cout << "normal: x: " << vertex.m_position.x << ", y: " << vertex.m_position.y << ", z: " << vertex.m_position.z << std::endl;
+                    std::cout << "normal: x: " << vertex.m_normal.x << ", y: " << vertex.m_normal.y << ", z: " << vertex.m_normal.z << std::endl;
                     std::cout << "uv: x: " << vertex.m_uv.x << ", y: " << vertex.m_uv.y << std::endl;
-#endif
                 }
-
-                indices.push_back( unique_vertices[ vertex.m_position ] );
+#endif
             }
         }
 
-        o_indices = indices;
-        o_vertices = vertices;
         return true;
     }
+
+    //the result is what the mesh cache stores, so this only runs when an obj is parsed
+    void optimizeMesh( const std::string& i_path, std::vector<Vertex>& io_vertices, std::vector<uint32>& io_indices )
+    {
+        const uint32_t             vertex_count = static_cast<uint32_t>( io_vertices.size() );
+        const MeshOptimizer::Stats before       = MeshOptimizer::analyze( io_indices, vertex_count );
+
+        std::vector<uint32_t> clusters;
+        MeshOptimizer::optimizeVertexCache( io_indices, vertex_count, clusters );
+        MeshOptimizer::optimizeOverdraw   ( io_indices, io_vertices, clusters );
+        MeshOptimizer::optimizeVertexFetch( io_indices, io_vertices );
+
+        const MeshOptimizer::Stats after = MeshOptimizer::analyze( io_indices, static_cast<uint32_t>( io_vertices.size() ) );
+
+        std::cout << tfm::format( "Mesh %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", i_path, before.m_acmr, after.m_acmr, before.m_atvr, after.m_atvr );
+    }
+
+    //appends coarser copies of the optimized full mesh to io_indices, each about half the triangles of the
+    //previous one. the chain stops early when locked borders and seams keep a level from shrinking enough
+    void buildLods( const std::string& i_path, const std::vector<Vertex>& i_vertices, std::vector<uint32>& io_indices, std::array<MeshLod, kMAX_MESH_LODS>& o_lods, uint32_t& o_lod_count )
+    {
+        o_lods[ 0 ].m_index_offset = 0;
+        o_lods[ 0 ].m_index_count  = static_cast<uint32_t>( io_indices.size() );
+        o_lods[ 0 ].m_error        = 0.0f;
+        o_lod_count = 1;
+
+        std::vector<uint32_t> previous( io_indices );
+        std::vector<uint32_t> lod;
+        std::vector<uint32_t> clusters;
+
+        while( o_lod_count < kMAX_MESH_LODS )
+        {
+            const uint32_t target = static_cast<uint32_t>( previous.size() / 6 * 3 );
+            const float    error  = MeshOptimizer::simplify( previous, i_vertices, target, lod );
+
+            if( lod.empty() || lod.size() > previous.size() * 8 / 10 )
+            {
+                break;
+            }
+
+            MeshOptimizer::optimizeVertexCache( lod, static_cast<uint32_t>( i_vertices.size() ), clusters );
+
+            MeshLod& level = o_lods[ o_lod_count++ ];
+            level.m_index_offset = static_cast<uint32_t>( io_indices.size() );
+            level.m_index_count  = static_cast<uint32_t>( lod.size() );
+            //every level is simplified from the previous one, so the errors add up
+            level.m_error        = o_lods[ o_lod_count - 2 ].m_error + error;
+
+            io_indices.insert( io_indices.end(), lod.begin(), lod.end() );
+            previous.swap( lod );
+        }
+
+        std::string levels;
+        for( uint32_t level = 0; level < o_lod_count; level++ )
+        {
+            levels += tfm::format( " %d (%g)", o_lods[ level ].m_index_count / 3, o_lods[ level ].m_error );
+        }
+
+        std::cout << tfm::format( "Mesh %s: lod triangles (error)%s\n", i_path, levels );
+    }
+
+    void computeBounds( const std::vector<Vertex>& i_vertices, Vector3f& o_min, Vector3f& o_max )
+    {
+        o_min = i_vertices.empty() ? Vector3f( 0.0f ) : i_vertices.front().m_position;
+        o_max = o_min;
+
+        for( const Vertex& vertex : i_vertices )
+        {
+            o_min = glm::min( o_min, vertex.m_position );
+            o_max = glm::max( o_max, vertex.m_position );
+        }
+    }
+
+    //16 bits while every index fits below 0xffff, which stays clear of the primitive restart value.
+    //the indices are relative to the mesh, the draws add its vertex offset in the arena
+    VkIndexType selectIndexType( const uint32_t i_vertex_count )
+    {
+        return i_vertex_count <= UINT16_MAX ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
 }
 
 
 
-std::shared_ptr<MeshVK> MeshRegistry::loadMesh( const std::string& i_path )
+//either the cache mapping or the parsed arrays back the view, until the mesh is uploaded
+struct MeshRegistry::Geometry
+{
+    MappedFile          m_cache_file;
+    MeshCache::View     m_view;
+    std::vector<uint32>  m_indices;
+    std::vector<Vertex>  m_vertices;
+    std::vector<Meshlet> m_meshlets;
+};
+
+
+std::shared_ptr<MeshVK> MeshRegistry::loadMesh( const std::string& i_path, const VertexFormat i_format )
 {
-    auto mesh = m_meshes.find( i_path );
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    //two loads of the same file would both parse it and race on writing its cache
+    m_preloaded.wait( lock, [ & ]() { return m_preloading.count( i_path ) == 0; } );
+
+    auto mesh = m_meshes.find( getMeshKey( i_path, i_format ) );
 
     //handle already exist
     if( mesh != m_meshes.end() )
@@ -95,28 +330,171 @@ std::shared_ptr<MeshVK> MeshRegistry::loadMesh( const std::string& i_path )
         return mesh->second;
     }
 
-    //new handle
-    std::vector<uint32> indices;
-    std::vector<Vertex> vertices;
+    //new handle. when another format of the path is loaded already its load stored the cache, so this maps it
+    Geometry geometry;
+    loadGeometry( i_path, geometry );
+
+    return createMesh( i_path, i_format, geometry );
+}
+
+
+void MeshRegistry::preloadMeshes( const std::vector<MeshRequest>& i_meshes )
+{
+    std::vector<MeshRequest> meshes;
+    std::vector<std::string> paths;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        //an other preload may be reading some of the same files
+        m_preloaded.wait( lock, [ & ]()
+        {
+            return std::none_of( i_meshes.begin(), i_meshes.end(), [ this ]( const MeshRequest& i_mesh ) { return m_preloading.count( i_mesh.first ) > 0; } );
+        } );
+
+        for( const auto& mesh : i_meshes )
+        {
+            if( m_meshes.count( getMeshKey( mesh.first, mesh.second ) ) == 0 && std::find( meshes.begin(), meshes.end(), mesh ) == meshes.end() )
+            {
+                meshes.push_back( mesh );
+
+                //formats of one file share its geometry
+                if( std::find( paths.begin(), paths.end(), mesh.first ) == paths.end() )
+                {
+                    paths.push_back( mesh.first );
+                }
+            }
+        }
+
+        m_preloading.insert( paths.begin(), paths.end() );
+    }
+
+    //mapped files can not be moved, so every load keeps its own slot
+    std::vector<std::unique_ptr<Geometry>> geometries( paths.size() );
+    std::vector<ThreadPool::Job>           jobs;
+    jobs.reserve( paths.size() );
+
+    for( size_t idx = 0; idx < paths.size(); idx++ )
+    {
+        geometries[ idx ] = std::make_unique<Geometry>();
+        jobs.push_back( [ &paths, &geometries, idx ]() { loadGeometry( paths[ idx ], *geometries[ idx ] ); } );
+    }
+
+    //the paths have to be given back even when a file fails to load, or the loads waiting on them never return
+    auto finish = [ this, &paths ]()
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            for( const auto& path : paths )
+            {
+                m_preloading.erase( path );
+            }
+        }
+        m_preloaded.notify_all();
+    };
+
+    try
+    {
+        m_runtime.m_thread_pool->run( jobs );
+
+        //buffers, memory and upload recording stay on one thread, the copies go out in the batches of the upload manager
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        for( size_t idx = 0; idx < paths.size(); idx++ )
+        {
+            for( const auto& mesh : meshes )
+            {
+                if( mesh.first == paths[ idx ] )
+                {
+                    createMesh( mesh.first, mesh.second, *geometries[ idx ] );
+                }
+            }
+
+            //the uploads staged their own copies, so the arrays or the cache mapping go now instead of
+            //keeping every file of the batch in memory until the last one is created
+            geometries[ idx ].reset();
+        }
+    }
+    catch( ... )
+    {
+        finish();
+        throw;
+    }
+
+    finish();
+}
+
+
+void MeshRegistry::loadGeometry( const std::string& i_path, Geometry& o_geometry )
+{
+    //uploaded straight from the cache mapping when there is a valid one
+    if( MeshCache::load( i_path, o_geometry.m_cache_file, o_geometry.m_view ) )
+    {
+        return;
+    }
 
-    if( !::loadOBJ( i_path, vertices, indices ) )
+    if( !::loadOBJ( i_path, o_geometry.m_vertices, o_geometry.m_indices ) )
     {
         throw MiniEngineException( "Error while loading obj" );
     }
 
-    std::shared_ptr<MeshVK> new_mesh = std::make_shared<MeshVK>( m_runtime, i_path, indices, vertices );
+    MeshCache::View& view = o_geometry.m_view;
+
+    ::optimizeMesh( i_path, o_geometry.m_vertices, o_geometry.m_indices );
+    ::buildLods   ( i_path, o_geometry.m_vertices, o_geometry.m_indices, view.m_lods, view.m_lod_count );
+
+    MeshOptimizer::buildMeshlets( o_geometry.m_indices, view.m_lods[ 0 ].m_index_offset, view.m_lods[ 0 ].m_index_count, o_geometry.m_vertices, o_geometry.m_meshlets );
+
+    view.m_vertices     = o_geometry.m_vertices.data();
+    view.m_vertex_count = static_cast<uint32_t>( o_geometry.m_vertices.size() );
+    view.m_indices      = o_geometry.m_indices.data();
+    view.m_index_count  = static_cast<uint32_t>( o_geometry.m_indices.size() );
+    view.m_meshlets      = o_geometry.m_meshlets.data();
+    view.m_meshlet_count = static_cast<uint32_t>( o_geometry.m_meshlets.size() );
+    ::computeBounds( o_geometry.m_vertices, view.m_bounds_min, view.m_bounds_max );
+
+    MeshCache::store( i_path, view );
+}
+
+
+//expects m_mutex to be held
+std::shared_ptr<MeshVK> MeshRegistry::createMesh( const std::string& i_path, const VertexFormat i_format, const Geometry& i_geometry )
+{
+    std::shared_ptr<MeshVK> new_mesh = std::make_shared<MeshVK>( m_runtime, i_path, i_geometry.m_view, i_format, m_position_streams, ::selectIndexType( i_geometry.m_view.m_vertex_count ) );
     new_mesh->initialize();
 
-    m_meshes.insert( { i_path, new_mesh } );
+    m_meshes.insert( { getMeshKey( i_path, i_format ), new_mesh } );
 
     return new_mesh;
 }
 
 
+//the float layout keeps the plain path
+std::string MeshRegistry::getMeshKey( const std::string& i_path, const VertexFormat i_format )
+{
+    return i_format == VertexFormat::Float ? i_path : i_path + "#" + VertexLayouts::getFormatName( i_format );
+}
+
+
 MeshRegistry::MeshRegistry( const Runtime& i_runtime ) :
     m_runtime( i_runtime ),
-    m_meshes({})
+    m_meshes({}),
+    m_position_streams( true )
+{
+}
+
+
+void MeshRegistry::createBLAS()
 {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    for( auto& mesh_block : m_meshes )
+    {
+        if( mesh_block.second->getBLAS() == VK_NULL_HANDLE )
+        {
+            mesh_block.second->createBLASBuffer();
+        }
+    }
 }
 
 
@@ -128,6 +506,8 @@ bool MeshRegistry::initialize()
 
 void MeshRegistry::shutdown()
 {
+    std::lock_guard<std::mutex> lock( m_mutex );
+
     for( auto mesh_block : m_meshes )
     {
         mesh_block.second->shutdown();
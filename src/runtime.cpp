@@ -13,13 +13,20 @@ void Runtime::createResources()
     {
         if( VK_NULL_HANDLE == m_per_frame_buffer[ id ] )
         {
-            UtilsVK::createBuffer( *m_renderer->getDevice(), sizeof( PerFrameData ), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_per_frame_buffer[ id ], m_per_frame_buffer_memory[ id ] );
+            //the screen space compute passes read the camera from it on the async queue
+            UtilsVK::createBuffer( *m_renderer->getDevice(), sizeof( PerFrameData ), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_per_frame_buffer[ id ], m_per_frame_buffer_memory[ id ], true );
         }
 
         if( VK_NULL_HANDLE == m_per_object_buffer[ id ] )
         {
             UtilsVK::createBuffer( *m_renderer->getDevice(), sizeof( PerObjectData ) * kMAX_NUMBER_OF_OBJECTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_per_object_buffer[ id ], m_per_object_buffer_memory[ id ] );
         }
+
+        //mapped once here and written in place every frame, nothing maps or unmaps them afterwards
+        if( m_per_frame_buffer_memory[ id ].m_mapped == nullptr || m_per_object_buffer_memory[ id ].m_mapped == nullptr )
+        {
+            throw MiniEngineException( "Per frame buffers of slot %d are not mapped", id );
+        }
     }
     
 }
@@ -31,18 +38,12 @@ void Runtime::freeResources()
     {
         if( VK_NULL_HANDLE != m_per_frame_buffer[ id ] )
         {
-            vkDestroyBuffer( m_renderer->getDevice()->getLogicalDevice(), m_per_frame_buffer       [ id ], nullptr );
-            vkFreeMemory   ( m_renderer->getDevice()->getLogicalDevice(), m_per_frame_buffer_memory[ id ], nullptr );
-
-            m_per_frame_buffer[ id ] = VK_NULL_HANDLE;
+            UtilsVK::freeBuffer( *m_renderer->getDevice(), m_per_frame_buffer[ id ], m_per_frame_buffer_memory[ id ] );
         }
 
         if( VK_NULL_HANDLE != m_per_object_buffer[ id ] )
         {
-            vkDestroyBuffer( m_renderer->getDevice()->getLogicalDevice(), m_per_object_buffer       [ id ], nullptr );
-            vkFreeMemory   ( m_renderer->getDevice()->getLogicalDevice(), m_per_object_buffer_memory[ id ], nullptr );
-
-            m_per_object_buffer[ id ] = VK_NULL_HANDLE;
+            UtilsVK::freeBuffer( *m_renderer->getDevice(), m_per_object_buffer[ id ], m_per_object_buffer_memory[ id ] );
         }
     }
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "light.h"
 #include "entity.h"
 #include "common.h"
+#include "meshRegistry.h"
+#include "runtime.h"
 
 
 using namespace MiniEngine;
@@ -137,6 +139,18 @@ std::shared_ptr<Scene> Scene::loadScene( const Runtime& i_runtime, const std::st
      CameraPtr camera = Camera::createCamera( i_runtime, scene_node.child("camera") );
      scene->m_camera = camera;
      
+     //parse every obj of the scene at once, the entities below only pick up the loaded meshes
+     std::vector<MeshRegistry::MeshRequest> meshes;
+     for(pugi::xml_node node = scene_node.child("mesh"); node; node = node.next_sibling("mesh"))
+     {
+         if( !node.child("emitter") && strcmp( node.attribute("type").value(), "obj" ) == 0 && node.find_child_by_attribute( "name", "filename" ) )
+         {
+             meshes.push_back( { node.find_child_by_attribute( "name", "filename" ).attribute("value").value(), Entity::getVertexFormat( node ) } );
+         }
+     }
+
+     i_runtime.m_mesh_registry->preloadMeshes( meshes );
+
      uint32_t entity_id = 0;
      //parse objects
      for(pugi::xml_node node = scene_node.child("mesh"); node; node = node.next_sibling("mesh"))
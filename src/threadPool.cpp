@@ -0,0 +1,140 @@
+#include "threadPool.h"
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    thread_local uint32_t t_thread_index = 0;
+}
+
+
+ThreadPool::ThreadPool( const uint32_t i_worker_count ) :
+    m_stop( false )
+{
+    m_workers.reserve( i_worker_count );
+
+    for( uint32_t idx = 0; idx < i_worker_count; idx++ )
+    {
+        m_workers.emplace_back( &ThreadPool::workerLoop, this, idx + 1 );
+    }
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stop = true;
+    }
+
+    m_condition.notify_all();
+
+    for( auto& worker : m_workers )
+    {
+        worker.join();
+    }
+}
+
+
+void ThreadPool::run( const std::vector<Job>& i_jobs )
+{
+    if( i_jobs.empty() )
+    {
+        return;
+    }
+
+    Batch batch;
+    batch.m_pending = static_cast<uint32_t>( i_jobs.size() );
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    for( const auto& job : i_jobs )
+    {
+        m_queue.push_back( { &job, &batch } );
+    }
+
+    m_condition.notify_all();
+
+    //help with whatever is queued, it may belong to another batch but it is what keeps nested runs from deadlocking
+    while( batch.m_pending > 0 )
+    {
+        if( !m_queue.empty() )
+        {
+            const Task task = m_queue.front();
+            m_queue.pop_front();
+
+            lock.unlock();
+            execute( task );
+            lock.lock();
+            continue;
+        }
+
+        m_condition.wait( lock, [ & ]() { return batch.m_pending == 0 || !m_queue.empty(); } );
+    }
+
+    lock.unlock();
+
+    if( batch.m_error )
+    {
+        std::rethrow_exception( batch.m_error );
+    }
+}
+
+
+uint32_t ThreadPool::getThreadIndex()
+{
+    return t_thread_index;
+}
+
+
+void ThreadPool::workerLoop( const uint32_t i_thread_index )
+{
+    t_thread_index = i_thread_index;
+
+    while( true )
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_condition.wait( lock, [ this ]() { return m_stop || !m_queue.empty(); } );
+
+            if( m_stop && m_queue.empty() )
+            {
+                return;
+            }
+
+            task = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        execute( task );
+    }
+}
+
+
+void ThreadPool::execute( const Task& i_task )
+{
+    std::exception_ptr error;
+
+    try
+    {
+        ( *i_task.m_job )();
+    }
+    catch( ... )
+    {
+        error = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( error && !i_task.m_batch->m_error )
+    {
+        i_task.m_batch->m_error = error;
+    }
+
+    if( --i_task.m_batch->m_pending == 0 )
+    {
+        m_condition.notify_all();
+    }
+}
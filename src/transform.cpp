@@ -5,6 +5,7 @@ using namespace MiniEngine;
 
 Transform::Transform() : 
     m_dirty( true ),
+    m_version( 0 ),
     m_transform_matrix( Matrix4f( 1.f ) ),
     m_inverse_transform( Matrix4f( 1.f ) )
 {
@@ -15,6 +16,17 @@ Transform::Transform( const Matrix4f& i_mat )
     m_transform_matrix = i_mat;
     m_inverse_transform = m_transform_matrix;
     m_dirty = false;
+    m_version = 0;
+}
+
+Transform& Transform::operator=( const Transform& i_other )
+{
+    m_dirty = i_other.m_dirty;
+    m_version++;
+    m_transform_matrix = i_other.m_transform_matrix;
+    m_inverse_transform = i_other.m_inverse_transform;
+
+    return *this;
 }
 
 bool Transform::initialize()
@@ -48,6 +60,7 @@ Matrix4f Transform::getInverseTransform()
 void Transform::translate( const Vector3f& i_translation )
 {
     m_dirty = true;
+    m_version++;
     m_transform_matrix = glm::translate( m_transform_matrix, i_translation );
 }
         
@@ -55,6 +68,7 @@ void Transform::translate( const Vector3f& i_translation )
 void Transform::rotate( const RotAxis& i_rotation )
 {
     m_dirty = true;
+    m_version++;
     m_transform_matrix = glm::rotate( m_transform_matrix, i_rotation.m_angle, i_rotation.m_axis );
 }
         
@@ -62,6 +76,7 @@ void Transform::rotate( const RotAxis& i_rotation )
 void Transform::scale( const Vector3f& i_scale )
 {
     m_dirty = true;
+    m_version++;
     m_transform_matrix = glm::scale( m_transform_matrix, i_scale );
 }
 
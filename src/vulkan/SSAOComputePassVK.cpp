@@ -0,0 +1,326 @@
+#include "common.h"
+#include "vulkan/utilsVK.h"
+#include "vulkan/SSAOComputePassVK.h"
+#include "vulkan/rendererVK.h"
+#include "vulkan/deviceVK.h"
+#include "vulkan/windowVK.h"
+#include "runtime.h"
+#include "frame.h"
+#include "shaderRegistry.h"
+#include "vulkan/profilerVK.h"
+
+#include <random>
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    //must match the local size of ssao.comp
+    constexpr uint32_t kGROUP_SIZE = 8;
+}
+
+
+SSAOComputePassVK::SSAOComputePassVK(
+    const Runtime& i_runtime,
+    const ImageBlock& i_in_position_depth_attachment,
+    const ImageBlock& i_in_normal_attachment,
+    const ImageBlock& i_out_ssao
+                                    ) :
+    RenderPassVK( i_runtime ),
+    m_pipeline                    ( VK_NULL_HANDLE ),
+    m_pipeline_layout             ( VK_NULL_HANDLE ),
+    m_descriptor_set_layout       ( VK_NULL_HANDLE ),
+    m_descriptor_pool             ( VK_NULL_HANDLE ),
+    m_kernel_buffer               ( VK_NULL_HANDLE ),
+    m_in_position_depth_attachment( i_in_position_depth_attachment ),
+    m_in_normal_attachment        ( i_in_normal_attachment         ),
+    m_out_ssao                    ( i_out_ssao                     )
+{
+}
+
+
+SSAOComputePassVK::~SSAOComputePassVK()
+{
+}
+
+
+bool SSAOComputePassVK::initialize()
+{
+    createKernel  ();
+    createPipeline();
+
+    initializeCommandBuffers( kMAX_NUMBER_OF_FRAMES );
+
+    return true;
+}
+
+
+void SSAOComputePassVK::shutdown()
+{
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    shutdownCommandBuffers();
+
+    vkDestroyDescriptorPool     ( renderer.getDevice()->getLogicalDevice(), m_descriptor_pool      , nullptr );
+    vkDestroyDescriptorSetLayout( renderer.getDevice()->getLogicalDevice(), m_descriptor_set_layout, nullptr );
+    vkDestroyPipeline           ( renderer.getDevice()->getLogicalDevice(), m_pipeline             , nullptr );
+    vkDestroyPipelineLayout     ( renderer.getDevice()->getLogicalDevice(), m_pipeline_layout      , nullptr );
+
+    UtilsVK::freeBuffer( *renderer.getDevice(), m_kernel_buffer, m_kernel_memory );
+}
+
+
+VkCommandBuffer SSAOComputePassVK::draw( const Frame& i_frame )
+{
+    VkCommandBuffer current_cmd = getCachedCommandBuffer( i_frame, i_frame.m_frame_index );
+    if( current_cmd != VK_NULL_HANDLE )
+    {
+        return current_cmd;
+    }
+
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    current_cmd = allocateCommandBuffer( i_frame.m_frame_index );
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+    uint32_t width = 0, height = 0;
+    renderer.getWindow().getWindowSize( width, height );
+
+    if( vkBeginCommandBuffer( current_cmd, &begin_info ) != VK_SUCCESS )
+    {
+        throw MiniEngineException( "failed to begin recording command buffer!" );
+    }
+
+    const uint32_t scope = m_runtime.m_profiler->beginRegion( current_cmd, i_frame, "SSAO Pass", Vector4f( 0.5f, 0.5f, 0.0f, 1.0f ), renderer.getDevice()->getComputeQueueFamilyIndex() );
+
+    vkCmdBindPipeline      ( current_cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline );
+    vkCmdBindDescriptorSets( current_cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &m_descriptor_sets[ i_frame.m_frame_index ], 0, nullptr );
+    vkCmdDispatch          ( current_cmd, ( width + kGROUP_SIZE - 1 ) / kGROUP_SIZE, ( height + kGROUP_SIZE - 1 ) / kGROUP_SIZE, 1 );
+
+    m_runtime.m_profiler->endRegion( current_cmd, i_frame, scope );
+
+    if( vkEndCommandBuffer( current_cmd ) != VK_SUCCESS )
+    {
+        throw MiniEngineException( "failed to record command buffer!" );
+    }
+
+    cacheCommandBuffer( i_frame.m_frame_index, current_cmd, scope );
+
+    return current_cmd;
+}
+
+
+void SSAOComputePassVK::resize()
+{
+    //the dispatch size follows the window
+    updateAttachmentDescriptors();
+    RenderPassVK::resize();
+}
+
+
+void SSAOComputePassVK::createKernel()
+{
+    std::vector<Vector4f> samples( kSSAO_KERNEL_SIZE );
+
+    std::default_random_engine            generator;
+    std::uniform_real_distribution<float> distribution( 0.0f, 1.0f );
+
+    //hemisphere around +z, denser close to the pixel
+    for( uint32_t i = 0; i < kSSAO_KERNEL_SIZE; i++ )
+    {
+        Vector3f sample( distribution( generator ) * 2.0f - 1.0f, distribution( generator ) * 2.0f - 1.0f, distribution( generator ) );
+        sample = glm::normalize( sample ) * distribution( generator );
+
+        float scale = static_cast<float>( i ) / static_cast<float>( kSSAO_KERNEL_SIZE );
+        scale       = 0.1f + scale * scale * 0.9f;
+
+        samples[ i ] = Vector4f( sample * scale, 0.0f );
+    }
+
+    //host visible and shared with the compute family, so no upload and no ownership transfer
+    UtilsVK::createBuffer(
+        *m_runtime.m_renderer->getDevice(),
+        sizeof( Vector4f ) * kSSAO_KERNEL_SIZE,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        m_kernel_buffer,
+        m_kernel_memory,
+        true );
+
+    memcpy( m_kernel_memory.m_mapped, samples.data(), sizeof( Vector4f ) * kSSAO_KERNEL_SIZE );
+}
+
+
+void SSAOComputePassVK::createPipeline()
+{
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    VkShaderModule comp_module = m_runtime.m_shader_registry->loadShader( "./shaders/ssao_c.spv", VK_SHADER_STAGE_COMPUTE_BIT );
+
+    assert( VK_NULL_HANDLE != comp_module );
+
+    createDescriptorLayout();
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount         = 1;
+    pipeline_layout_info.pSetLayouts            = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 0;
+
+    if( VK_SUCCESS != vkCreatePipelineLayout( renderer.getDevice()->getLogicalDevice(), &pipeline_layout_info, nullptr, &m_pipeline_layout ) )
+    {
+        throw MiniEngineException( "Error creating the pipeline layout" );
+    }
+
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = comp_module;
+    pipeline_info.stage.pName  = "main";
+    pipeline_info.layout       = m_pipeline_layout;
+
+    if( VK_SUCCESS != vkCreateComputePipelines( renderer.getDevice()->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipeline ) )
+    {
+        throw MiniEngineException( "Error creating the pipeline" );
+    }
+
+    createDescriptors();
+}
+
+
+void SSAOComputePassVK::createDescriptorLayout()
+{
+    std::array<VkDescriptorSetLayoutBinding, 5> layout_bindings{};
+
+    const std::array<VkDescriptorType, 5> types = {
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         //per frame
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, //positions and depth
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, //view space normals
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         //kernel
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE           //occlusion
+    };
+
+    for( uint32_t binding = 0; binding < static_cast<uint32_t>( layout_bindings.size() ); binding++ )
+    {
+        layout_bindings[ binding ].binding         = binding;
+        layout_bindings[ binding ].descriptorCount = 1;
+        layout_bindings[ binding ].descriptorType  = types[ binding ];
+        layout_bindings[ binding ].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo set_info = {};
+    set_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    set_info.bindingCount = static_cast<uint32_t>( layout_bindings.size() );
+    set_info.pBindings    = layout_bindings.data();
+
+    if( VK_SUCCESS != vkCreateDescriptorSetLayout( m_runtime.m_renderer->getDevice()->getLogicalDevice(), &set_info, nullptr, &m_descriptor_set_layout ) )
+    {
+        throw MiniEngineException( "Error creating descriptor set" );
+    }
+}
+
+
+void SSAOComputePassVK::createDescriptors()
+{
+    std::vector<VkDescriptorPoolSize> sizes =
+    {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER        , kMAX_NUMBER_OF_FRAMES     },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, kMAX_NUMBER_OF_FRAMES * 2 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER        , kMAX_NUMBER_OF_FRAMES     },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE         , kMAX_NUMBER_OF_FRAMES     }
+    };
+
+    VkDescriptorPoolCreateInfo pool_info = {};
+    pool_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets       = kMAX_NUMBER_OF_FRAMES;
+    pool_info.poolSizeCount = static_cast<uint32_t>( sizes.size() );
+    pool_info.pPoolSizes    = sizes.data();
+
+    if( VK_SUCCESS != vkCreateDescriptorPool( m_runtime.m_renderer->getDevice()->getLogicalDevice(), &pool_info, nullptr, &m_descriptor_pool ) )
+    {
+        throw MiniEngineException( "Error creating descriptor pool" );
+    }
+
+    for( uint32_t i = 0; i < kMAX_NUMBER_OF_FRAMES; i++ )
+    {
+        VkDescriptorSetAllocateInfo alloc_info = {};
+        alloc_info.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool     = m_descriptor_pool;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts        = &m_descriptor_set_layout;
+
+        vkAllocateDescriptorSets( m_runtime.m_renderer->getDevice()->getLogicalDevice(), &alloc_info, &m_descriptor_sets[ i ] );
+
+        VkDescriptorBufferInfo per_frame_info;
+        per_frame_info.buffer = m_runtime.getPerFrameBuffer()[ i ];
+        per_frame_info.offset = 0;
+        per_frame_info.range  = sizeof( PerFrameData );
+
+        VkDescriptorBufferInfo kernel_info;
+        kernel_info.buffer = m_kernel_buffer;
+        kernel_info.offset = 0;
+        kernel_info.range  = sizeof( Vector4f ) * kSSAO_KERNEL_SIZE;
+
+        std::array<VkWriteDescriptorSet, 2> set_write{};
+
+        set_write[ 0 ].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        set_write[ 0 ].dstBinding      = 0;
+        set_write[ 0 ].dstSet          = m_descriptor_sets[ i ];
+        set_write[ 0 ].descriptorCount = 1;
+        set_write[ 0 ].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        set_write[ 0 ].pBufferInfo     = &per_frame_info;
+
+        set_write[ 1 ].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        set_write[ 1 ].dstBinding      = 3;
+        set_write[ 1 ].dstSet          = m_descriptor_sets[ i ];
+        set_write[ 1 ].descriptorCount = 1;
+        set_write[ 1 ].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        set_write[ 1 ].pBufferInfo     = &kernel_info;
+
+        vkUpdateDescriptorSets( m_runtime.m_renderer->getDevice()->getLogicalDevice(), static_cast<uint32_t>( set_write.size() ), set_write.data(), 0, nullptr );
+    }
+
+    updateAttachmentDescriptors();
+}
+
+
+void SSAOComputePassVK::updateAttachmentDescriptors()
+{
+    std::array<VkDescriptorImageInfo, 3> image_infos;
+    image_infos[ 0 ].sampler     = m_in_position_depth_attachment.m_sampler;
+    image_infos[ 0 ].imageView   = m_in_position_depth_attachment.m_image_view;
+    image_infos[ 0 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    image_infos[ 1 ].sampler     = m_in_normal_attachment.m_sampler;
+    image_infos[ 1 ].imageView   = m_in_normal_attachment.m_image_view;
+    image_infos[ 1 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    //written in the general layout the render graph leaves storage images in
+    image_infos[ 2 ].sampler     = VK_NULL_HANDLE;
+    image_infos[ 2 ].imageView   = m_out_ssao.m_image_view;
+    image_infos[ 2 ].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    const std::array<uint32_t, 3>         bindings = { 1, 2, 4 };
+    const std::array<VkDescriptorType, 3> types    = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE };
+
+    for( uint32_t i = 0; i < kMAX_NUMBER_OF_FRAMES; i++ )
+    {
+        std::array<VkWriteDescriptorSet, 3> set_write{};
+
+        for( uint32_t idx = 0; idx < static_cast<uint32_t>( set_write.size() ); idx++ )
+        {
+            set_write[ idx ].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            set_write[ idx ].dstBinding      = bindings[ idx ];
+            set_write[ idx ].dstSet          = m_descriptor_sets[ i ];
+            set_write[ idx ].descriptorCount = 1;
+            set_write[ idx ].descriptorType  = types[ idx ];
+            set_write[ idx ].pImageInfo      = &image_infos[ idx ];
+        }
+
+        vkUpdateDescriptorSets( m_runtime.m_renderer->getDevice()->getLogicalDevice(), static_cast<uint32_t>( set_write.size() ), set_write.data(), 0, nullptr );
+    }
+}
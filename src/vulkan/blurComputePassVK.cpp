@@ -0,0 +1,236 @@
+#include "common.h"
+#include "vulkan/utilsVK.h"
+#include "vulkan/blurComputePassVK.h"
+#include "vulkan/rendererVK.h"
+#include "vulkan/deviceVK.h"
+#include "vulkan/windowVK.h"
+#include "runtime.h"
+#include "frame.h"
+#include "shaderRegistry.h"
+#include "vulkan/profilerVK.h"
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    //must match the local size of blur.comp
+    constexpr uint32_t kGROUP_SIZE = 8;
+}
+
+
+BlurComputePassVK::BlurComputePassVK(
+    const Runtime& i_runtime,
+    const ImageBlock& i_in_image,
+    const ImageBlock& i_out_image
+                                    ) :
+    RenderPassVK( i_runtime ),
+    m_pipeline             ( VK_NULL_HANDLE ),
+    m_pipeline_layout      ( VK_NULL_HANDLE ),
+    m_descriptor_set_layout( VK_NULL_HANDLE ),
+    m_descriptor_pool      ( VK_NULL_HANDLE ),
+    m_descriptor_set       ( VK_NULL_HANDLE ),
+    m_in_image             ( i_in_image     ),
+    m_out_image            ( i_out_image    )
+{
+}
+
+
+BlurComputePassVK::~BlurComputePassVK()
+{
+}
+
+
+bool BlurComputePassVK::initialize()
+{
+    createPipeline();
+
+    //the recording is the same for every slot, but each one carries the profiler region of its frame
+    initializeCommandBuffers( kMAX_NUMBER_OF_FRAMES );
+
+    return true;
+}
+
+
+void BlurComputePassVK::shutdown()
+{
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    shutdownCommandBuffers();
+
+    vkDestroyDescriptorPool     ( renderer.getDevice()->getLogicalDevice(), m_descriptor_pool      , nullptr );
+    vkDestroyDescriptorSetLayout( renderer.getDevice()->getLogicalDevice(), m_descriptor_set_layout, nullptr );
+    vkDestroyPipeline           ( renderer.getDevice()->getLogicalDevice(), m_pipeline             , nullptr );
+    vkDestroyPipelineLayout     ( renderer.getDevice()->getLogicalDevice(), m_pipeline_layout      , nullptr );
+}
+
+
+VkCommandBuffer BlurComputePassVK::draw( const Frame& i_frame )
+{
+    VkCommandBuffer current_cmd = getCachedCommandBuffer( i_frame, i_frame.m_frame_index );
+    if( current_cmd != VK_NULL_HANDLE )
+    {
+        return current_cmd;
+    }
+
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    current_cmd = allocateCommandBuffer( i_frame.m_frame_index );
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+    uint32_t width = 0, height = 0;
+    renderer.getWindow().getWindowSize( width, height );
+
+    if( vkBeginCommandBuffer( current_cmd, &begin_info ) != VK_SUCCESS )
+    {
+        throw MiniEngineException( "failed to begin recording command buffer!" );
+    }
+
+    const uint32_t scope = m_runtime.m_profiler->beginRegion( current_cmd, i_frame, "Blur Pass", Vector4f( 0.5f, 0.5f, 0.5f, 1.0f ), renderer.getDevice()->getComputeQueueFamilyIndex() );
+
+    vkCmdBindPipeline      ( current_cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline );
+    vkCmdBindDescriptorSets( current_cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &m_descriptor_set, 0, nullptr );
+    vkCmdDispatch          ( current_cmd, ( width + kGROUP_SIZE - 1 ) / kGROUP_SIZE, ( height + kGROUP_SIZE - 1 ) / kGROUP_SIZE, 1 );
+
+    m_runtime.m_profiler->endRegion( current_cmd, i_frame, scope );
+
+    if( vkEndCommandBuffer( current_cmd ) != VK_SUCCESS )
+    {
+        throw MiniEngineException( "failed to record command buffer!" );
+    }
+
+    cacheCommandBuffer( i_frame.m_frame_index, current_cmd, scope );
+
+    return current_cmd;
+}
+
+
+void BlurComputePassVK::resize()
+{
+    updateAttachmentDescriptors();
+    RenderPassVK::resize();
+}
+
+
+void BlurComputePassVK::createPipeline()
+{
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    VkShaderModule comp_module = m_runtime.m_shader_registry->loadShader( "./shaders/blur_c.spv", VK_SHADER_STAGE_COMPUTE_BIT );
+
+    assert( VK_NULL_HANDLE != comp_module );
+
+    createDescriptorLayout();
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount         = 1;
+    pipeline_layout_info.pSetLayouts            = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 0;
+
+    if( VK_SUCCESS != vkCreatePipelineLayout( renderer.getDevice()->getLogicalDevice(), &pipeline_layout_info, nullptr, &m_pipeline_layout ) )
+    {
+        throw MiniEngineException( "Error creating the pipeline layout" );
+    }
+
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = comp_module;
+    pipeline_info.stage.pName  = "main";
+    pipeline_info.layout       = m_pipeline_layout;
+
+    if( VK_SUCCESS != vkCreateComputePipelines( renderer.getDevice()->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipeline ) )
+    {
+        throw MiniEngineException( "Error creating the pipeline" );
+    }
+
+    createDescriptors();
+}
+
+
+void BlurComputePassVK::createDescriptorLayout()
+{
+    std::array<VkDescriptorSetLayoutBinding, 2> layout_bindings{};
+
+    layout_bindings[ 0 ].binding         = 0;
+    layout_bindings[ 0 ].descriptorCount = 1;
+    layout_bindings[ 0 ].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    layout_bindings[ 0 ].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    layout_bindings[ 1 ].binding         = 1;
+    layout_bindings[ 1 ].descriptorCount = 1;
+    layout_bindings[ 1 ].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    layout_bindings[ 1 ].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo set_info = {};
+    set_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    set_info.bindingCount = static_cast<uint32_t>( layout_bindings.size() );
+    set_info.pBindings    = layout_bindings.data();
+
+    if( VK_SUCCESS != vkCreateDescriptorSetLayout( m_runtime.m_renderer->getDevice()->getLogicalDevice(), &set_info, nullptr, &m_descriptor_set_layout ) )
+    {
+        throw MiniEngineException( "Error creating descriptor set" );
+    }
+}
+
+
+void BlurComputePassVK::createDescriptors()
+{
+    std::vector<VkDescriptorPoolSize> sizes =
+    {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE         , 1 }
+    };
+
+    VkDescriptorPoolCreateInfo pool_info = {};
+    pool_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets       = 1;
+    pool_info.poolSizeCount = static_cast<uint32_t>( sizes.size() );
+    pool_info.pPoolSizes    = sizes.data();
+
+    if( VK_SUCCESS != vkCreateDescriptorPool( m_runtime.m_renderer->getDevice()->getLogicalDevice(), &pool_info, nullptr, &m_descriptor_pool ) )
+    {
+        throw MiniEngineException( "Error creating descriptor pool" );
+    }
+
+    VkDescriptorSetAllocateInfo alloc_info = {};
+    alloc_info.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool     = m_descriptor_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts        = &m_descriptor_set_layout;
+
+    vkAllocateDescriptorSets( m_runtime.m_renderer->getDevice()->getLogicalDevice(), &alloc_info, &m_descriptor_set );
+
+    updateAttachmentDescriptors();
+}
+
+
+void BlurComputePassVK::updateAttachmentDescriptors()
+{
+    std::array<VkDescriptorImageInfo, 2> image_infos;
+    image_infos[ 0 ].sampler     = m_in_image.m_sampler;
+    image_infos[ 0 ].imageView   = m_in_image.m_image_view;
+    image_infos[ 0 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    image_infos[ 1 ].sampler     = VK_NULL_HANDLE;
+    image_infos[ 1 ].imageView   = m_out_image.m_image_view;
+    image_infos[ 1 ].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    std::array<VkWriteDescriptorSet, 2> set_write{};
+
+    for( uint32_t binding = 0; binding < static_cast<uint32_t>( set_write.size() ); binding++ )
+    {
+        set_write[ binding ].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        set_write[ binding ].dstBinding      = binding;
+        set_write[ binding ].dstSet          = m_descriptor_set;
+        set_write[ binding ].descriptorCount = 1;
+        set_write[ binding ].descriptorType  = binding == 0 ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        set_write[ binding ].pImageInfo      = &image_infos[ binding ];
+    }
+
+    vkUpdateDescriptorSets( m_runtime.m_renderer->getDevice()->getLogicalDevice(), static_cast<uint32_t>( set_write.size() ), set_write.data(), 0, nullptr );
+}
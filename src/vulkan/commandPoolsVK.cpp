@@ -0,0 +1,104 @@
+#include "vulkan/commandPoolsVK.h"
+#include "vulkan/rendererVK.h"
+#include "vulkan/deviceVK.h"
+#include "runtime.h"
+#include "threadPool.h"
+
+using namespace MiniEngine;
+
+
+CommandPoolsVK::CommandPoolsVK( const Runtime& i_runtime, const uint32_t i_thread_count, const uint32_t i_slot_count, const bool i_transient, const uint32_t i_queue_family_index ) :
+    m_runtime           ( i_runtime            ),
+    m_thread_count      ( i_thread_count       ),
+    m_slot_count        ( i_slot_count         ),
+    m_transient         ( i_transient          ),
+    m_queue_family_index( i_queue_family_index )
+{
+}
+
+
+bool CommandPoolsVK::initialize()
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    m_pools.resize( m_thread_count * m_slot_count );
+
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType             = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.queueFamilyIndex  = m_queue_family_index;
+    pool_info.flags             = m_transient ? VK_COMMAND_POOL_CREATE_TRANSIENT_BIT : 0;
+
+    for( auto& pool : m_pools )
+    {
+        if( vkCreateCommandPool( device.getLogicalDevice(), &pool_info, nullptr, &pool.m_pool ) != VK_SUCCESS )
+        {
+            throw MiniEngineException( "Error creating the per thread command pools" );
+        }
+    }
+
+    return true;
+}
+
+
+void CommandPoolsVK::shutdown()
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    //destroying the pool frees its command buffers
+    for( auto& pool : m_pools )
+    {
+        vkDestroyCommandPool( device.getLogicalDevice(), pool.m_pool, nullptr );
+    }
+
+    m_pools.clear();
+}
+
+
+void CommandPoolsVK::reset( const uint32_t i_slot )
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    assert( i_slot < m_slot_count );
+
+    for( uint32_t thread_idx = 0; thread_idx < m_thread_count; thread_idx++ )
+    {
+        ThreadPoolVK& pool = m_pools[ i_slot * m_thread_count + thread_idx ];
+
+        if( pool.m_used[ 0 ] + pool.m_used[ 1 ] > 0 )
+        {
+            vkResetCommandPool( device.getLogicalDevice(), pool.m_pool, 0 );
+            pool.m_used = { 0, 0 };
+        }
+    }
+}
+
+
+VkCommandBuffer CommandPoolsVK::getCommandBuffer( const uint32_t i_slot, const VkCommandBufferLevel i_level )
+{
+    const uint32_t thread_idx = ThreadPool::getThreadIndex();
+
+    assert( thread_idx < m_thread_count && i_slot < m_slot_count );
+
+    ThreadPoolVK&                 pool    = m_pools[ i_slot * m_thread_count + thread_idx ];
+    std::vector<VkCommandBuffer>& buffers = pool.m_buffers[ i_level ];
+    uint32_t&                     used    = pool.m_used   [ i_level ];
+
+    if( used == buffers.size() )
+    {
+        VkCommandBufferAllocateInfo allocate_info{};
+        allocate_info.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocate_info.commandPool        = pool.m_pool;
+        allocate_info.level              = i_level;
+        allocate_info.commandBufferCount = 1;
+
+        VkCommandBuffer command_buffer;
+        if( vkAllocateCommandBuffers( m_runtime.m_renderer->getDevice()->getLogicalDevice(), &allocate_info, &command_buffer ) != VK_SUCCESS )
+        {
+            throw MiniEngineException( "Error allocating a command buffer for thread %d", thread_idx );
+        }
+
+        buffers.push_back( command_buffer );
+    }
+
+    return buffers[ used++ ];
+}
@@ -10,6 +10,8 @@
 #include "meshRegistry.h"
 #include "entity.h"
 #include "vulkan/meshVK.h"
+#include "vulkan/profilerVK.h"
+#include "vulkan/commandPoolsVK.h"
 
 using namespace MiniEngine;
 
@@ -21,8 +23,9 @@ CompositionPassVK::CompositionPassVK(
     const ImageBlock& i_in_normal_attachment,
     const ImageBlock& i_in_material_attachment,
 	const ImageBlock& i_in_shadow_attachment,
+    const ImageBlock& i_in_ambient_occlusion,
 	const VkAccelerationStructureKHR& i_tlas,
-    const std::array<ImageBlock, 3>& i_output_swap_images 
+    const std::vector<ImageBlock>& i_output_swap_images 
                           ) :
     RenderPassVK( i_runtime ),
     m_in_color_attachment         ( i_in_color_attachment     ),
@@ -30,13 +33,10 @@ CompositionPassVK::CompositionPassVK(
     m_in_normal_attachment        ( i_in_normal_attachment    ),
     m_in_material_attachment      ( i_in_material_attachment  ),
 	m_in_shadow_attachment(i_in_shadow_attachment),
+    m_in_ambient_occlusion        ( i_in_ambient_occlusion    ),
 	m_tlas(i_tlas),
     m_output_swap_images( i_output_swap_images ) 
 {
-    for( auto cmd : m_command_buffer )
-    {
-        cmd = VK_NULL_HANDLE;
-    }
 }
 
 
@@ -58,7 +58,9 @@ bool CompositionPassVK::initialize()
     {
         { // difuse
             VkShaderModule vert_module = m_runtime.m_shader_registry->loadShader( "./shaders/composition_v.spv", VK_SHADER_STAGE_VERTEX_BIT   );
-            VkShaderModule frag_module = m_runtime.m_shader_registry->loadShader( "./shaders/composition_f.spv", VK_SHADER_STAGE_FRAGMENT_BIT );
+            //the ray query variant needs the device to support it even if it never traces
+            const bool     ray_tracing = renderer.getDevice()->supportsRayTracing();
+            VkShaderModule frag_module = m_runtime.m_shader_registry->loadShader( ray_tracing ? "./shaders/composition_f.spv" : "./shaders/composition_f_raster.spv", VK_SHADER_STAGE_FRAGMENT_BIT );
 
             assert( VK_NULL_HANDLE != vert_module && VK_NULL_HANDLE != frag_module );
 
@@ -83,14 +85,7 @@ bool CompositionPassVK::initialize()
     createPipelines ();
     createFbo       ();
 
-    VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
-
-    commandBufferAllocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    commandBufferAllocateInfo.commandPool        = renderer.getDevice()->getCommandPool();
-    commandBufferAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    commandBufferAllocateInfo.commandBufferCount = 3;
-    
-    vkAllocateCommandBuffers( renderer.getDevice()->getLogicalDevice(), &commandBufferAllocateInfo, m_command_buffer.data() );
+    initializeCommandBuffers( kMAX_NUMBER_OF_FRAMES * static_cast<uint32_t>( m_output_swap_images.size() ) );
 
     return true;
 }
@@ -100,15 +95,16 @@ void CompositionPassVK::shutdown()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
-    vkFreeCommandBuffers( renderer.getDevice()->getLogicalDevice(), renderer.getDevice()->getCommandPool(), m_command_buffer.size(), m_command_buffer.data() );
-    
+    shutdownCommandBuffers();
+
     vkDestroyDescriptorPool     ( renderer.getDevice()->getLogicalDevice(), m_descriptor_pool      , nullptr );
     vkDestroyDescriptorSetLayout( renderer.getDevice()->getLogicalDevice(), m_descriptor_set_layout, nullptr );
 
-    for( uint32 id = 0; id < static_cast<uint32>( renderer.getWindow().getImageCount() ); id++ )
+    for( uint32 id = 0; id < static_cast<uint32>( m_fbos.size() ); id++ )
     {
         vkDestroyFramebuffer   ( renderer.getDevice()->getLogicalDevice(), m_fbos[ id ], nullptr );
     }
+    m_fbos.clear();
     
     vkDestroyPipeline      ( renderer.getDevice()->getLogicalDevice(), m_composition_pipeline, nullptr );
     vkDestroyPipelineLayout( renderer.getDevice()->getLogicalDevice(), m_pipeline_layouts    , nullptr );
@@ -119,28 +115,32 @@ void CompositionPassVK::shutdown()
 
 VkCommandBuffer CompositionPassVK::draw( const Frame& i_frame)
 {
-    RendererVK& renderer = *m_runtime.m_renderer;
-
-    VkCommandBuffer& current_cmd = m_command_buffer[ renderer.getWindow().getCurrentImageId() ];
+    //the output fbo follows the swap chain image, so recordings are kept per slot and image
+    const uint32_t key = ( i_frame.m_frame_index * static_cast<uint32_t>( m_output_swap_images.size() ) + i_frame.m_image_index );
 
+    VkCommandBuffer current_cmd = getCachedCommandBuffer( i_frame, key );
     if( current_cmd != VK_NULL_HANDLE )
     {
-        VkCommandBufferResetFlags flags{};        
-        vkResetCommandBuffer( current_cmd, flags );
+        return current_cmd;
     }
 
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    current_cmd = allocateCommandBuffer( key );
+
     VkCommandBufferBeginInfo begin_info{};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
     uint32_t width = 0, height = 0;
     renderer.getWindow().getWindowSize( width, height );
+    const VkExtent2D extent{ width, height };
 
     VkRenderPassBeginInfo render_pass_info{};
     render_pass_info.sType                = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     render_pass_info.renderPass           = m_render_pass;
-    render_pass_info.framebuffer          = m_fbos[ renderer.getWindow().getCurrentImageId()];
+    render_pass_info.framebuffer          = m_fbos[ i_frame.m_image_index ];
     render_pass_info.renderArea.offset    = { 0, 0 };
-    render_pass_info.renderArea.extent    = { width, height };
+    render_pass_info.renderArea.extent    = extent;
 
     VkClearValue clear_values;
     clear_values.color = { { 0.0f, 0.0f, 0.2f, 1.0f } };
@@ -153,27 +153,49 @@ VkCommandBuffer CompositionPassVK::draw( const Frame& i_frame)
         throw MiniEngineException( "failed to begin recording command buffer!" );
     }
     
-    UtilsVK::beginRegion( current_cmd, "Composition Pass", Vector4f( 0.5f, 0.0f, 0.0f, 1.0f ) );
+    const uint32_t scope = m_runtime.m_profiler->beginRegion( current_cmd, i_frame, "Composition Pass", Vector4f( 0.5f, 0.0f, 0.0f, 1.0f ) );
     vkCmdBeginRenderPass( current_cmd, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE );
 
     vkCmdBindPipeline( current_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_composition_pipeline );
-    vkCmdBindDescriptorSets( current_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layouts, 0, 1, &m_descriptor_sets[ renderer.getWindow().getCurrentImageId() ].m_textures_descriptor, 0, NULL);
+    setViewportAndScissor( current_cmd, extent );
+    vkCmdBindDescriptorSets( current_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline_layouts, 0, 1, &m_descriptor_sets[ i_frame.m_frame_index ].m_textures_descriptor, 0, NULL);
 				
     m_plane->draw( current_cmd, 0 );
     
     vkCmdEndRenderPass( current_cmd );
-    UtilsVK::endRegion( current_cmd );
+    m_runtime.m_profiler->endRegion( current_cmd, i_frame, scope );
 
     if( vkEndCommandBuffer( current_cmd ) != VK_SUCCESS )
     {
         throw MiniEngineException( "failed to record command buffer!" );
     }
 
+    cacheCommandBuffer( key, current_cmd, scope );
+
     return current_cmd;
 }
 
 
 
+void CompositionPassVK::resize()
+{
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    for( uint32 id = 0; id < static_cast<uint32>( m_fbos.size() ); id++ )
+    {
+        vkDestroyFramebuffer( renderer.getDevice()->getLogicalDevice(), m_fbos[ id ], nullptr );
+    }
+    m_fbos.clear();
+
+    //the new swap chain may not have the same number of images, which changes the recording keys
+    createFbo                  ();
+    updateAttachmentDescriptors();
+
+    shutdownCommandBuffers  ();
+    initializeCommandBuffers( kMAX_NUMBER_OF_FRAMES * static_cast<uint32_t>( m_output_swap_images.size() ) );
+}
+
+
 void CompositionPassVK::createFbo()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
@@ -181,6 +203,8 @@ void CompositionPassVK::createFbo()
     uint32_t width = 0, height = 0;
     renderer.getWindow().getWindowSize( width, height );
 
+    m_fbos.resize( m_output_swap_images.size() );
+
     for( size_t i = 0; i < m_fbos.size(); i++ )
     {
         std::array<VkImageView, 1> attachments;
@@ -219,7 +243,7 @@ void CompositionPassVK::createRenderPass()
     attachments[ 0 ].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachments[ 0 ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     attachments[ 0 ].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachments[ 0 ].finalLayout    = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    attachments[ 0 ].finalLayout    = renderer.getWindow().getOutputLayout();
 
     VkAttachmentReference color_reference = {};
     color_reference.attachment = 0;
@@ -350,30 +374,22 @@ void CompositionPassVK::createPipelines()
     multisampling.flags                 = 0;
 
 
-    uint32 width = 0, height = 0;
-    renderer.getWindow().getWindowSize( width, height );
-    VkExtent2D extend{ width, height };
-
-    VkViewport viewport{};
-    viewport.x          = 0.0f;
-    viewport.y          = 0.0f;
-    viewport.width      = (float) width;
-    viewport.height     = (float) height;
-    viewport.minDepth   = 0.0f;
-    viewport.maxDepth   = 1.0f;
-    
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = extend;
-
+    //a fullscreen quad over whatever the swap chain extent is when recording
     VkPipelineViewportStateCreateInfo viewport_state{};
     viewport_state.sType            = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewport_state.viewportCount    = 1;
-    viewport_state.pViewports       = &viewport;
+    viewport_state.pViewports       = nullptr;
     viewport_state.scissorCount     = 1;
-    viewport_state.pScissors        = &scissor;
+    viewport_state.pScissors        = nullptr;
     viewport_state.flags            = 0;
 
+    std::array<VkDynamicState, 2> dynamic_states = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    VkPipelineDynamicStateCreateInfo dynamic_state{};
+    dynamic_state.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>( dynamic_states.size() );
+    dynamic_state.pDynamicStates    = dynamic_states.data();
+
     VkPipelineDepthStencilStateCreateInfo depth_stencil{};
     depth_stencil.sType                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
     depth_stencil.depthTestEnable       = VK_FALSE;
@@ -403,7 +419,7 @@ void CompositionPassVK::createPipelines()
     pipeline_info.pMultisampleState     = &multisampling;
     pipeline_info.pViewportState        = &viewport_state;
     pipeline_info.pDepthStencilState    = &depth_stencil;
-    pipeline_info.pDynamicState         = VK_NULL_HANDLE;
+    pipeline_info.pDynamicState         = &dynamic_state;
     pipeline_info.stageCount            = m_shader_stages.size();
     pipeline_info.pStages               = m_shader_stages.data();
     pipeline_info.flags                 = 0;
@@ -425,7 +441,7 @@ void CompositionPassVK::createPipelines()
 
 void CompositionPassVK::createDescriptorLayout()
 {
-    std::array<VkDescriptorSetLayoutBinding, 7> layout_bindings;
+    std::array<VkDescriptorSetLayoutBinding, 8> layout_bindings;
 
     ////// PER FRAME
     layout_bindings[ 0 ] = {};
@@ -471,10 +487,24 @@ void CompositionPassVK::createDescriptorLayout()
     layout_bindings[6].descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
     layout_bindings[6].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
+    //ambient occlusion
+    layout_bindings[ 7 ] = {};
+    layout_bindings[ 7 ].binding                      = 7;
+    layout_bindings[ 7 ].descriptorCount              = 1;
+    layout_bindings[ 7 ].descriptorType               = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    layout_bindings[ 7 ].stageFlags                   = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    //without ray tracing there is no TLAS binding, the ambient occlusion keeps binding 7
+    const bool ray_tracing = m_runtime.m_renderer->getDevice()->supportsRayTracing();
+    if( !ray_tracing )
+    {
+        layout_bindings[ 6 ] = layout_bindings[ 7 ];
+    }
+
     VkDescriptorSetLayoutCreateInfo set_attachment_color_info = {};
     set_attachment_color_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
     set_attachment_color_info.pNext        = nullptr;
-    set_attachment_color_info.bindingCount = layout_bindings.size();
+    set_attachment_color_info.bindingCount = ray_tracing ? layout_bindings.size() : layout_bindings.size() - 1;
     set_attachment_color_info.flags        = 0;
     set_attachment_color_info.pBindings    = layout_bindings.data();
 
@@ -488,12 +518,19 @@ void CompositionPassVK::createDescriptorLayout()
 void CompositionPassVK::createDescriptors()
 {
     //create a descriptor pool that will hold 10 uniform buffers
+    const bool ray_tracing = m_runtime.m_renderer->getDevice()->supportsRayTracing();
+
     std::vector<VkDescriptorPoolSize> sizes =
     {
         { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER        , 10 },
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10 }
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 20 }
     };
 
+    if( ray_tracing )
+    {
+        sizes.push_back( { VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, kMAX_NUMBER_OF_FRAMES } );
+    }
+
     VkDescriptorPoolCreateInfo pool_info = {};
     pool_info.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.flags                      = 0;
@@ -507,7 +544,7 @@ void CompositionPassVK::createDescriptors()
     }
 
     //create descriptors for the global buffers
-    for( uint32_t i = 0; i < m_runtime.m_renderer->getWindow().getImageCount(); i++ )
+    for( uint32_t i = 0; i < kMAX_NUMBER_OF_FRAMES; i++ )
     {   
         //globals per frame
         VkDescriptorSetAllocateInfo alloc_per_frame_info = {};
@@ -525,27 +562,6 @@ void CompositionPassVK::createDescriptors()
         binfo.offset    = 0;
         binfo.range     = sizeof( PerFrameData );
 
-        std::array<VkDescriptorImageInfo, 5> image_infos;
-        image_infos[ 0 ].sampler     = m_in_color_attachment.m_sampler;
-        image_infos[ 0 ].imageView   = m_in_color_attachment.m_image_view;
-        image_infos[ 0 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-        image_infos[ 1 ].sampler     = m_in_position_depth_attachment.m_sampler;
-        image_infos[ 1 ].imageView   = m_in_position_depth_attachment.m_image_view;
-        image_infos[ 1 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-        image_infos[ 2 ].sampler     = m_in_normal_attachment.m_sampler;
-        image_infos[ 2 ].imageView   = m_in_normal_attachment.m_image_view;
-        image_infos[ 2 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-        image_infos[ 3 ].sampler     = m_in_material_attachment.m_sampler;
-        image_infos[ 3 ].imageView   = m_in_material_attachment.m_image_view;
-        image_infos[ 3 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-		image_infos[4].sampler = m_in_shadow_attachment.m_sampler;
-		image_infos[4].imageView = m_in_shadow_attachment.m_image_view;
-		image_infos[4].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
         VkWriteDescriptorSetAccelerationStructureKHR writeDescriptorSetAccelerationStructure{}; 
 
         writeDescriptorSetAccelerationStructure.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
@@ -554,7 +570,7 @@ void CompositionPassVK::createDescriptors()
         
 
 
-        std::array<VkWriteDescriptorSet, 7> set_write;
+        std::array<VkWriteDescriptorSet, 2> set_write;
 
         set_write[ 0 ]                   = {};
         set_write[ 0 ].sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -566,61 +582,67 @@ void CompositionPassVK::createDescriptors()
         set_write[ 0 ].pImageInfo        = nullptr;
         set_write[ 0 ].pBufferInfo       = &binfo;
 
-        set_write[ 1 ]                   = {};
-        set_write[ 1 ].sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        set_write[ 1 ].pNext             = nullptr;
-        set_write[ 1 ].dstBinding        = 1;
-        set_write[ 1 ].dstSet            = m_descriptor_sets[ i ].m_textures_descriptor;
-        set_write[ 1 ].descriptorCount   = 1;
-        set_write[ 1 ].descriptorType    = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        set_write[ 1 ].pImageInfo        = &image_infos[ 0 ];
-
-        set_write[ 2 ]                   = {};
-        set_write[ 2 ].sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        set_write[ 2 ].pNext             = nullptr;
-        set_write[ 2 ].dstBinding        = 2;
-        set_write[ 2 ].dstSet            = m_descriptor_sets[ i ].m_textures_descriptor;
-        set_write[ 2 ].descriptorCount   = 1;
-        set_write[ 2 ].descriptorType    = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        set_write[ 2 ].pImageInfo        = &image_infos[ 1 ];
-
-        set_write[ 3 ]                   = {};
-        set_write[ 3 ].sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        set_write[ 3 ].pNext             = nullptr;
-        set_write[ 3 ].dstBinding        = 3;
-        set_write[ 3 ].dstSet            = m_descriptor_sets[ i ].m_textures_descriptor;
-        set_write[ 3 ].descriptorCount   = 1;
-        set_write[ 3 ].descriptorType    = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        set_write[ 3 ].pImageInfo        = &image_infos[ 2 ];
-
-        set_write[ 4 ]                   = {};
-        set_write[ 4 ].sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        set_write[ 4 ].pNext             = nullptr;
-        set_write[ 4 ].dstBinding        = 4;
-        set_write[ 4 ].dstSet            = m_descriptor_sets[ i ].m_textures_descriptor;
-        set_write[ 4 ].descriptorCount   = 1;
-        set_write[ 4 ].descriptorType    = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        set_write[ 4 ].pImageInfo        = &image_infos[ 3 ];
-
-        set_write[5] = {};
-        set_write[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        set_write[5].pNext = nullptr;
-        set_write[5].dstBinding = 5;
-        set_write[5].dstSet = m_descriptor_sets[i].m_textures_descriptor;
-        set_write[5].descriptorCount = 1;
-        set_write[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        set_write[5].pImageInfo = &image_infos[4];
-
-        set_write[6] = {};
-        set_write[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        set_write[6].pNext = &writeDescriptorSetAccelerationStructure;
-        set_write[6].dstBinding = 6;
-        set_write[6].dstSet = m_descriptor_sets[i].m_textures_descriptor;
-        set_write[6].descriptorCount = 1;
-        set_write[6].descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR; 
+        set_write[1] = {};
+        set_write[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        set_write[1].pNext = &writeDescriptorSetAccelerationStructure;
+        set_write[1].dstBinding = 6;
+        set_write[1].dstSet = m_descriptor_sets[i].m_textures_descriptor;
+        set_write[1].descriptorCount = 1;
+        set_write[1].descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR; 
 
        
 
+        vkUpdateDescriptorSets( m_runtime.m_renderer->getDevice()->getLogicalDevice(), ray_tracing ? set_write.size() : 1, set_write.data(), 0, nullptr );
+    }
+
+    updateAttachmentDescriptors();
+}
+
+
+void CompositionPassVK::updateAttachmentDescriptors()
+{
+    std::array<VkDescriptorImageInfo, 6> image_infos;
+    image_infos[ 0 ].sampler     = m_in_color_attachment.m_sampler;
+    image_infos[ 0 ].imageView   = m_in_color_attachment.m_image_view;
+    image_infos[ 0 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    image_infos[ 1 ].sampler     = m_in_position_depth_attachment.m_sampler;
+    image_infos[ 1 ].imageView   = m_in_position_depth_attachment.m_image_view;
+    image_infos[ 1 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    image_infos[ 2 ].sampler     = m_in_normal_attachment.m_sampler;
+    image_infos[ 2 ].imageView   = m_in_normal_attachment.m_image_view;
+    image_infos[ 2 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    image_infos[ 3 ].sampler     = m_in_material_attachment.m_sampler;
+    image_infos[ 3 ].imageView   = m_in_material_attachment.m_image_view;
+    image_infos[ 3 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	image_infos[4].sampler = m_in_shadow_attachment.m_sampler;
+	image_infos[4].imageView = m_in_shadow_attachment.m_image_view;
+	image_infos[4].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    image_infos[ 5 ].sampler     = m_in_ambient_occlusion.m_sampler;
+    image_infos[ 5 ].imageView   = m_in_ambient_occlusion.m_image_view;
+    image_infos[ 5 ].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    //bindings 1 to 5 sample the gbuffer and the shadow map, binding 7 the ambient occlusion
+    for( uint32_t i = 0; i < kMAX_NUMBER_OF_FRAMES; i++ )
+    {
+        std::array<VkWriteDescriptorSet, 6> set_write;
+
+        for( uint32_t binding = 0; binding < static_cast<uint32_t>( set_write.size() ); binding++ )
+        {
+            set_write[ binding ]                   = {};
+            set_write[ binding ].sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            set_write[ binding ].pNext             = nullptr;
+            set_write[ binding ].dstBinding        = binding < 5 ? binding + 1 : 7;
+            set_write[ binding ].dstSet            = m_descriptor_sets[ i ].m_textures_descriptor;
+            set_write[ binding ].descriptorCount   = 1;
+            set_write[ binding ].descriptorType    = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            set_write[ binding ].pImageInfo        = &image_infos[ binding ];
+        }
+
         vkUpdateDescriptorSets( m_runtime.m_renderer->getDevice()->getLogicalDevice(), set_write.size(), set_write.data(), 0, nullptr );
     }
 }
\ No newline at end of file
@@ -9,7 +9,10 @@
 #include "shaderRegistry.h"
 #include "entity.h"
 #include "vulkan/meshVK.h"
+#include "vulkan/profilerVK.h"
+#include "vulkan/commandPoolsVK.h"
 #include "material.h"
+#include "vertexLayout.h"
 
 
 using namespace MiniEngine;
@@ -29,10 +32,8 @@ DeferredPassVK::DeferredPassVK(
     m_position_attachment( i_position_attachment ),
     m_material_attachment( i_material_attachment )    
 {
-    for( auto cmd : m_command_buffer )
-    {
-        cmd = VK_NULL_HANDLE;
-    }
+    //culled by the depth pass earlier in the frame
+    m_meshlet_draws = true;
 }
 
 
@@ -45,10 +46,14 @@ bool DeferredPassVK::initialize()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
-    m_entities_to_draw = {
-                            { static_cast<uint32_t>( Material::TMaterial::Diffuse     ), {} }, 
-                            { static_cast<uint32_t>( Material::TMaterial::Microfacets ), {} }
-                         };
+    //one list per material and vertex format, each drawn with its own pipeline
+    for( uint32_t mat_id = 0; mat_id < static_cast<uint32_t>( m_pipelines.size() ); mat_id++ )
+    {
+        for( uint32_t format = 0; format < kVERTEX_FORMAT_COUNT; format++ )
+        {
+            m_entities_to_draw[ mat_id * kVERTEX_FORMAT_COUNT + format ] = {};
+        }
+    }
 
     //SHADER STAGES
     {
@@ -95,14 +100,7 @@ bool DeferredPassVK::initialize()
     createPipelines ();
     createFbo       ();
 
-    VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
-
-    commandBufferAllocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    commandBufferAllocateInfo.commandPool        = renderer.getDevice()->getCommandPool();
-    commandBufferAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    commandBufferAllocateInfo.commandBufferCount = 3;
-    
-    vkAllocateCommandBuffers( renderer.getDevice()->getLogicalDevice(), &commandBufferAllocateInfo, m_command_buffer.data() );
+    initializeCommandBuffers( kMAX_NUMBER_OF_FRAMES );
 
     return true;
 }
@@ -112,20 +110,23 @@ void DeferredPassVK::shutdown()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
-    vkFreeCommandBuffers( renderer.getDevice()->getLogicalDevice(), renderer.getDevice()->getCommandPool(), m_command_buffer.size(), m_command_buffer.data() );
-    
+    shutdownCommandBuffers();
+
     vkDestroyDescriptorPool     ( renderer.getDevice()->getLogicalDevice(), m_descriptor_pool, nullptr );
 
     for( auto& pipeline : m_pipelines )
     {
         vkDestroyDescriptorSetLayout( renderer.getDevice()->getLogicalDevice(), pipeline.m_descriptor_set_layout[ 0 ], nullptr );
         vkDestroyDescriptorSetLayout( renderer.getDevice()->getLogicalDevice(), pipeline.m_descriptor_set_layout[ 1 ], nullptr );
-        vkDestroyPipeline           ( renderer.getDevice()->getLogicalDevice(), pipeline.m_pipeline                  , nullptr );
+        for( VkPipeline format_pipeline : pipeline.m_pipeline )
+        {
+            vkDestroyPipeline( renderer.getDevice()->getLogicalDevice(), format_pipeline, nullptr );
+        }
         vkDestroyPipelineLayout     ( renderer.getDevice()->getLogicalDevice(), pipeline.m_pipeline_layouts          , nullptr );
     }
     
 
-    for( uint32 id = 0; id < static_cast<uint32>( renderer.getWindow().getImageCount() ); id++ )
+    for( uint32 id = 0; id < static_cast<uint32>( m_fbos.size() ); id++ )
     {
         vkDestroyFramebuffer   ( renderer.getDevice()->getLogicalDevice(), m_fbos[ id ], nullptr );
     }
@@ -138,28 +139,32 @@ void DeferredPassVK::shutdown()
 
 VkCommandBuffer DeferredPassVK::draw( const Frame& i_frame)
 {
-    RendererVK& renderer = *m_runtime.m_renderer;
-
-    VkCommandBuffer& current_cmd = m_command_buffer[ renderer.getWindow().getCurrentImageId() ];
+    //the commands only change with the draw list or the swap chain, so a recorded buffer is submitted again as is
+    const uint32_t key = i_frame.m_frame_index;
 
+    VkCommandBuffer current_cmd = getCachedCommandBuffer( i_frame, key );
     if( current_cmd != VK_NULL_HANDLE )
     {
-        VkCommandBufferResetFlags flags{};        
-        vkResetCommandBuffer( current_cmd, flags );
+        return current_cmd;
     }
 
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    current_cmd = allocateCommandBuffer( key );
+
     VkCommandBufferBeginInfo begin_info{};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
     uint32_t width = 0, height = 0;
     renderer.getWindow().getWindowSize( width, height );
+    const VkExtent2D extent{ width, height };
 
     VkRenderPassBeginInfo render_pass_info{};
     render_pass_info.sType                = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     render_pass_info.renderPass           = m_render_pass;
-    render_pass_info.framebuffer          = m_fbos[ renderer.getWindow().getCurrentImageId()];
+    render_pass_info.framebuffer          = m_fbos[ i_frame.m_frame_index];
     render_pass_info.renderArea.offset    = { 0, 0 };
-    render_pass_info.renderArea.extent    = { width, height };
+    render_pass_info.renderArea.extent    = extent;
 
     std::array<VkClearValue, 4> clear_values;
     clear_values[ 0 ].color          = { { 0.0f, 0.0f, 0.0f, 0.0f } };
@@ -171,44 +176,85 @@ VkCommandBuffer DeferredPassVK::draw( const Frame& i_frame)
     render_pass_info.clearValueCount = static_cast<uint32_t>( clear_values.size() );
     render_pass_info.pClearValues    = clear_values.data();
 
+    //the subpass is either fully inline or fully secondary, so decide on the entities of every material
+    size_t entity_count = 0;
+    for( const auto& entities : m_entities_to_draw )
+    {
+        entity_count += entities.second.size();
+    }
+
+    const bool use_secondaries = useSecondaryCommandBuffers( entity_count );
+
+    VkCommandBufferInheritanceInfo inheritance_info{};
+    inheritance_info.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass  = m_render_pass;
+    inheritance_info.subpass     = 0;
+    inheritance_info.framebuffer = m_fbos[ i_frame.m_frame_index ];
+
     if( vkBeginCommandBuffer( current_cmd, &begin_info ) != VK_SUCCESS )
     {
         throw MiniEngineException( "failed to begin recording command buffer!" );
     }
     
-    UtilsVK::beginRegion( current_cmd, "GBuffer Pass", Vector4f( 0.0f, 0.5f, 0.0f, 1.0f ) );
-    vkCmdBeginRenderPass( current_cmd, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE );
+    const uint32_t scope = m_runtime.m_profiler->beginRegion( current_cmd, i_frame, "GBuffer Pass", Vector4f( 0.0f, 0.5f, 0.0f, 1.0f ) );
+    vkCmdBeginRenderPass( current_cmd, &render_pass_info, use_secondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE );
 
     for( uint32_t mat_id = static_cast<uint32_t>( Material::TMaterial::Diffuse ); mat_id < static_cast<uint32_t>( m_pipelines.size() ); mat_id++ )
     {
-        UtilsVK::beginRegion( current_cmd, mat_id == 0 ? "Diffuse GBuffer Pass" : mat_id == 1 ? "Dielectric GBuffer Pass" : "Microfacets GBuffer Pass", Vector4f( 0.0f, 0.5f, 0.5f, 1.0f ) );
-
-        vkCmdBindPipeline      ( current_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[ mat_id ].m_pipeline );
-        vkCmdBindDescriptorSets( current_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[ mat_id ].m_pipeline_layouts, 0, 2, &m_pipelines[ mat_id ].m_descriptor_sets[ renderer.getWindow().getCurrentImageId() ].m_per_frame_descriptor, 0, nullptr );
+        const MaterialPipeline& pipeline = m_pipelines[ mat_id ];
 
-        for( auto entity : m_entities_to_draw[ mat_id ] )
+        for( uint32_t format = 0; format < kVERTEX_FORMAT_COUNT; format++ )
         {
-            entity->draw( current_cmd, i_frame );
+            const std::vector<EntityPtr>& entities = m_entities_to_draw[ mat_id * kVERTEX_FORMAT_COUNT + format ];
+            if( entities.empty() )
+            {
+                continue;
+            }
+
+            drawEntities( current_cmd, i_frame, key, mat_id == 0 ? "Diffuse GBuffer Pass" : mat_id == 1 ? "Dielectric GBuffer Pass" : "Microfacets GBuffer Pass", entities, use_secondaries ? &inheritance_info : nullptr,
+                [ & ]( VkCommandBuffer i_cmd )
+                {
+                    vkCmdBindPipeline      ( i_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.m_pipeline[ format ] );
+                    setViewportAndScissor  ( i_cmd, extent );
+                    vkCmdBindDescriptorSets( i_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.m_pipeline_layouts, 0, 2, &pipeline.m_descriptor_sets[ i_frame.m_frame_index ].m_per_frame_descriptor, 0, nullptr );
+                } );
         }
-
-        UtilsVK::endRegion( current_cmd );
     }
     
     vkCmdEndRenderPass( current_cmd );
-    UtilsVK::endRegion( current_cmd );
+    m_runtime.m_profiler->endRegion( current_cmd, i_frame, scope );
 
     if( vkEndCommandBuffer( current_cmd ) != VK_SUCCESS )
     {
         throw MiniEngineException( "failed to record command buffer!" );
     }
 
+    cacheCommandBuffer( key, current_cmd, scope );
+
     return current_cmd;
 }
 
 
+void DeferredPassVK::resize()
+{
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    //the gbuffer images were recreated, only the framebuffers hold their views
+    for( uint32 id = 0; id < static_cast<uint32>( m_fbos.size() ); id++ )
+    {
+        vkDestroyFramebuffer( renderer.getDevice()->getLogicalDevice(), m_fbos[ id ], nullptr );
+    }
+
+    createFbo ();
+    invalidate();
+}
+
+
 void DeferredPassVK::addEntityToDraw( const EntityPtr i_entity )
 {
-    m_entities_to_draw[ static_cast<uint32_t>( i_entity->getMaterial().getType() ) ].push_back( i_entity );
+    const uint32_t key = static_cast<uint32_t>( i_entity->getMaterial().getType() ) * kVERTEX_FORMAT_COUNT + static_cast<uint32_t>( i_entity->getMesh().getVertexFormat() );
+    m_entities_to_draw[ key ].push_back( i_entity );
+    invalidate();
 }
 
 
@@ -253,6 +299,7 @@ void DeferredPassVK::createRenderPass()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
+    //every attachment stays in its attachment layout, the render graph barriers do the transitions
     std::array<VkAttachmentDescription, 5> attachments = {};
 
     // Color attachment
@@ -262,8 +309,8 @@ void DeferredPassVK::createRenderPass()
     attachments[ 0 ].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
     attachments[ 0 ].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachments[ 0 ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachments[ 0 ].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachments[ 0 ].finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    attachments[ 0 ].initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[ 0 ].finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
     // Normal attachment
     attachments[ 1 ].format         = m_normals_attachment.m_format;
@@ -272,8 +319,8 @@ void DeferredPassVK::createRenderPass()
     attachments[ 1 ].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
     attachments[ 1 ].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachments[ 1 ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachments[ 1 ].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachments[ 1 ].finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    attachments[ 1 ].initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[ 1 ].finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
     // Position + depth  attachment
     attachments[ 2 ].format         = m_position_attachment.m_format;
@@ -282,8 +329,8 @@ void DeferredPassVK::createRenderPass()
     attachments[ 2 ].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
     attachments[ 2 ].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachments[ 2 ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachments[ 2 ].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachments[ 2 ].finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    attachments[ 2 ].initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[ 2 ].finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
     // MAterial  attachment
     attachments[ 3 ].format         = m_material_attachment.m_format;
@@ -292,8 +339,8 @@ void DeferredPassVK::createRenderPass()
     attachments[ 3 ].storeOp        = VK_ATTACHMENT_STORE_OP_STORE;
     attachments[ 3 ].stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     attachments[ 3 ].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachments[ 3 ].initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED;
-    attachments[ 3 ].finalLayout    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    attachments[ 3 ].initialLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments[ 3 ].finalLayout    = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
     // Depth  attachment
     attachments[ 4 ].format         = m_depth_buffer.m_format;
@@ -339,33 +386,14 @@ void DeferredPassVK::createRenderPass()
     subpass_description.pPreserveAttachments    = nullptr;
     subpass_description.pResolveAttachments     = nullptr;
 
-    // Subpass dependencies for layout transitions
-    std::array<VkSubpassDependency, 2> dependencies;
-
-    dependencies[ 0 ].srcSubpass        = VK_SUBPASS_EXTERNAL;
-    dependencies[ 0 ].dstSubpass        = 0;
-    dependencies[ 0 ].srcStageMask      = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    dependencies[ 0 ].dstStageMask      = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependencies[ 0 ].srcAccessMask     = VK_ACCESS_SHADER_READ_BIT;
-    dependencies[ 0 ].dstAccessMask     = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    dependencies[ 0 ].dependencyFlags   = VK_DEPENDENCY_BY_REGION_BIT;
-
-    dependencies[ 1 ].srcSubpass        = 0;
-    dependencies[ 1 ].dstSubpass        = VK_SUBPASS_EXTERNAL;
-    dependencies[ 1 ].srcStageMask      = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependencies[ 1 ].dstStageMask      = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    dependencies[ 1 ].srcAccessMask     = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    dependencies[ 1 ].dstAccessMask     = VK_ACCESS_SHADER_READ_BIT;
-    dependencies[ 1 ].dependencyFlags   = VK_DEPENDENCY_BY_REGION_BIT;
-
     VkRenderPassCreateInfo render_pass_info = {};
     render_pass_info.sType            = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     render_pass_info.attachmentCount  = static_cast< uint32_t >( attachments.size() );
     render_pass_info.pAttachments     = attachments.data();
     render_pass_info.subpassCount     = 1;
     render_pass_info.pSubpasses       = &subpass_description;
-    render_pass_info.dependencyCount  = static_cast< uint32_t >( dependencies.size() );
-    render_pass_info.pDependencies    = dependencies.data();
+    render_pass_info.dependencyCount  = 0;
+    render_pass_info.pDependencies    = nullptr;
 
     if( vkCreateRenderPass( renderer.getDevice()->getLogicalDevice(), &render_pass_info, nullptr, &m_render_pass ) )
     {
@@ -378,36 +406,6 @@ void DeferredPassVK::createPipelines()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
     
-    VkVertexInputBindingDescription binding_vertex_descrition{};
-    binding_vertex_descrition.binding   = 0;
-    binding_vertex_descrition.stride    = sizeof(Vertex);
-    binding_vertex_descrition.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-    std::array<VkVertexInputAttributeDescription, 3> attribute_descriptions{};
-
-    attribute_descriptions[ 0 ].binding   = 0;
-    attribute_descriptions[ 0 ].location  = 0;
-    attribute_descriptions[ 0 ].format    = VK_FORMAT_R32G32B32_SFLOAT;
-    attribute_descriptions[ 0 ].offset    = offsetof(Vertex, m_position);
-                              
-    attribute_descriptions[ 1 ].binding   = 0;
-    attribute_descriptions[ 1 ].location  = 1;
-    attribute_descriptions[ 1 ].format    = VK_FORMAT_R32G32B32_SFLOAT;
-    attribute_descriptions[ 1 ].offset    = offsetof(Vertex, m_normal);
-                              
-    attribute_descriptions[ 2 ].binding   = 0;
-    attribute_descriptions[ 2 ].location  = 2;
-    attribute_descriptions[ 2 ].format    = VK_FORMAT_R32G32_SFLOAT;
-    attribute_descriptions[ 2 ].offset    = offsetof(Vertex, m_uv );
-
-    VkPipelineVertexInputStateCreateInfo vertex_input_info{};
-    vertex_input_info.sType                           = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertex_input_info.vertexBindingDescriptionCount   = 1;
-    vertex_input_info.vertexAttributeDescriptionCount = static_cast< uint32_t >( attribute_descriptions.size() );
-    vertex_input_info.pVertexBindingDescriptions      = &binding_vertex_descrition;
-    vertex_input_info.pVertexAttributeDescriptions    = attribute_descriptions.data();
-    vertex_input_info.flags                           = 0;
-
     VkPipelineInputAssemblyStateCreateInfo input_assembly{};
     input_assembly.sType                    = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     input_assembly.topology                 = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -474,30 +472,22 @@ void DeferredPassVK::createPipelines()
     multisampling.flags                 = 0;
 
 
-    uint32 width = 0, height = 0;
-    renderer.getWindow().getWindowSize( width, height );
-    VkExtent2D extend{ width, height };
-
-    VkViewport viewport{};
-    viewport.x          = 0.0f;
-    viewport.y          = 0.0f;
-    viewport.width      = (float) width;
-    viewport.height     = (float) height;
-    viewport.minDepth   = 0.0f;
-    viewport.maxDepth   = 1.0f;
-    
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = extend;
-
+    //the extent is set at record time, resizing keeps the pipelines
     VkPipelineViewportStateCreateInfo viewport_state{};
     viewport_state.sType            = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewport_state.viewportCount    = 1;
-    viewport_state.pViewports       = &viewport;
+    viewport_state.pViewports       = nullptr;
     viewport_state.scissorCount     = 1;
-    viewport_state.pScissors        = &scissor;
+    viewport_state.pScissors        = nullptr;
     viewport_state.flags            = 0;
 
+    std::array<VkDynamicState, 2> dynamic_states = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    VkPipelineDynamicStateCreateInfo dynamic_state{};
+    dynamic_state.sType             = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>( dynamic_states.size() );
+    dynamic_state.pDynamicStates    = dynamic_states.data();
+
     //create unfiorms 
     createDescriptorLayout();
 
@@ -512,8 +502,6 @@ void DeferredPassVK::createPipelines()
         pipeline_layout_info.pushConstantRangeCount = 0;
         pipeline_layout_info.flags                  = 0;
 
-        std::vector<VkGraphicsPipelineCreateInfo> graphic_pipelines;
-
         
         if( vkCreatePipelineLayout( renderer.getDevice()->getLogicalDevice(), &pipeline_layout_info, nullptr, &pipeline.m_pipeline_layouts ) != VK_SUCCESS) 
         {
@@ -532,19 +520,22 @@ void DeferredPassVK::createPipelines()
         pipeline_info.pMultisampleState     = &multisampling;
         pipeline_info.pViewportState        = &viewport_state;
         pipeline_info.pDepthStencilState    = &depth_stencil;
-        pipeline_info.pDynamicState         = VK_NULL_HANDLE;
+        pipeline_info.pDynamicState         = &dynamic_state;
         pipeline_info.stageCount            = pipeline.m_shader_stages.size();
         pipeline_info.pStages               = pipeline.m_shader_stages.data();
         pipeline_info.flags                 = 0;
-        pipeline_info.pVertexInputState     = &vertex_input_info;
         pipeline_info.subpass               = 0;
         
-        graphic_pipelines.push_back( pipeline_info );
-        
-
-        if( vkCreateGraphicsPipelines( renderer.getDevice()->getLogicalDevice(), VK_NULL_HANDLE, 1, graphic_pipelines.data(), nullptr, &pipeline.m_pipeline ) )
+        //same state for every vertex format, only the vertex input changes
+        for( uint32_t format = 0; format < kVERTEX_FORMAT_COUNT; format++ )
         {
-            throw MiniEngineException("Error creating the pipeline");
+            VertexLayouts::InputState input_state( static_cast<VertexFormat>( format ) );
+            pipeline_info.pVertexInputState = &input_state.m_create_info;
+
+            if( vkCreateGraphicsPipelines( renderer.getDevice()->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline.m_pipeline[ format ] ) )
+            {
+                throw MiniEngineException("Error creating the pipeline");
+            }
         }
     }
     createDescriptors();
@@ -620,7 +611,7 @@ void DeferredPassVK::createDescriptors()
     //create descriptors for the global buffers
     for( auto& pipeline : m_pipelines )
     { 
-        for( uint32_t id = 0; id < m_runtime.m_renderer->getWindow().getImageCount(); id++ )
+        for( uint32_t id = 0; id < kMAX_NUMBER_OF_FRAMES; id++ )
         {
         
             //globals per frame
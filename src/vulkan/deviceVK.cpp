@@ -2,6 +2,8 @@
 #include "vulkan/rendererVK.h"
 #include "vulkan/windowVK.h"
 #include "vulkan/utilsVK.h"
+#include "vulkan/memoryAllocatorVK.h"
+#include "vulkan/uploadManagerVK.h"
 #include "common.h"
 
 
@@ -12,11 +14,17 @@ using namespace MiniEngine;
 DeviceVK::DeviceVK( const RendererVK& i_renderer ) : 
     m_renderer                         ( i_renderer     ),
     m_graphics_queue_index             ( 0              ),
+    m_transfer_queue_index             ( 0              ),
+    m_compute_queue_index              ( 0              ),
     m_command_pool                     ( VK_NULL_HANDLE ),
     m_graphics_queue                   ( VK_NULL_HANDLE ),
+    m_transfer_queue                   ( VK_NULL_HANDLE ),
+    m_compute_queue                    ( VK_NULL_HANDLE ),
     m_phyisical_device_properties      ( {}             ),
     m_physical_device_features         ( {}             ),
-    m_physical_device_memory_properties( {}             )
+    m_physical_device_memory_properties( {}             ),
+    m_buffer_device_address            ( false          ),
+    m_ray_tracing                      ( false          )
 {}
 
 
@@ -33,8 +41,9 @@ uint32_t DeviceVK::getQueueFamilyIndex( VkQueueFlagBits i_queue_flags ) const
     uint32_t queue_family_count = 0;
     vkGetPhysicalDeviceQueueFamilyProperties( m_physical_device, &queue_family_count, nullptr );
 
-    std::vector<VkBool32> supports_present( queue_family_count);
-	for (uint32_t i = 0; i < queue_family_count; i++) 
+    //without surface there is nothing to present, any graphics family will do
+    std::vector<VkBool32> supports_present( queue_family_count, VK_FALSE );
+	for (uint32_t i = 0; i < queue_family_count && !m_renderer.getWindow().isHeadless(); i++) 
 	{
 		vkGetPhysicalDeviceSurfaceSupportKHR( m_physical_device, i, m_renderer.getWindow().getSurface(), &supports_present[i]);
 	}
@@ -80,6 +89,40 @@ uint32_t DeviceVK::getQueueFamilyIndex( VkQueueFlagBits i_queue_flags ) const
 }
 
 
+uint32_t DeviceVK::getTransferQueueFamilyIndex( const uint32_t i_fallback_index ) const
+{
+    //a family without graphics or compute is usually backed by the copy engines of the gpu,
+    //so its copies run next to the rendering instead of between its commands
+    for( uint32_t i = 0; i < static_cast<uint32_t>( m_queue_family_properties.size() ); i++ )
+    {
+        const VkQueueFlags flags = m_queue_family_properties[ i ].queueFlags;
+
+        if( ( flags & VK_QUEUE_TRANSFER_BIT ) && !( flags & ( VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT ) ) && m_queue_family_properties[ i ].queueCount > 0 )
+        {
+            return i;
+        }
+    }
+
+    return i_fallback_index;
+}
+
+
+uint32_t DeviceVK::getComputeQueueFamilyIndex( const uint32_t i_fallback_index ) const
+{
+    for( uint32_t i = 0; i < static_cast<uint32_t>( m_queue_family_properties.size() ); i++ )
+    {
+        const VkQueueFlags flags = m_queue_family_properties[ i ].queueFlags;
+
+        if( ( flags & VK_QUEUE_COMPUTE_BIT ) && !( flags & VK_QUEUE_GRAPHICS_BIT ) && m_queue_family_properties[ i ].queueCount > 0 )
+        {
+            return i;
+        }
+    }
+
+    return i_fallback_index;
+}
+
+
 void DeviceVK::createPhysicalDevice()
 {
     // Physical device
@@ -177,11 +220,32 @@ void DeviceVK::createDevice()
     queue_info.queueCount       = 1;
     queue_info.pQueuePriorities = &default_queue_priority;
     queue_create_infos.push_back( queue_info );
+
+    // Transfer queue, shares the graphics one if there is no dedicated family
+    m_transfer_queue_index = getTransferQueueFamilyIndex( m_graphics_queue_index );
+
+    if( m_transfer_queue_index != m_graphics_queue_index )
+    {
+        queue_info.queueFamilyIndex = m_transfer_queue_index;
+        queue_create_infos.push_back( queue_info );
+    }
+
+    // Async compute queue, same fallback
+    m_compute_queue_index = getComputeQueueFamilyIndex( m_graphics_queue_index );
+
+    if( m_compute_queue_index != m_graphics_queue_index )
+    {
+        queue_info.queueFamilyIndex = m_compute_queue_index;
+        queue_create_infos.push_back( queue_info );
+    }
     
 
     // Create the logical device representation
     // If the device will be used for presenting to a display via a swapchain we need to request the swapchain extension
-    m_extensions.push_back( VK_KHR_SWAPCHAIN_EXTENSION_NAME              );
+    if( !m_renderer.getWindow().isHeadless() )
+    {
+        m_extensions.push_back( VK_KHR_SWAPCHAIN_EXTENSION_NAME          );
+    }
     m_extensions.push_back( VK_KHR_SHADER_DRAW_PARAMETERS_EXTENSION_NAME );
     m_extensions.push_back( VK_KHR_MAINTENANCE1_EXTENSION_NAME           );
 
@@ -220,8 +284,22 @@ void DeviceVK::createDevice()
     // 1. Buffer Device Address (requerido por Acceleration Structure)
     VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures = {};
 
-    if (std::find(m_supported_extensions.begin(), m_supported_extensions.end(),
-        VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME) != m_supported_extensions.end())
+    auto isSupported = [ this ]( const char* i_extension )
+    {
+        return std::find( m_supported_extensions.begin(), m_supported_extensions.end(), i_extension ) != m_supported_extensions.end();
+    };
+
+    //software implementations often lack them, the engine then runs without acceleration structures
+    m_buffer_device_address = isSupported( VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME );
+    m_ray_tracing           = m_buffer_device_address && isSupported( VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME ) &&
+                              isSupported( VK_KHR_RAY_QUERY_EXTENSION_NAME ) && isSupported( VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME );
+
+    if( !m_ray_tracing )
+    {
+        std::cout << "Ray tracing is not supported by the device, acceleration structures are disabled\n";
+    }
+
+    if (m_buffer_device_address)
     {
         m_extensions.push_back(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
         bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
@@ -244,8 +322,7 @@ void DeviceVK::createDevice()
 
     // 3. Acceleration Structure
     VkPhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures = {};
-    if (std::find(m_supported_extensions.begin(), m_supported_extensions.end(),
-        VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME) != m_supported_extensions.end()) {
+    if (m_ray_tracing) {
         m_extensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
         accelerationStructureFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
         accelerationStructureFeatures.accelerationStructure = VK_TRUE;
@@ -255,8 +332,7 @@ void DeviceVK::createDevice()
 
     // 4. Ray Tracing Pipeline
     VkPhysicalDeviceRayTracingPipelineFeaturesKHR rayTracingPipelineFeatures = {};
-    if (std::find(m_supported_extensions.begin(), m_supported_extensions.end(),
-        VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME) != m_supported_extensions.end()) {
+    if (m_ray_tracing && isSupported(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME)) {
         m_extensions.push_back(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME);
         rayTracingPipelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR;
         rayTracingPipelineFeatures.rayTracingPipeline = VK_TRUE;
@@ -266,8 +342,7 @@ void DeviceVK::createDevice()
 
     // 5. Ray Query
     VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures = {};
-    if (std::find(m_supported_extensions.begin(), m_supported_extensions.end(),
-        VK_KHR_RAY_QUERY_EXTENSION_NAME) != m_supported_extensions.end()) {
+    if (m_ray_tracing) {
         m_extensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
         rayQueryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
         rayQueryFeatures.rayQuery = VK_TRUE;
@@ -276,27 +351,11 @@ void DeviceVK::createDevice()
     }
 
     // 6. Deferred Host Operations (siempre que est disponible)
-      if (std::find(m_supported_extensions.begin(), m_supported_extensions.end(),
-        VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME) != m_supported_extensions.end())
+    if (m_ray_tracing)
     {
         m_extensions.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
     }
 
-    // Verifica que todas las extensiones requeridas estn disponibles
-    std::vector<const char*> requiredExtensions = {
-        VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
-        VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
-        VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
-        VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME
-    };
-
-    for (const auto& ext : requiredExtensions) {
-        if (std::find(m_supported_extensions.begin(), m_supported_extensions.end(), ext) == m_supported_extensions.end()) {
-            throw std::runtime_error(std::string("Required extension not supported: ") + ext);
-        }
-    }
-    
-
     // -----------------------------------------------------
     
 
@@ -327,6 +386,13 @@ void DeviceVK::createDevice()
 #endif
 
     vkGetDeviceQueue( m_logical_device, m_graphics_queue_index, 0, &m_graphics_queue );
+    vkGetDeviceQueue( m_logical_device, m_transfer_queue_index, 0, &m_transfer_queue );
+    vkGetDeviceQueue( m_logical_device, m_compute_queue_index , 0, &m_compute_queue  );
+
+    m_allocator = std::make_unique<MemoryAllocatorVK>( *this );
+
+    m_upload_manager = std::make_unique<UploadManagerVK>( *this );
+    m_upload_manager->initialize();
 }
 
 
@@ -365,6 +431,10 @@ uint32_t DeviceVK::getMemoryTypeIndex( uint32_t typeBits, VkMemoryPropertyFlags
 
 void DeviceVK::destroyDevice()
 {
+    m_upload_manager->shutdown();
+    m_upload_manager.reset();
+    m_allocator.reset();
+
     vkDestroyCommandPool( m_logical_device, m_command_pool, nullptr );
     vkDestroyDevice( m_logical_device, nullptr );
 }
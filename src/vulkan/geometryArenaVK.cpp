@@ -0,0 +1,376 @@
+#include "common.h"
+#include "runtime.h"
+#include "vulkan/geometryArenaVK.h"
+#include "vulkan/rendererVK.h"
+#include "vulkan/deviceVK.h"
+#include "vulkan/utilsVK.h"
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    //read by the draws, the copies and, when the device has them, the acceleration structure builds
+    VkBufferUsageFlags getUsage( const DeviceVK& i_device )
+    {
+        return VK_BUFFER_USAGE_TRANSFER_DST_BIT | ( i_device.supportsRayTracing() ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR : 0 );
+    }
+
+    uint32_t getStride( const VertexFormat i_format, const VertexStream i_stream )
+    {
+        return VertexLayouts::visit( i_format, [ i_stream ]( auto i_layout )
+        {
+            return i_stream == VertexStream::Position ? decltype( i_layout )::kPOSITION_STRIDE : decltype( i_layout )::kSTRIDE;
+        } );
+    }
+
+    uint32_t getIndexSize( const VkIndexType i_index_type )
+    {
+        return i_index_type == VK_INDEX_TYPE_UINT16 ? sizeof( uint16_t ) : sizeof( uint32_t );
+    }
+
+    float toMegabytes( const VkDeviceSize i_bytes )
+    {
+        return static_cast<float>( i_bytes ) / ( 1024.0f * 1024.0f );
+    }
+}
+
+
+GeometryArenaVK::GeometryArenaVK( const Runtime& i_runtime ) :
+    m_runtime( i_runtime )
+{
+}
+
+
+bool GeometryArenaVK::initialize()
+{
+    return true;
+}
+
+
+void GeometryArenaVK::shutdown()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    for( auto& blocks : m_vertex_blocks )
+    {
+        for( auto& block : blocks )
+        {
+            releaseBlock( block );
+        }
+        blocks.clear();
+    }
+
+    for( auto& blocks : m_index_blocks )
+    {
+        for( auto& block : blocks )
+        {
+            releaseBlock( block );
+        }
+        blocks.clear();
+    }
+}
+
+
+GeometryArenaVK::Allocation GeometryArenaVK::allocate( const VertexFormat i_format, const uint32_t i_vertex_count, const uint32_t i_index_count, const VkIndexType i_index_type, const bool i_position_stream )
+{
+    assert( i_vertex_count > 0 && i_index_count > 0 );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    const VkBufferUsageFlags usage = getUsage( *m_runtime.m_renderer->getDevice() );
+
+    Allocation allocation;
+    allocation.m_format       = i_format;
+    allocation.m_vertex_count = i_vertex_count;
+    allocation.m_index_type   = i_index_type;
+    allocation.m_index_count  = i_index_count;
+
+    allocation.m_vertex_block = allocateRange( m_vertex_blocks[ static_cast<uint32_t>( i_format ) ], i_vertex_count, kGEOMETRY_BLOCK_VERTICES,
+                                               getStride( i_format, VertexStream::Interleaved ), i_position_stream ? getStride( i_format, VertexStream::Position ) : 0,
+                                               usage | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, allocation.m_vertex_offset );
+
+    allocation.m_index_block  = allocateRange( m_index_blocks[ getIndexPool( i_index_type ) ], i_index_count, kGEOMETRY_BLOCK_INDICES, getIndexSize( i_index_type ), 0,
+                                               usage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, allocation.m_first_index );
+
+    return allocation;
+}
+
+
+void GeometryArenaVK::free( Allocation& io_allocation )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( io_allocation.m_vertex_block != UINT32_MAX )
+    {
+        freeRange( m_vertex_blocks[ static_cast<uint32_t>( io_allocation.m_format ) ][ io_allocation.m_vertex_block ], io_allocation.m_vertex_offset, io_allocation.m_vertex_count );
+    }
+
+    if( io_allocation.m_index_block != UINT32_MAX )
+    {
+        freeRange( m_index_blocks[ getIndexPool( io_allocation.m_index_type ) ][ io_allocation.m_index_block ], io_allocation.m_first_index, io_allocation.m_index_count );
+    }
+
+    io_allocation = Allocation();
+}
+
+
+VkBuffer GeometryArenaVK::getVertexBuffer( const Allocation& i_allocation, const VertexStream i_stream ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    const Block& block = m_vertex_blocks[ static_cast<uint32_t>( i_allocation.m_format ) ][ i_allocation.m_vertex_block ];
+    assert( i_stream == VertexStream::Interleaved || block.m_position_buffer != VK_NULL_HANDLE );
+
+    return i_stream == VertexStream::Position ? block.m_position_buffer : block.m_buffer;
+}
+
+
+VkDeviceSize GeometryArenaVK::getVertexOffset( const Allocation& i_allocation, const VertexStream i_stream ) const
+{
+    return VkDeviceSize( i_allocation.m_vertex_offset ) * getStride( i_allocation.m_format, i_stream );
+}
+
+
+VkBuffer GeometryArenaVK::getIndexBuffer( const Allocation& i_allocation ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    return m_index_blocks[ getIndexPool( i_allocation.m_index_type ) ][ i_allocation.m_index_block ].m_buffer;
+}
+
+
+VkDeviceSize GeometryArenaVK::getIndexOffset( const Allocation& i_allocation ) const
+{
+    return VkDeviceSize( i_allocation.m_first_index ) * getIndexSize( i_allocation.m_index_type );
+}
+
+
+void GeometryArenaVK::bind( VkCommandBuffer i_command_buffer, const Allocation& i_allocation, const VertexStream i_stream, GeometryBinding& io_binding ) const
+{
+    //recorded on the worker threads while the registry may load more meshes, blocks are only appended under the lock
+    VkBuffer vertices = getVertexBuffer( i_allocation, i_stream );
+    VkBuffer indices  = getIndexBuffer ( i_allocation );
+
+    if( vertices != io_binding.m_vertices || i_stream != io_binding.m_stream )
+    {
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers( i_command_buffer, 0, 1, &vertices, &offset );
+
+        io_binding.m_vertices = vertices;
+        io_binding.m_stream   = i_stream;
+    }
+
+    //a block only holds one index type, the buffer tells both
+    if( indices != io_binding.m_indices )
+    {
+        vkCmdBindIndexBuffer( i_command_buffer, indices, 0, i_allocation.m_index_type );
+
+        io_binding.m_indices = indices;
+    }
+}
+
+
+GeometryArenaVK::Stats GeometryArenaVK::getStats() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    Stats stats;
+
+    auto accumulate = [ &stats ]( const Block& i_block, const VkDeviceSize i_stride, const VkDeviceSize i_position_stride )
+    {
+        if( i_block.m_buffer == VK_NULL_HANDLE )
+        {
+            return;
+        }
+
+        const VkDeviceSize stride = i_stride + ( i_block.m_position_buffer != VK_NULL_HANDLE ? i_position_stride : 0 );
+
+        uint32_t free_count = 0;
+        for( const auto& range : i_block.m_free )
+        {
+            free_count += range.second;
+        }
+
+        stats.m_blocks++;
+        stats.m_allocations += i_block.m_allocations;
+        stats.m_reserved    += stride * i_block.m_capacity;
+        stats.m_used        += stride * ( i_block.m_capacity - free_count );
+    };
+
+    for( uint32_t format = 0; format < kVERTEX_FORMAT_COUNT; format++ )
+    {
+        for( const auto& block : m_vertex_blocks[ format ] )
+        {
+            accumulate( block, getStride( static_cast<VertexFormat>( format ), VertexStream::Interleaved ), getStride( static_cast<VertexFormat>( format ), VertexStream::Position ) );
+        }
+    }
+
+    for( const VkIndexType index_type : { VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 } )
+    {
+        for( const auto& block : m_index_blocks[ getIndexPool( index_type ) ] )
+        {
+            accumulate( block, getIndexSize( index_type ), 0 );
+        }
+    }
+
+    return stats;
+}
+
+
+void GeometryArenaVK::printStats( std::ostream& o_stream ) const
+{
+    const Stats stats = getStats();
+
+    o_stream << tfm::format( "Geometry arena: %.2f MB used of %.2f MB in %d blocks, %d mesh ranges\n",
+                             toMegabytes( stats.m_used ), toMegabytes( stats.m_reserved ), stats.m_blocks, stats.m_allocations );
+}
+
+
+uint32_t GeometryArenaVK::allocateRange( std::vector<Block>& io_blocks, const uint32_t i_count, const uint32_t i_block_capacity, const uint32_t i_stride, const uint32_t i_position_stride,
+                                         const VkBufferUsageFlags i_usage, uint32_t& o_offset )
+{
+    uint32_t empty_slot = UINT32_MAX;
+
+    for( uint32_t block_idx = 0; block_idx < static_cast<uint32_t>( io_blocks.size() ); block_idx++ )
+    {
+        Block& block = io_blocks[ block_idx ];
+
+        if( block.m_buffer == VK_NULL_HANDLE )
+        {
+            empty_slot = std::min( empty_slot, block_idx );
+            continue;
+        }
+
+        //a mesh drawn from its position stream needs it in the same block
+        if( i_position_stride > 0 && block.m_position_buffer == VK_NULL_HANDLE )
+        {
+            continue;
+        }
+
+        if( suballocate( block, i_count, o_offset ) )
+        {
+            return block_idx;
+        }
+    }
+
+    if( empty_slot == UINT32_MAX )
+    {
+        empty_slot = static_cast<uint32_t>( io_blocks.size() );
+        io_blocks.emplace_back();
+    }
+
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    //meshes bigger than a block get a block of their own size
+    Block& block = io_blocks[ empty_slot ];
+    block.m_capacity = std::max( i_count, i_block_capacity );
+    block.m_free.clear();
+    block.m_free[ 0 ] = block.m_capacity;
+
+    UtilsVK::createBuffer( device, VkDeviceSize( block.m_capacity ) * i_stride, i_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, block.m_buffer, block.m_memory );
+
+    if( i_position_stride > 0 )
+    {
+        UtilsVK::createBuffer( device, VkDeviceSize( block.m_capacity ) * i_position_stride, i_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, block.m_position_buffer, block.m_position_memory );
+    }
+
+    suballocate( block, i_count, o_offset );
+
+    return empty_slot;
+}
+
+
+void GeometryArenaVK::freeRange( Block& io_block, const uint32_t i_offset, const uint32_t i_count )
+{
+    assert( io_block.m_allocations > 0 );
+
+    auto it = io_block.m_free.insert( { i_offset, i_count } ).first;
+
+    auto next = std::next( it );
+    if( next != io_block.m_free.end() && it->first + it->second == next->first )
+    {
+        it->second += next->second;
+        io_block.m_free.erase( next );
+    }
+
+    if( it != io_block.m_free.begin() )
+    {
+        auto previous = std::prev( it );
+        if( previous->first + previous->second == it->first )
+        {
+            previous->second += it->second;
+            io_block.m_free.erase( it );
+        }
+    }
+
+    io_block.m_allocations--;
+
+    if( io_block.m_allocations == 0 )
+    {
+        releaseBlock( io_block );
+    }
+}
+
+
+void GeometryArenaVK::releaseBlock( Block& io_block )
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    if( io_block.m_buffer != VK_NULL_HANDLE )
+    {
+        UtilsVK::freeBuffer( device, io_block.m_buffer, io_block.m_memory );
+    }
+
+    if( io_block.m_position_buffer != VK_NULL_HANDLE )
+    {
+        UtilsVK::freeBuffer( device, io_block.m_position_buffer, io_block.m_position_memory );
+    }
+
+    io_block.m_capacity    = 0;
+    io_block.m_allocations = 0;
+    io_block.m_free.clear();
+}
+
+
+bool GeometryArenaVK::suballocate( Block& io_block, const uint32_t i_count, uint32_t& o_offset )
+{
+    //best fit, the smallest free range that still holds the mesh
+    auto best = io_block.m_free.end();
+
+    for( auto it = io_block.m_free.begin(); it != io_block.m_free.end(); ++it )
+    {
+        if( it->second >= i_count && ( best == io_block.m_free.end() || it->second < best->second ) )
+        {
+            best = it;
+        }
+    }
+
+    if( best == io_block.m_free.end() )
+    {
+        return false;
+    }
+
+    const uint32_t range_offset = best->first;
+    const uint32_t range_count  = best->second;
+
+    io_block.m_free.erase( best );
+
+    if( i_count < range_count )
+    {
+        io_block.m_free[ range_offset + i_count ] = range_count - i_count;
+    }
+
+    io_block.m_allocations++;
+    o_offset = range_offset;
+
+    return true;
+}
+
+
+uint32_t GeometryArenaVK::getIndexPool( const VkIndexType i_index_type )
+{
+    assert( i_index_type == VK_INDEX_TYPE_UINT16 || i_index_type == VK_INDEX_TYPE_UINT32 );
+
+    return i_index_type == VK_INDEX_TYPE_UINT16 ? 0 : 1;
+}
@@ -0,0 +1,348 @@
+#include "vulkan/memoryAllocatorVK.h"
+#include "vulkan/deviceVK.h"
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    VkDeviceSize alignUp( const VkDeviceSize i_value, const VkDeviceSize i_alignment )
+    {
+        return i_alignment > 1 ? ( i_value + i_alignment - 1 ) / i_alignment * i_alignment : i_value;
+    }
+
+    float toMegabytes( const VkDeviceSize i_bytes )
+    {
+        return static_cast<float>( i_bytes ) / ( 1024.0f * 1024.0f );
+    }
+}
+
+
+float MemoryAllocatorVK::Stats::getFragmentation() const
+{
+    const VkDeviceSize free_memory = m_reserved - m_used;
+    return free_memory > 0 ? 1.0f - static_cast<float>( m_largest_free ) / static_cast<float>( free_memory ) : 0.0f;
+}
+
+
+MemoryAllocatorVK::MemoryAllocatorVK( const DeviceVK& i_device ) :
+    m_device         ( i_device ),
+    m_dedicated_count( 0        ),
+    m_dedicated_size ( 0        )
+{
+}
+
+
+MemoryAllocatorVK::~MemoryAllocatorVK()
+{
+    shutdown();
+}
+
+
+MemoryAllocation MemoryAllocatorVK::allocate( const VkMemoryRequirements& i_requirements, const VkMemoryPropertyFlags i_properties, const bool i_linear )
+{
+    const uint32_t type = m_device.getMemoryTypeIndex( i_requirements.memoryTypeBits, i_properties );
+
+    MemoryAllocation allocation;
+    allocation.m_size = i_requirements.size;
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    //half a block or more would leave the rest of it mostly unusable
+    if( i_requirements.size > kMEMORY_BLOCK_SIZE / 2 )
+    {
+        allocation.m_memory = allocateMemory( type, i_requirements.size, i_linear, &allocation.m_mapped );
+
+        m_dedicated_count++;
+        m_dedicated_size += i_requirements.size;
+
+        return allocation;
+    }
+
+    uint32_t empty_slot = UINT32_MAX;
+
+    for( uint32_t block_idx = 0; block_idx < static_cast<uint32_t>( m_blocks.size() ); block_idx++ )
+    {
+        Block& block = m_blocks[ block_idx ];
+
+        if( block.m_memory == VK_NULL_HANDLE )
+        {
+            empty_slot = std::min( empty_slot, block_idx );
+            continue;
+        }
+
+        if( block.m_type != type || block.m_linear != i_linear || !suballocate( block, i_requirements, allocation.m_offset ) )
+        {
+            continue;
+        }
+
+        allocation.m_memory = block.m_memory;
+        allocation.m_block  = block_idx;
+        allocation.m_mapped = block.m_mapped ? block.m_mapped + allocation.m_offset : nullptr;
+
+        return allocation;
+    }
+
+    if( empty_slot == UINT32_MAX )
+    {
+        empty_slot = static_cast<uint32_t>( m_blocks.size() );
+        m_blocks.emplace_back();
+    }
+
+    Block& block = m_blocks[ empty_slot ];
+
+    void* mapped   = nullptr;
+    block.m_memory = allocateMemory( type, kMEMORY_BLOCK_SIZE, i_linear, &mapped );
+    block.m_size   = kMEMORY_BLOCK_SIZE;
+    block.m_type   = type;
+    block.m_linear = i_linear;
+    block.m_mapped = static_cast<uint8_t*>( mapped );
+    block.m_free.clear();
+    block.m_free[ 0 ] = kMEMORY_BLOCK_SIZE;
+
+    suballocate( block, i_requirements, allocation.m_offset );
+
+    allocation.m_memory = block.m_memory;
+    allocation.m_block  = empty_slot;
+    allocation.m_mapped = block.m_mapped ? block.m_mapped + allocation.m_offset : nullptr;
+
+    return allocation;
+}
+
+
+void MemoryAllocatorVK::free( MemoryAllocation& io_allocation )
+{
+    if( io_allocation.m_memory == VK_NULL_HANDLE )
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( io_allocation.m_block == UINT32_MAX )
+    {
+        vkFreeMemory( m_device.getLogicalDevice(), io_allocation.m_memory, nullptr );
+
+        m_dedicated_count--;
+        m_dedicated_size -= io_allocation.m_size;
+    }
+    else
+    {
+        Block& block = m_blocks[ io_allocation.m_block ];
+        assert( block.m_memory == io_allocation.m_memory );
+
+        auto it = block.m_free.insert( { io_allocation.m_offset, io_allocation.m_size } ).first;
+
+        auto next = std::next( it );
+        if( next != block.m_free.end() && it->first + it->second == next->first )
+        {
+            it->second += next->second;
+            block.m_free.erase( next );
+        }
+
+        if( it != block.m_free.begin() )
+        {
+            auto previous = std::prev( it );
+            if( previous->first + previous->second == it->first )
+            {
+                previous->second += it->second;
+                block.m_free.erase( it );
+            }
+        }
+
+        block.m_allocations--;
+
+        //one empty block of a kind is kept around so resizing does not allocate and free it every time
+        if( block.m_allocations == 0 )
+        {
+            for( uint32_t block_idx = 0; block_idx < static_cast<uint32_t>( m_blocks.size() ); block_idx++ )
+            {
+                const Block& other = m_blocks[ block_idx ];
+
+                if( block_idx != io_allocation.m_block && other.m_memory != VK_NULL_HANDLE && other.m_allocations == 0 &&
+                    other.m_type == block.m_type && other.m_linear == block.m_linear )
+                {
+                    releaseBlock( io_allocation.m_block );
+                    break;
+                }
+            }
+        }
+    }
+
+    io_allocation = MemoryAllocation();
+}
+
+
+void MemoryAllocatorVK::shutdown()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    for( uint32_t block_idx = 0; block_idx < static_cast<uint32_t>( m_blocks.size() ); block_idx++ )
+    {
+        if( m_blocks[ block_idx ].m_memory == VK_NULL_HANDLE )
+        {
+            continue;
+        }
+
+        if( m_blocks[ block_idx ].m_allocations > 0 )
+        {
+            std::cerr << tfm::format( "Memory block %d released with %d live allocations\n", block_idx, m_blocks[ block_idx ].m_allocations );
+        }
+
+        releaseBlock( block_idx );
+    }
+
+    if( m_dedicated_count > 0 )
+    {
+        std::cerr << tfm::format( "%d dedicated allocations were never freed\n", m_dedicated_count );
+    }
+
+    m_blocks.clear();
+}
+
+
+MemoryAllocatorVK::Stats MemoryAllocatorVK::getStats() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    Stats stats;
+    stats.m_dedicated = m_dedicated_count;
+
+    for( const auto& block : m_blocks )
+    {
+        if( block.m_memory == VK_NULL_HANDLE )
+        {
+            continue;
+        }
+
+        stats.m_blocks++;
+        stats.m_allocations += block.m_allocations;
+        stats.m_free_ranges += static_cast<uint32_t>( block.m_free.size() );
+        stats.m_reserved    += block.m_size;
+        stats.m_used        += block.m_size;
+
+        for( const auto& range : block.m_free )
+        {
+            stats.m_used        -= range.second;
+            stats.m_largest_free = std::max( stats.m_largest_free, range.second );
+        }
+    }
+
+    //dedicated memory is never partially free, it only adds to the totals
+    stats.m_allocations += m_dedicated_count;
+    stats.m_reserved    += m_dedicated_size;
+    stats.m_used        += m_dedicated_size;
+
+    return stats;
+}
+
+
+void MemoryAllocatorVK::printStats( std::ostream& o_stream ) const
+{
+    const Stats stats = getStats();
+
+    o_stream << tfm::format( "Device memory: %.2f MB used of %.2f MB in %d blocks and %d dedicated allocations\n",
+                             toMegabytes( stats.m_used ), toMegabytes( stats.m_reserved ), stats.m_blocks, stats.m_dedicated );
+    o_stream << tfm::format( "  %d allocations, %d free ranges, largest free range %.2f MB, fragmentation %.1f%%\n",
+                             stats.m_allocations, stats.m_free_ranges, toMegabytes( stats.m_largest_free ), stats.getFragmentation() * 100.0f );
+}
+
+
+VkDeviceMemory MemoryAllocatorVK::allocateMemory( const uint32_t i_type, const VkDeviceSize i_size, const bool i_linear, void** o_mapped )
+{
+    VkMemoryAllocateInfo alloc_info{};
+    alloc_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize  = i_size;
+    alloc_info.memoryTypeIndex = i_type;
+
+    //every buffer may end up queried for its device address
+    VkMemoryAllocateFlagsInfo allocate_flags{};
+    allocate_flags.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    allocate_flags.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+
+    if( i_linear && m_device.supportsBufferDeviceAddress() )
+    {
+        alloc_info.pNext = &allocate_flags;
+    }
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if( VK_SUCCESS != vkAllocateMemory( m_device.getLogicalDevice(), &alloc_info, nullptr, &memory ) )
+    {
+        throw MiniEngineException( "Issue allocating %d bytes of device memory", i_size );
+    }
+
+    *o_mapped = nullptr;
+    if( m_device.getMemoryProperties().memoryTypes[ i_type ].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+    {
+        if( VK_SUCCESS != vkMapMemory( m_device.getLogicalDevice(), memory, 0, VK_WHOLE_SIZE, 0, o_mapped ) )
+        {
+            throw MiniEngineException( "Issue mapping device memory" );
+        }
+    }
+
+    return memory;
+}
+
+
+bool MemoryAllocatorVK::suballocate( Block& io_block, const VkMemoryRequirements& i_requirements, VkDeviceSize& o_offset )
+{
+    //best fit, the smallest free range that still holds the aligned resource
+    auto best = io_block.m_free.end();
+
+    for( auto it = io_block.m_free.begin(); it != io_block.m_free.end(); ++it )
+    {
+        const VkDeviceSize aligned = alignUp( it->first, i_requirements.alignment );
+
+        if( aligned + i_requirements.size > it->first + it->second )
+        {
+            continue;
+        }
+
+        if( best == io_block.m_free.end() || it->second < best->second )
+        {
+            best = it;
+        }
+    }
+
+    if( best == io_block.m_free.end() )
+    {
+        return false;
+    }
+
+    const VkDeviceSize range_offset = best->first;
+    const VkDeviceSize range_end    = best->first + best->second;
+    const VkDeviceSize aligned      = alignUp( range_offset, i_requirements.alignment );
+
+    io_block.m_free.erase( best );
+
+    //the padding in front stays free and merges back once its neighbour is released
+    if( aligned > range_offset )
+    {
+        io_block.m_free[ range_offset ] = aligned - range_offset;
+    }
+
+    if( aligned + i_requirements.size < range_end )
+    {
+        io_block.m_free[ aligned + i_requirements.size ] = range_end - aligned - i_requirements.size;
+    }
+
+    io_block.m_allocations++;
+    o_offset = aligned;
+
+    return true;
+}
+
+
+void MemoryAllocatorVK::releaseBlock( const uint32_t i_block )
+{
+    Block& block = m_blocks[ i_block ];
+
+    if( block.m_mapped )
+    {
+        vkUnmapMemory( m_device.getLogicalDevice(), block.m_memory );
+    }
+
+    vkFreeMemory( m_device.getLogicalDevice(), block.m_memory, nullptr );
+
+    block = Block();
+}
@@ -4,49 +4,55 @@
 #include "vulkan/rendererVK.h"
 #include "vulkan/deviceVK.h"
 #include "vulkan/utilsVK.h"
+#include "vulkan/uploadManagerVK.h"
 
 using namespace MiniEngine;
 
 
 
-MeshVK::MeshVK( const Runtime& i_runtime, const std::string& i_path, const std::vector<uint32_t> i_indices, const std::vector<Vertex> i_vertices ) :
-    m_runtime       ( i_runtime   ),
-    m_path          ( i_path      ),
-    m_indices       ( i_indices   ),
-    m_vertices      ( i_vertices  ),
-    m_indices_buffer( VK_NULL_HANDLE ),
-    m_data_buffer   ( VK_NULL_HANDLE ),
+MeshVK::MeshVK( const Runtime& i_runtime, const std::string& i_path, const MeshCache::View& i_geometry, const VertexFormat i_format, const bool i_position_stream, const VkIndexType i_index_type ) :
+    m_runtime        ( i_runtime   ),
+    m_path           ( i_path      ),
+    m_geometry       ( i_geometry  ),
+    m_format         ( i_format    ),
+    m_position_stream( i_position_stream ),
+    m_index_type     ( i_index_type ),
+    m_upload_ticket ( 0 ),
 	m_blas_buffer   (VK_NULL_HANDLE),
-    m_blas_memory   (VK_NULL_HANDLE),
 	m_blas_structure(VK_NULL_HANDLE)
 {
+    //geometry without a lod chain draws all its indices
+    if( m_geometry.m_lod_count == 0 )
+    {
+        m_geometry.m_lods[ 0 ].m_index_offset = 0;
+        m_geometry.m_lods[ 0 ].m_index_count  = m_geometry.m_index_count;
+        m_geometry.m_lods[ 0 ].m_error        = 0.0f;
+        m_geometry.m_lod_count                = 1;
+    }
 
+    m_meshlets.assign( m_geometry.m_meshlets, m_geometry.m_meshlets + m_geometry.m_meshlet_count );
+    m_geometry.m_meshlets = nullptr;
 }
 
 
 bool MeshVK::initialize()
 {
-    assert( !m_indices.empty() && !m_vertices.empty() );
+    assert( m_geometry.m_index_count > 0 && m_geometry.m_vertex_count > 0 );
+    assert( m_index_type == VK_INDEX_TYPE_UINT32 || m_geometry.m_vertex_count <= UINT16_MAX );
 
-    if( !m_indices.empty() )
-    {
-        createIndexBuffer();
+    m_allocation = m_runtime.m_geometry_arena->allocate( m_format, m_geometry.m_vertex_count, m_geometry.m_index_count, m_index_type, m_position_stream );
 
-        UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t) m_indices_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Indices Buffer" );
-        UtilsVK::setObjectTag ( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t) m_indices_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, 0, m_path.size(), m_path.c_str() );
-    }
+    uploadIndices();
+    uploadVertices( m_geometry.m_vertices, m_geometry.m_vertex_count, VertexStream::Interleaved );
 
-    if( !m_vertices.empty() )
+    if( m_position_stream )
     {
-        m_data_buffer = createVertexBuffer( m_vertices, m_data_memory );
-
-        UtilsVK::setObjectName( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t) m_indices_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Vertex Buffer"                  );
-        UtilsVK::setObjectTag ( m_runtime.m_renderer->getDevice()->getLogicalDevice(), (uint64_t) m_indices_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, 0, m_path.size(), m_path.c_str() );
+        uploadVertices( m_geometry.m_vertices, m_geometry.m_vertex_count, VertexStream::Position );
     }
 
-#ifdef RTX
-    createBLASBuffer(); 
-#endif
+    //the upload staged its own copy, the arrays may belong to a mapping about to be closed
+    m_geometry.m_vertices = nullptr;
+    m_geometry.m_indices  = nullptr;
 
     return true;
 }
@@ -56,98 +62,117 @@ void MeshVK::shutdown()
 {
     const RendererVK&  renderer = *m_runtime.m_renderer;
 
-    if( m_indices_buffer )
-    {
-        vkDestroyBuffer( renderer.getDevice()->getLogicalDevice(), m_indices_buffer, nullptr );
-        vkFreeMemory   ( renderer.getDevice()->getLogicalDevice(), m_indices_memory, nullptr );
-    }
-
-    if( m_data_buffer )
-    {
-        vkDestroyBuffer( renderer.getDevice()->getLogicalDevice(), m_data_buffer, nullptr );
-        vkFreeMemory   ( renderer.getDevice()->getLogicalDevice(), m_data_memory, nullptr );
-    }
+    m_runtime.m_geometry_arena->free( m_allocation );
 
 #ifdef RTX
     if (m_blas_buffer)
     {
         vkDestroyAccelerationStructure(renderer.getDevice()->getLogicalDevice(), m_blas_structure, nullptr);
-        vkDestroyBuffer(renderer.getDevice()->getLogicalDevice(), m_blas_buffer, nullptr);
-        vkFreeMemory(renderer.getDevice()->getLogicalDevice(), m_blas_memory, nullptr);
+        UtilsVK::freeBuffer(*renderer.getDevice(), m_blas_buffer, m_blas_memory);
     }
 #endif
 }
 
 
-void MeshVK::draw( VkCommandBuffer& i_command_buffer, const uint32_t i_instance_id )
+void MeshVK::draw( VkCommandBuffer& i_command_buffer, const uint32_t i_instance_id, const uint32_t i_lod, const VertexStream i_stream, GeometryBinding* io_binding )
 {
-    VkBuffer data_buffers[] = { m_data_buffer };
-    VkDeviceSize offsets [] = { 0 };
+    assert( i_lod < m_geometry.m_lod_count );
+    assert( i_stream == VertexStream::Interleaved || m_position_stream );
+
+    const MeshLod& lod = m_geometry.m_lods[ i_lod ];
 
     UtilsVK::beginRegion( i_command_buffer, m_path.c_str(), Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ) );
     UtilsVK::insert( i_command_buffer, m_path.c_str(), Vector4f( 0.0f, 0.5f, 0.5f, 1.0f ) );
 
-    vkCmdBindIndexBuffer( i_command_buffer, m_indices_buffer, 0, VK_INDEX_TYPE_UINT32 );
-    vkCmdBindVertexBuffers( i_command_buffer, 0, 1, data_buffers, offsets );
-    vkCmdDrawIndexed( i_command_buffer, static_cast<uint32_t>( m_indices.size() ), 1, 0, 0, i_instance_id );
+    GeometryBinding binding;
+    m_runtime.m_geometry_arena->bind( i_command_buffer, m_allocation, i_stream, io_binding ? *io_binding : binding );
+    vkCmdDrawIndexed( i_command_buffer, lod.m_index_count, 1, m_allocation.m_first_index + lod.m_index_offset, getVertexOffset(), i_instance_id );
 
     UtilsVK::endRegion( i_command_buffer );
 }
 
 
-VkBuffer MeshVK::createVertexBuffer( const std::vector<Vertex>& i_data, VkDeviceMemory& i_memory )
+void MeshVK::drawIndirect( VkCommandBuffer& i_command_buffer, VkBuffer i_buffer, const VkDeviceSize i_offset, const uint32_t i_draw_count, const bool i_multi_draw, const VertexStream i_stream,
+                           GeometryBinding* io_binding )
 {
-    VkBuffer staging_buffer, vertex_buffer;
-    VkDeviceMemory staging_memory;
-
-    size_t size = sizeof( Vertex )*i_data.size();
+    assert( i_stream == VertexStream::Interleaved || m_position_stream );
 
-    UtilsVK::createBuffer( *m_runtime.m_renderer->getDevice(), size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_memory );
-
-    void* data;
-    vkMapMemory( m_runtime.m_renderer->getDevice()->getLogicalDevice(), staging_memory, 0, size, 0, &data );
-    memcpy( data, i_data.data(), size );
-    vkUnmapMemory( m_runtime.m_renderer->getDevice()->getLogicalDevice(), staging_memory );
+    UtilsVK::beginRegion( i_command_buffer, m_path.c_str(), Vector4f( 0.0f, 0.0f, 1.0f, 1.0f ) );
 
+    //the commands already carry the arena offsets of the mesh
+    GeometryBinding binding;
+    m_runtime.m_geometry_arena->bind( i_command_buffer, m_allocation, i_stream, io_binding ? *io_binding : binding );
 
-    UtilsVK::createBuffer(*m_runtime.m_renderer->getDevice(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertex_buffer, i_memory);
+    if( i_multi_draw )
+    {
+        vkCmdDrawIndexedIndirect( i_command_buffer, i_buffer, i_offset, i_draw_count, sizeof( VkDrawIndexedIndirectCommand ) );
+    }
+    else
+    {
+        for( uint32_t draw = 0; draw < i_draw_count; draw++ )
+        {
+            vkCmdDrawIndexedIndirect( i_command_buffer, i_buffer, i_offset + draw * sizeof( VkDrawIndexedIndirectCommand ), 1, sizeof( VkDrawIndexedIndirectCommand ) );
+        }
+    }
 
-    UtilsVK::copyBuffer( *m_runtime.m_renderer->getDevice(), staging_buffer, vertex_buffer, size );
+    UtilsVK::endRegion( i_command_buffer );
+}
 
-    vkDestroyBuffer( m_runtime.m_renderer->getDevice()->getLogicalDevice(), staging_buffer, nullptr );
-    vkFreeMemory   ( m_runtime.m_renderer->getDevice()->getLogicalDevice(), staging_memory, nullptr );
 
-    return vertex_buffer;
+void MeshVK::uploadVertices( const Vertex* i_data, const uint32_t i_count, const VertexStream i_stream )
+{
+    std::vector<uint8_t> packed;
+    VertexLayouts::visit( m_format, [ & ]( auto i_layout )
+    {
+        using Layout = decltype( i_layout );
+
+        if( i_stream == VertexStream::Position )
+        {
+            Layout::packPositions( i_data, i_count, m_geometry.m_bounds_min, m_geometry.m_bounds_max, packed );
+        }
+        else
+        {
+            m_dequantization = Layout::pack( i_data, i_count, m_geometry.m_bounds_min, m_geometry.m_bounds_max, packed );
+        }
+    } );
+
+    const GeometryArenaVK& arena = *m_runtime.m_geometry_arena;
+
+    //only recorded here, the copy is submitted with the other uploads of the batch
+    m_upload_ticket = std::max( m_upload_ticket, m_runtime.m_renderer->getDevice()->getUploadManager().uploadBuffer( arena.getVertexBuffer( m_allocation, i_stream ), packed.data(), packed.size(),
+                                                                                                                     arena.getVertexOffset( m_allocation, i_stream ) ) );
 }
 
-void MeshVK::createIndexBuffer()
+void MeshVK::uploadIndices()
 {
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_memory;
+    const GeometryArenaVK& arena = *m_runtime.m_geometry_arena;
 
-    size_t size = sizeof( uint32_t )*m_indices.size();
-
-    UtilsVK::createBuffer( *m_runtime.m_renderer->getDevice(), size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer, staging_memory );
-
-    void* data;
-    vkMapMemory( m_runtime.m_renderer->getDevice()->getLogicalDevice(), staging_memory, 0, size, 0, &data );
-    memcpy( data, m_indices.data(), size );
-    vkUnmapMemory( m_runtime.m_renderer->getDevice()->getLogicalDevice(), staging_memory );
+    const void* data = m_geometry.m_indices;
+    size_t      size = sizeof( uint32_t )*m_geometry.m_index_count;
 
+    //narrowed here, the cache and the optimizer keep 32 bit indices
+    std::vector<uint16_t> short_indices;
+    if( m_index_type == VK_INDEX_TYPE_UINT16 )
+    {
+        short_indices.assign( m_geometry.m_indices, m_geometry.m_indices + m_geometry.m_index_count );
 
-    UtilsVK::createBuffer(*m_runtime.m_renderer->getDevice(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | 
-        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_indices_buffer, m_indices_memory);
+        data = short_indices.data();
+        size = sizeof( uint16_t )*m_geometry.m_index_count;
+    }
 
-    UtilsVK::copyBuffer( *m_runtime.m_renderer->getDevice(), staging_buffer, m_indices_buffer, size );
+    m_upload_ticket = std::max( m_upload_ticket, m_runtime.m_renderer->getDevice()->getUploadManager().uploadBuffer( arena.getIndexBuffer( m_allocation ), data, size,
+                                                                                                                     arena.getIndexOffset( m_allocation ) ) );
+}
 
-    vkDestroyBuffer( m_runtime.m_renderer->getDevice()->getLogicalDevice(), staging_buffer, nullptr );
-    vkFreeMemory   ( m_runtime.m_renderer->getDevice()->getLogicalDevice(), staging_memory, nullptr );
+bool MeshVK::isUploaded() const
+{
+    return m_runtime.m_renderer->getDevice()->getUploadManager().isComplete( m_upload_ticket );
 }
 
+
 void MeshVK::createBLASBuffer()
 {
-    if (m_vertices.empty() || m_indices.empty())
+    if (m_geometry.m_vertex_count == 0 || m_geometry.m_index_count == 0)
     {
         std::cerr << "Cannot create BLAS - no vertex or index data available" << std::endl;
         return;
@@ -156,10 +181,7 @@ void MeshVK::createBLASBuffer()
     // Clean up any existing BLAS resources
     if (m_blas_buffer)
     {
-        vkDestroyBuffer(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_blas_buffer, nullptr);
-        vkFreeMemory(m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_blas_memory, nullptr);
-        m_blas_buffer = VK_NULL_HANDLE;
-        m_blas_memory = VK_NULL_HANDLE;
+        UtilsVK::freeBuffer(*m_runtime.m_renderer->getDevice(), m_blas_buffer, m_blas_memory);
     }
 
     if (m_blas_structure != NULL)
@@ -168,18 +190,56 @@ void MeshVK::createBLASBuffer()
         m_blas_structure = VK_NULL_HANDLE;
     }
 
+    //quantized positions are taken back to object space by the build
+    VkBuffer         transform_buffer = VK_NULL_HANDLE;
+    MemoryAllocation transform_memory;
+
+    if( m_format != VertexFormat::Float )
+    {
+        const Vector4f& scale  = m_dequantization.m_scale;
+        const Vector4f& offset = m_dequantization.m_offset;
+
+        const VkTransformMatrixKHR transform = { {
+            { scale.x, 0.0f   , 0.0f   , offset.x },
+            { 0.0f   , scale.y, 0.0f   , offset.y },
+            { 0.0f   , 0.0f   , scale.z, offset.z } } };
+
+        UtilsVK::createBuffer( *m_runtime.m_renderer->getDevice(), sizeof( VkTransformMatrixKHR ), VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, transform_buffer, transform_memory );
+
+        memcpy( transform_memory.m_mapped, &transform, sizeof( VkTransformMatrixKHR ) );
+    }
+
+    //the position stream is denser, the build only reads the positions
+    const GeometryArenaVK& arena   = *m_runtime.m_geometry_arena;
+    const VertexStream     stream  = m_position_stream ? VertexStream::Position : VertexStream::Interleaved;
+    const VkFormat position_format = VertexLayouts::visit( m_format, []( auto i_layout ) { return decltype( i_layout )::getPositionAttribute( 0 ).format; } );
+    const uint32_t vertex_stride   = VertexLayouts::visit( m_format, [ stream ]( auto i_layout ) { return stream == VertexStream::Position ? decltype( i_layout )::kPOSITION_STRIDE : decltype( i_layout )::kSTRIDE; } );
+
     // Create the BLAS using the helper function from UtilsVK
     UtilsVK::createBLAS(
         *m_runtime.m_renderer->getDevice(),
-        m_data_buffer,          // Vertex buffer
-        m_indices_buffer,       // Index buffer
-        m_vertices,             // Vertex data
-        m_indices,              // Index data
+        arena.getVertexBuffer( m_allocation, stream ), // Vertex block of the arena
+        arena.getVertexOffset( m_allocation, stream ), // Where the mesh starts in it
+        arena.getIndexBuffer( m_allocation ),          // Index block of the arena
+        arena.getIndexOffset( m_allocation ),          // Where the mesh starts in it
+        m_index_type,                                  // 16 bit for the small meshes
+        m_geometry.m_vertex_count, // Vertex count
+        m_geometry.m_lods[ 0 ].m_index_count, // Index count, the full mesh comes first in the buffer
+        position_format,        // Format of the positions, first attribute of the layout
+        vertex_stride,          // Stride of the stream
+        transform_buffer,       // Dequantization, or none
         m_blas_structure,       // Output BLAS structure
         m_blas_buffer,         // Output BLAS buffer
         m_blas_memory           // Output BLAS memory
     );
 
+    //the build waited for the queue
+    if( transform_buffer != VK_NULL_HANDLE )
+    {
+        UtilsVK::freeBuffer( *m_runtime.m_renderer->getDevice(), transform_buffer, transform_memory );
+    }
+
     // Set debug names and tags
     UtilsVK::setObjectName(
         m_runtime.m_renderer->getDevice()->getLogicalDevice(),
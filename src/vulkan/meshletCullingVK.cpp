@@ -0,0 +1,382 @@
+#include "common.h"
+#include "vulkan/utilsVK.h"
+#include "vulkan/meshletCullingVK.h"
+#include "vulkan/rendererVK.h"
+#include "vulkan/deviceVK.h"
+#include "vulkan/meshVK.h"
+#include "vulkan/uploadManagerVK.h"
+#include "runtime.h"
+#include "frame.h"
+#include "entity.h"
+#include "shaderRegistry.h"
+
+#include <unordered_map>
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    //must match the local size of meshlet_cull.comp
+    constexpr uint32_t kGROUP_SIZE = 64;
+
+    struct PushConstants
+    {
+        uint32_t m_entry_count;
+        uint32_t m_cone_culling;
+    };
+}
+
+
+MeshletCullingVK::MeshletCullingVK( const Runtime& i_runtime ) :
+    m_runtime              ( i_runtime      ),
+    m_enabled              ( false          ),
+    m_multi_draw           ( false          ),
+    m_cone_culling         ( false          ),
+    m_entry_count          ( 0              ),
+    m_pipeline             ( VK_NULL_HANDLE ),
+    m_pipeline_layout      ( VK_NULL_HANDLE ),
+    m_descriptor_set_layout( VK_NULL_HANDLE ),
+    m_descriptor_pool      ( VK_NULL_HANDLE ),
+    m_meshlet_buffer       ( VK_NULL_HANDLE ),
+    m_entry_buffer         ( VK_NULL_HANDLE )
+{
+    m_descriptor_sets.fill( VK_NULL_HANDLE );
+    m_command_buffers.fill( VK_NULL_HANDLE );
+}
+
+
+bool MeshletCullingVK::initialize()
+{
+    const VkPhysicalDeviceFeatures& features = m_runtime.m_renderer->getDevice()->getPhysicalDeviceFeatures();
+
+    //without it every command would draw object 0, the entities are then drawn whole
+    m_enabled    = features.drawIndirectFirstInstance == VK_TRUE;
+    m_multi_draw = features.multiDrawIndirect == VK_TRUE;
+
+    if( !m_enabled )
+    {
+        std::cout << "Meshlet culling: drawIndirectFirstInstance is not supported, drawing whole meshes\n";
+        return true;
+    }
+
+    //release builds have no assert to stop a pipeline without its shader
+    if( VK_NULL_HANDLE == m_runtime.m_shader_registry->loadShader( "./shaders/meshlet_cull_c.spv", VK_SHADER_STAGE_COMPUTE_BIT ) )
+    {
+        m_enabled = false;
+
+        std::cout << "Meshlet culling: meshlet_cull_c.spv could not be loaded, drawing whole meshes\n";
+        return true;
+    }
+
+    createPipeline   ();
+    createDescriptors();
+
+    return true;
+}
+
+
+void MeshletCullingVK::shutdown()
+{
+    if( !m_enabled )
+    {
+        return;
+    }
+
+    const VkDevice device = m_runtime.m_renderer->getDevice()->getLogicalDevice();
+
+    freeBuffers();
+
+    vkDestroyDescriptorPool     ( device, m_descriptor_pool      , nullptr );
+    vkDestroyDescriptorSetLayout( device, m_descriptor_set_layout, nullptr );
+    vkDestroyPipeline           ( device, m_pipeline             , nullptr );
+    vkDestroyPipelineLayout     ( device, m_pipeline_layout      , nullptr );
+}
+
+
+void MeshletCullingVK::build( const std::vector<std::shared_ptr<Entity>>& i_entities )
+{
+    if( !m_enabled )
+    {
+        return;
+    }
+
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    //the previous scene may still be drawn from the old buffers
+    if( m_entry_count > 0 )
+    {
+        vkDeviceWaitIdle( device.getLogicalDevice() );
+        freeBuffers();
+    }
+
+    //entities sharing a mesh share its meshlets
+    std::unordered_map<const MeshVK*, uint32_t> first_meshlets;
+    std::vector<Meshlet>                        meshlets;
+    std::vector<DrawEntry>                      entries;
+
+    m_draw_ranges.assign( kMAX_NUMBER_OF_OBJECTS, DrawRange() );
+
+    for( const auto& entity : i_entities )
+    {
+        const MeshVK&               mesh          = entity->getMesh();
+        const std::vector<Meshlet>& mesh_meshlets = mesh.getMeshlets();
+
+        if( mesh_meshlets.empty() )
+        {
+            continue;
+        }
+
+        auto first = first_meshlets.find( &mesh );
+        if( first == first_meshlets.end() )
+        {
+            first = first_meshlets.insert( { &mesh, static_cast<uint32_t>( meshlets.size() ) } ).first;
+
+            //the commands index the arena blocks, the meshlets are relative to the mesh
+            for( Meshlet meshlet : mesh_meshlets )
+            {
+                meshlet.m_index_offset += mesh.getFirstIndex();
+                meshlet.m_vertex_offset = mesh.getVertexOffset();
+                meshlets.push_back( meshlet );
+            }
+        }
+
+        DrawRange& range = m_draw_ranges[ entity->getEntityOffset() ];
+        range.m_first = static_cast<uint32_t>( entries.size() );
+        range.m_count = static_cast<uint32_t>( mesh_meshlets.size() );
+
+        for( uint32_t meshlet = 0; meshlet < range.m_count; meshlet++ )
+        {
+            entries.push_back( { first->second + meshlet, entity->getEntityOffset() } );
+        }
+    }
+
+    m_entry_count = static_cast<uint32_t>( entries.size() );
+
+    if( m_entry_count == 0 )
+    {
+        return;
+    }
+
+    const VkDeviceSize meshlets_size = sizeof( Meshlet ) * meshlets.size();
+    const VkDeviceSize entries_size  = sizeof( DrawEntry ) * entries.size();
+    const VkDeviceSize commands_size = sizeof( VkDrawIndexedIndirectCommand ) * entries.size();
+
+    UtilsVK::createBuffer( device, meshlets_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_meshlet_buffer, m_meshlet_memory );
+    UtilsVK::createBuffer( device, entries_size , VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_entry_buffer  , m_entry_memory   );
+
+    device.getUploadManager().uploadBuffer( m_meshlet_buffer, meshlets.data(), meshlets_size );
+    device.getUploadManager().uploadBuffer( m_entry_buffer  , entries.data() , entries_size  );
+
+    //draws are recorded after this, so they see the copies
+    device.getUploadManager().flush();
+
+    UtilsVK::setObjectName( device.getLogicalDevice(), (uint64_t) m_meshlet_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Meshlet Buffer"  );
+    UtilsVK::setObjectName( device.getLogicalDevice(), (uint64_t) m_entry_buffer  , VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Meshlet Entries" );
+
+    for( uint32_t i = 0; i < kMAX_NUMBER_OF_FRAMES; i++ )
+    {
+        UtilsVK::createBuffer( device, commands_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_command_buffers[ i ], m_command_memory[ i ] );
+        UtilsVK::setObjectName( device.getLogicalDevice(), (uint64_t) m_command_buffers[ i ], VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Meshlet Draw Commands" );
+
+        std::array<VkDescriptorBufferInfo, 5> buffer_infos;
+        buffer_infos[ 0 ] = { m_runtime.getPerFrameBuffer ()[ i ], 0, sizeof( PerFrameData ) };
+        buffer_infos[ 1 ] = { m_runtime.getPerObjectBuffer()[ i ], 0, sizeof( PerObjectData ) * kMAX_NUMBER_OF_OBJECTS };
+        buffer_infos[ 2 ] = { m_meshlet_buffer                   , 0, meshlets_size };
+        buffer_infos[ 3 ] = { m_entry_buffer                     , 0, entries_size  };
+        buffer_infos[ 4 ] = { m_command_buffers[ i ]             , 0, commands_size };
+
+        std::array<VkWriteDescriptorSet, 5> set_write{};
+
+        for( uint32_t binding = 0; binding < static_cast<uint32_t>( set_write.size() ); binding++ )
+        {
+            set_write[ binding ].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            set_write[ binding ].dstBinding      = binding;
+            set_write[ binding ].dstSet          = m_descriptor_sets[ i ];
+            set_write[ binding ].descriptorCount = 1;
+            set_write[ binding ].descriptorType  = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            set_write[ binding ].pBufferInfo     = &buffer_infos[ binding ];
+        }
+
+        vkUpdateDescriptorSets( device.getLogicalDevice(), static_cast<uint32_t>( set_write.size() ), set_write.data(), 0, nullptr );
+    }
+
+    std::cout << tfm::format( "Meshlet culling: %d meshlets, %d draws\n", meshlets.size(), entries.size() );
+}
+
+
+void MeshletCullingVK::cull( VkCommandBuffer i_command_buffer, const Frame& i_frame ) const
+{
+    if( !isEnabled() )
+    {
+        return;
+    }
+
+    const PushConstants constants = { m_entry_count, m_cone_culling ? 1u : 0u };
+
+    UtilsVK::beginRegion( i_command_buffer, "Meshlet Culling", Vector4f( 0.5f, 0.0f, 0.5f, 1.0f ) );
+
+    vkCmdBindPipeline      ( i_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline );
+    vkCmdBindDescriptorSets( i_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline_layout, 0, 1, &m_descriptor_sets[ i_frame.m_frame_index ], 0, nullptr );
+    vkCmdPushConstants     ( i_command_buffer, m_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( PushConstants ), &constants );
+    vkCmdDispatch          ( i_command_buffer, ( m_entry_count + kGROUP_SIZE - 1 ) / kGROUP_SIZE, 1, 1 );
+
+    //also covers the later passes of the frame that draw from the same commands
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = m_command_buffers[ i_frame.m_frame_index ];
+    barrier.offset              = 0;
+    barrier.size                = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier( i_command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr );
+
+    UtilsVK::endRegion( i_command_buffer );
+}
+
+
+bool MeshletCullingVK::drawEntity( VkCommandBuffer i_command_buffer, const Frame& i_frame, const Entity& i_entity, const VertexStream i_stream, GeometryBinding* io_binding ) const
+{
+    if( !isEnabled() || i_entity.getEntityOffset() >= m_draw_ranges.size() )
+    {
+        return false;
+    }
+
+    const DrawRange& range = m_draw_ranges[ i_entity.getEntityOffset() ];
+    if( range.m_count == 0 )
+    {
+        return false;
+    }
+
+    i_entity.getMesh().drawIndirect( i_command_buffer, m_command_buffers[ i_frame.m_frame_index ], sizeof( VkDrawIndexedIndirectCommand ) * range.m_first, range.m_count, m_multi_draw, i_stream, io_binding );
+
+    return true;
+}
+
+
+void MeshletCullingVK::createPipeline()
+{
+    const VkDevice device = m_runtime.m_renderer->getDevice()->getLogicalDevice();
+
+    VkShaderModule comp_module = m_runtime.m_shader_registry->loadShader( "./shaders/meshlet_cull_c.spv", VK_SHADER_STAGE_COMPUTE_BIT );
+
+    assert( VK_NULL_HANDLE != comp_module );
+
+    std::array<VkDescriptorSetLayoutBinding, 5> layout_bindings{};
+
+    const std::array<VkDescriptorType, 5> types = {
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, //per frame
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, //per object
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, //meshlets
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, //draw entries
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER  //draw commands
+    };
+
+    for( uint32_t binding = 0; binding < static_cast<uint32_t>( layout_bindings.size() ); binding++ )
+    {
+        layout_bindings[ binding ].binding         = binding;
+        layout_bindings[ binding ].descriptorCount = 1;
+        layout_bindings[ binding ].descriptorType  = types[ binding ];
+        layout_bindings[ binding ].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo set_info = {};
+    set_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    set_info.bindingCount = static_cast<uint32_t>( layout_bindings.size() );
+    set_info.pBindings    = layout_bindings.data();
+
+    if( VK_SUCCESS != vkCreateDescriptorSetLayout( device, &set_info, nullptr, &m_descriptor_set_layout ) )
+    {
+        throw MiniEngineException( "Error creating descriptor set" );
+    }
+
+    VkPushConstantRange push_constant_range{};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_constant_range.offset     = 0;
+    push_constant_range.size       = sizeof( PushConstants );
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info{};
+    pipeline_layout_info.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount         = 1;
+    pipeline_layout_info.pSetLayouts            = &m_descriptor_set_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges    = &push_constant_range;
+
+    if( VK_SUCCESS != vkCreatePipelineLayout( device, &pipeline_layout_info, nullptr, &m_pipeline_layout ) )
+    {
+        throw MiniEngineException( "Error creating the pipeline layout" );
+    }
+
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_info.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_info.stage.module = comp_module;
+    pipeline_info.stage.pName  = "main";
+    pipeline_info.layout       = m_pipeline_layout;
+
+    if( VK_SUCCESS != vkCreateComputePipelines( device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &m_pipeline ) )
+    {
+        throw MiniEngineException( "Error creating the pipeline" );
+    }
+}
+
+
+void MeshletCullingVK::createDescriptors()
+{
+    const VkDevice device = m_runtime.m_renderer->getDevice()->getLogicalDevice();
+
+    std::vector<VkDescriptorPoolSize> sizes =
+    {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, kMAX_NUMBER_OF_FRAMES     },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, kMAX_NUMBER_OF_FRAMES * 4 }
+    };
+
+    VkDescriptorPoolCreateInfo pool_info = {};
+    pool_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.maxSets       = kMAX_NUMBER_OF_FRAMES;
+    pool_info.poolSizeCount = static_cast<uint32_t>( sizes.size() );
+    pool_info.pPoolSizes    = sizes.data();
+
+    if( VK_SUCCESS != vkCreateDescriptorPool( device, &pool_info, nullptr, &m_descriptor_pool ) )
+    {
+        throw MiniEngineException( "Error creating descriptor pool" );
+    }
+
+    //written by build once the buffers exist
+    for( uint32_t i = 0; i < kMAX_NUMBER_OF_FRAMES; i++ )
+    {
+        VkDescriptorSetAllocateInfo alloc_info = {};
+        alloc_info.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool     = m_descriptor_pool;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts        = &m_descriptor_set_layout;
+
+        vkAllocateDescriptorSets( device, &alloc_info, &m_descriptor_sets[ i ] );
+    }
+}
+
+
+void MeshletCullingVK::freeBuffers()
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    if( m_meshlet_buffer != VK_NULL_HANDLE )
+    {
+        UtilsVK::freeBuffer( device, m_meshlet_buffer, m_meshlet_memory );
+        UtilsVK::freeBuffer( device, m_entry_buffer  , m_entry_memory   );
+    }
+
+    for( uint32_t i = 0; i < kMAX_NUMBER_OF_FRAMES; i++ )
+    {
+        if( m_command_buffers[ i ] != VK_NULL_HANDLE )
+        {
+            UtilsVK::freeBuffer( device, m_command_buffers[ i ], m_command_memory[ i ] );
+        }
+    }
+
+    m_entry_count = 0;
+}
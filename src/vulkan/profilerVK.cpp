@@ -0,0 +1,389 @@
+#include "vulkan/profilerVK.h"
+#include "vulkan/rendererVK.h"
+#include "vulkan/deviceVK.h"
+#include "vulkan/utilsVK.h"
+#include "runtime.h"
+#include "frame.h"
+#include <thread>
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    constexpr uint32_t kGPU_TRACE_THREAD = 0;
+
+    //cpu threads show up in the trace as 1, 2, ... in the order they first report a scope
+    uint32_t getTraceThread()
+    {
+        static std::mutex                                 s_mutex;
+        static std::unordered_map<std::thread::id, uint32_t> s_threads;
+
+        std::lock_guard<std::mutex> lock( s_mutex );
+        auto it = s_threads.find( std::this_thread::get_id() );
+        if( it == s_threads.end() )
+        {
+            it = s_threads.insert( { std::this_thread::get_id(), static_cast<uint32_t>( s_threads.size() ) + 1 } ).first;
+        }
+
+        return it->second;
+    }
+
+    std::string escapeJson( const std::string& i_text )
+    {
+        std::string escaped;
+        escaped.reserve( i_text.size() );
+
+        for( char c : i_text )
+        {
+            if( c == '"' || c == '\\' )
+            {
+                escaped.push_back( '\\' );
+            }
+            escaped.push_back( c );
+        }
+
+        return escaped;
+    }
+}
+
+
+ProfilerVK::ProfilerVK( const Runtime& i_runtime ) :
+    m_runtime         ( i_runtime                                   ),
+    m_query_pool      ( VK_NULL_HANDLE                              ),
+    m_gpu_timing      ( false                                       ),
+    m_timestamp_period( 1.0f                                        ),
+    m_graphics_mask   ( 0                                           ),
+    m_compute_mask    ( 0                                           ),
+    m_trace_enabled   ( false                                       ),
+    m_origin          ( std::chrono::high_resolution_clock::now()   )
+{
+}
+
+
+bool ProfilerVK::initialize()
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    auto getMask = []( const uint32_t i_valid_bits )
+    {
+        return i_valid_bits >= 64 ? ~0ull : ( ( 1ull << i_valid_bits ) - 1 );
+    };
+
+    m_timestamp_period = device.getPhysicalDeviceProperties().limits.timestampPeriod;
+    m_graphics_mask    = getMask( device.getGraphicsQueueFamilyProperties().timestampValidBits );
+    m_compute_mask     = getMask( device.getComputeQueueFamilyProperties ().timestampValidBits );
+    m_gpu_timing       = m_graphics_mask != 0 && m_timestamp_period > 0.0f;
+
+    if( m_gpu_timing && m_compute_mask == 0 )
+    {
+        std::cerr << "Timestamps not supported by the compute queue, its passes are not timed" << std::endl;
+    }
+
+    if( !m_gpu_timing )
+    {
+        std::cerr << "Timestamps not supported by the graphics queue, gpu timings are disabled" << std::endl;
+        return true;
+    }
+
+    VkQueryPoolCreateInfo pool_info{};
+    pool_info.sType         = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType     = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount    = kMAX_NUMBER_OF_FRAMES * kPROFILER_MAX_GPU_SCOPES * 2;
+
+    if( VK_SUCCESS != vkCreateQueryPool( device.getLogicalDevice(), &pool_info, nullptr, &m_query_pool ) )
+    {
+        throw MiniEngineException( "Error creating the timestamp query pool" );
+    }
+
+    UtilsVK::setObjectName( device.getLogicalDevice(), (uint64_t)m_query_pool, VK_DEBUG_REPORT_OBJECT_TYPE_QUERY_POOL_EXT, "Profiler Timestamps" );
+
+    return true;
+}
+
+
+void ProfilerVK::shutdown()
+{
+    if( m_query_pool != VK_NULL_HANDLE )
+    {
+        vkDestroyQueryPool( m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_query_pool, nullptr );
+        m_query_pool = VK_NULL_HANDLE;
+    }
+
+    for( auto& frame : m_frames )
+    {
+        frame.m_scopes.clear();
+    }
+
+    m_scope_names.clear();
+    m_scope_masks.clear();
+    m_scope_ids  .clear();
+}
+
+
+void ProfilerVK::beginFrame( const Frame& i_frame )
+{
+    assert( i_frame.m_frame_index < kMAX_NUMBER_OF_FRAMES );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    FrameQueries& frame = m_frames[ i_frame.m_frame_index ];
+
+    if( m_gpu_timing && !frame.m_scopes.empty() )
+    {
+        //the fence of this slot is signaled, so results are already there and this never stalls
+        std::vector<std::array<uint64_t, 2>> ticks( frame.m_scopes.size() );
+        std::vector<bool>                    valid( frame.m_scopes.size(), false );
+        uint64_t                             first_tick = UINT64_MAX;
+
+        for( size_t idx = 0; idx < frame.m_scopes.size(); idx++ )
+        {
+            if( VK_SUCCESS == vkGetQueryPoolResults( m_runtime.m_renderer->getDevice()->getLogicalDevice(), m_query_pool, getQuery( i_frame, frame.m_scopes[ idx ] ), 2,
+                                                     sizeof( uint64_t ) * 2, ticks[ idx ].data(), sizeof( uint64_t ), VK_QUERY_RESULT_64_BIT ) )
+            {
+                const uint64_t mask = m_scope_masks[ frame.m_scopes[ idx ] ];
+
+                ticks[ idx ][ 0 ] &= mask;
+                ticks[ idx ][ 1 ] &= mask;
+                valid[ idx ]       = ticks[ idx ][ 1 ] >= ticks[ idx ][ 0 ];
+                first_tick         = valid[ idx ] ? std::min( first_tick, ticks[ idx ][ 0 ] ) : first_tick;
+            }
+        }
+
+        const double us_per_tick = static_cast<double>( m_timestamp_period ) / 1000.0;
+
+        for( size_t idx = 0; idx < frame.m_scopes.size(); idx++ )
+        {
+            if( !valid[ idx ] )
+            {
+                continue;
+            }
+
+            const double duration_us = static_cast<double>( ticks[ idx ][ 1 ] - ticks[ idx ][ 0 ] ) * us_per_tick;
+            //gpu clock has its own time base, anchor the first timestamp of the frame at its submit time
+            const double start_us    = frame.m_submit_us + static_cast<double>( ticks[ idx ][ 0 ] - first_tick ) * us_per_tick;
+
+            const std::string& name = m_scope_names[ frame.m_scopes[ idx ] ];
+
+            m_gpu_averages[ name ].add( static_cast<float>( duration_us / 1000.0 ) );
+            addTraceEvent( name, "gpu", start_us, duration_us, kGPU_TRACE_THREAD );
+        }
+    }
+
+    frame.m_scopes.clear();
+}
+
+
+void ProfilerVK::endFrame( const Frame& i_frame )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_frames[ i_frame.m_frame_index ].m_submit_us = now();
+}
+
+
+uint32_t ProfilerVK::beginRegion( VkCommandBuffer i_cmd_buffer, const Frame& i_frame, const char* i_name, const Vector4f& i_color, const uint32_t i_queue_family )
+{
+    UtilsVK::beginRegion( i_cmd_buffer, i_name, i_color );
+
+    //resets and writes are invalid on a family without timestamps
+    const uint64_t mask = getTimestampMask( i_queue_family );
+
+    if( !m_gpu_timing || mask == 0 )
+    {
+        return UINT32_MAX;
+    }
+
+    uint32_t scope_id;
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto it = m_scope_ids.find( i_name );
+        if( it == m_scope_ids.end() )
+        {
+            if( m_scope_names.size() >= kPROFILER_MAX_GPU_SCOPES )
+            {
+                return UINT32_MAX;
+            }
+
+            it = m_scope_ids.insert( { i_name, static_cast<uint32_t>( m_scope_names.size() ) } ).first;
+            m_scope_names.push_back( i_name );
+            m_scope_masks.push_back( mask );
+        }
+
+        scope_id = it->second;
+    }
+
+    submitRegion( i_frame, scope_id );
+
+    const uint32_t query = getQuery( i_frame, scope_id );
+
+    //regions open outside the render pass, where query resets are allowed
+    vkCmdResetQueryPool( i_cmd_buffer, m_query_pool, query, 2 );
+    vkCmdWriteTimestamp( i_cmd_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_query_pool, query );
+
+    return scope_id;
+}
+
+
+void ProfilerVK::endRegion( VkCommandBuffer i_cmd_buffer, const Frame& i_frame, const uint32_t i_scope_id )
+{
+    if( i_scope_id != UINT32_MAX )
+    {
+        vkCmdWriteTimestamp( i_cmd_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool, getQuery( i_frame, i_scope_id ) + 1 );
+    }
+
+    UtilsVK::endRegion( i_cmd_buffer );
+}
+
+
+void ProfilerVK::submitRegion( const Frame& i_frame, const uint32_t i_scope_id )
+{
+    if( i_scope_id == UINT32_MAX )
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    std::vector<uint32_t>& scopes = m_frames[ i_frame.m_frame_index ].m_scopes;
+    if( std::find( scopes.begin(), scopes.end(), i_scope_id ) == scopes.end() )
+    {
+        scopes.push_back( i_scope_id );
+    }
+}
+
+
+void ProfilerVK::addCpuScope( const char* i_name, const double i_start_us, const double i_end_us )
+{
+    const uint32_t thread = getTraceThread();
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_cpu_averages[ i_name ].add( static_cast<float>( ( i_end_us - i_start_us ) / 1000.0 ) );
+    addTraceEvent( i_name, "cpu", i_start_us, i_end_us - i_start_us, thread );
+}
+
+
+void ProfilerVK::enableTrace( const bool i_enable )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_trace_enabled = i_enable;
+}
+
+
+bool ProfilerVK::writeChromeTrace( const std::string& i_path ) const
+{
+    std::ofstream file( i_path );
+
+    if( !file.is_open() )
+    {
+        std::cerr << "Cannot open trace file " << i_path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << tfm::format( "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", kGPU_TRACE_THREAD );
+
+    for( const auto& event : m_trace )
+    {
+        file << tfm::format( ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%d}",
+                             escapeJson( event.m_name ), event.m_category, event.m_start_us, event.m_duration_us, event.m_thread );
+    }
+
+    file << "\n]}\n";
+
+    return true;
+}
+
+
+float ProfilerVK::getGpuAverage( const std::string& i_name ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    auto it = m_gpu_averages.find( i_name );
+    return it != m_gpu_averages.end() ? it->second.average() : 0.0f;
+}
+
+
+float ProfilerVK::getCpuAverage( const std::string& i_name ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    auto it = m_cpu_averages.find( i_name );
+    return it != m_cpu_averages.end() ? it->second.average() : 0.0f;
+}
+
+
+void ProfilerVK::printAverages( std::ostream& o_stream ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    o_stream << tfm::format( "Average timings over the last %d samples\n", kPROFILER_AVERAGE_WINDOW );
+
+    for( const auto& average : m_gpu_averages )
+    {
+        o_stream << tfm::format( "  GPU %-32s %8.3f ms\n", average.first, average.second.average() );
+    }
+
+    for( const auto& average : m_cpu_averages )
+    {
+        o_stream << tfm::format( "  CPU %-32s %8.3f ms\n", average.first, average.second.average() );
+    }
+}
+
+
+double ProfilerVK::now() const
+{
+    return std::chrono::duration<double, std::micro>( std::chrono::high_resolution_clock::now() - m_origin ).count();
+}
+
+
+uint32_t ProfilerVK::getQuery( const Frame& i_frame, const uint32_t i_scope_id ) const
+{
+    return ( i_frame.m_frame_index * kPROFILER_MAX_GPU_SCOPES + i_scope_id ) * 2;
+}
+
+
+uint64_t ProfilerVK::getTimestampMask( const uint32_t i_queue_family ) const
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    //the compute family is the graphics one on devices without async compute
+    return i_queue_family == UINT32_MAX || i_queue_family == device.getGraphicsQueueFamilyIndex() ? m_graphics_mask : m_compute_mask;
+}
+
+
+void ProfilerVK::addTraceEvent( const std::string& i_name, const char* i_category, const double i_start_us, const double i_duration_us, const uint32_t i_thread )
+{
+    if( !m_trace_enabled || m_trace.size() >= kPROFILER_MAX_TRACE_EVENTS )
+    {
+        return;
+    }
+
+    m_trace.push_back( { i_name, i_category, i_start_us, i_duration_us, i_thread } );
+}
+
+
+void ProfilerVK::RollingAverage::add( const float i_sample )
+{
+    if( m_count == kPROFILER_AVERAGE_WINDOW )
+    {
+        m_sum -= m_samples[ m_next ];
+    }
+    else
+    {
+        m_count++;
+    }
+
+    m_samples[ m_next ] = i_sample;
+    m_sum              += i_sample;
+    m_next              = ( m_next + 1 ) % kPROFILER_AVERAGE_WINDOW;
+}
+
+
+float ProfilerVK::RollingAverage::average() const
+{
+    return m_count > 0 ? m_sum / static_cast<float>( m_count ) : 0.0f;
+}
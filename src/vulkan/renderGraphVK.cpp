@@ -0,0 +1,935 @@
+#include "vulkan/renderGraphVK.h"
+#include "vulkan/renderPassVK.h"
+#include "vulkan/rendererVK.h"
+#include "vulkan/deviceVK.h"
+#include "vulkan/windowVK.h"
+#include "vulkan/utilsVK.h"
+#include "vulkan/commandPoolsVK.h"
+#include "vulkan/memoryAllocatorVK.h"
+#include "runtime.h"
+#include "frame.h"
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    struct AccessInfo
+    {
+        VkImageLayout        m_layout;
+        VkPipelineStageFlags m_stages;
+        VkAccessFlags        m_access;
+        bool                 m_read;  //needs the previous contents
+        bool                 m_write;
+    };
+
+    AccessInfo getAccessInfo( const RenderGraphVK::Access i_access )
+    {
+        const VkPipelineStageFlags fragment_tests = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        const VkAccessFlags        depth_access   = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        switch( i_access )
+        {
+        case RenderGraphVK::Access::ColorWrite:
+            return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, false, true };
+        case RenderGraphVK::Access::DepthWrite:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, fragment_tests, depth_access, false, true };
+        case RenderGraphVK::Access::DepthReadWrite:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, fragment_tests, depth_access, true, true };
+        case RenderGraphVK::Access::Sampled:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, true, false };
+        case RenderGraphVK::Access::ComputeSampled:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, true, false };
+        case RenderGraphVK::Access::StorageWrite:
+            return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, false, true };
+        case RenderGraphVK::Access::External:
+        default:
+            return { VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, false, true };
+        }
+    }
+
+    //pure writers go first, then read-modify-write, then readers
+    uint32_t getAccessRank( const RenderGraphVK::Access i_access )
+    {
+        const AccessInfo info = getAccessInfo( i_access );
+        return info.m_write ? ( info.m_read ? 1 : 0 ) : 2;
+    }
+
+    bool isDepthFormat( const VkFormat i_format )
+    {
+        return i_format == VK_FORMAT_D16_UNORM || i_format == VK_FORMAT_D32_SFLOAT || i_format == VK_FORMAT_D16_UNORM_S8_UINT ||
+               i_format == VK_FORMAT_D24_UNORM_S8_UINT || i_format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+    bool hasStencil( const VkFormat i_format )
+    {
+        return i_format == VK_FORMAT_D16_UNORM_S8_UINT || i_format == VK_FORMAT_D24_UNORM_S8_UINT || i_format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+
+    //queue bits of the image states
+    constexpr uint32_t kGRAPHICS_QUEUE = 1;
+    constexpr uint32_t kASYNC_QUEUE    = 2;
+}
+
+
+RenderGraphVK::RenderGraphVK( const Runtime& i_runtime ) :
+    m_runtime         ( i_runtime ),
+    m_async           ( false ),
+    m_allocated_memory( 0 ),
+    m_required_memory ( 0 )
+{
+}
+
+
+const ImageBlock& RenderGraphVK::addImage( const std::string& i_name, const ImageDesc& i_desc )
+{
+    if( m_resource_ids.count( i_name ) )
+    {
+        throw MiniEngineException( "Render graph image %s declared twice", i_name.c_str() );
+    }
+
+    Resource resource;
+    resource.m_name              = i_name;
+    resource.m_desc              = i_desc;
+    resource.m_image             = std::make_unique<ImageBlock>();
+    resource.m_image->m_format   = i_desc.m_format;
+    resource.m_image->m_type     = i_desc.m_layers > 1 ? IMAGE_BLOCK_2D_ARRAY : IMAGE_BLOCK_2D;
+    resource.m_image->m_sampler  = i_desc.m_sampler;
+
+    m_resource_ids[ i_name ] = static_cast<uint32_t>( m_resources.size() );
+    m_resources.push_back( std::move( resource ) );
+
+    return *m_resources.back().m_image;
+}
+
+
+void RenderGraphVK::addExternal( const std::string& i_name )
+{
+    if( m_resource_ids.count( i_name ) )
+    {
+        throw MiniEngineException( "Render graph image %s declared twice", i_name.c_str() );
+    }
+
+    Resource resource;
+    resource.m_name     = i_name;
+    resource.m_external = true;
+
+    m_resource_ids[ i_name ] = static_cast<uint32_t>( m_resources.size() );
+    m_resources.push_back( std::move( resource ) );
+}
+
+
+void RenderGraphVK::addPass( const std::string& i_name, const std::shared_ptr<RenderPassVK>& i_pass, const std::vector<ResourceAccess>& i_accesses )
+{
+    Pass pass;
+    pass.m_name = i_name;
+    pass.m_pass = i_pass;
+
+    for( const auto& access : i_accesses )
+    {
+        const uint32_t resource = getResource( access.m_name );
+
+        if( ( access.m_access == Access::External ) != m_resources[ resource ].m_external )
+        {
+            throw MiniEngineException( "Pass %s uses %s with the wrong kind of access", i_name.c_str(), access.m_name.c_str() );
+        }
+
+        pass.m_accesses.push_back( { resource, access.m_access } );
+    }
+
+    m_declared_passes.push_back( std::move( pass ) );
+}
+
+
+void RenderGraphVK::setOutput( const std::string& i_name )
+{
+    m_outputs.push_back( getResource( i_name ) );
+}
+
+
+uint32_t RenderGraphVK::getResource( const std::string& i_name ) const
+{
+    auto it = m_resource_ids.find( i_name );
+    if( it == m_resource_ids.end() )
+    {
+        throw MiniEngineException( "Unknown render graph image %s", i_name.c_str() );
+    }
+
+    return it->second;
+}
+
+
+void RenderGraphVK::compile()
+{
+    sortPasses    ();
+    cullPasses    ();
+    assignQueues  ();
+    createImages  ();
+    recordBarriers();
+    createSubmits ();
+}
+
+
+void RenderGraphVK::resize()
+{
+    //order and aliasing do not depend on the size, only the images and the barriers naming them change
+    destroyImages ();
+    createImages  ();
+    recordBarriers();
+}
+
+
+void RenderGraphVK::shutdown()
+{
+    destroyImages ();
+    destroySubmits();
+
+    if( m_command_pools )
+    {
+        m_command_pools->shutdown();
+        m_command_pools = nullptr;
+    }
+
+    if( m_compute_command_pools )
+    {
+        m_compute_command_pools->shutdown();
+        m_compute_command_pools = nullptr;
+    }
+
+    m_barriers.clear();
+    m_passes  .clear();
+    m_order   .clear();
+}
+
+
+void RenderGraphVK::sortPasses()
+{
+    const size_t pass_count = m_declared_passes.size();
+
+    //for every image: writers before read-modify-writes before readers, declaration order between writers
+    std::vector<std::vector<uint32_t>> edges( pass_count );
+    std::vector<uint32_t>              incoming( pass_count, 0 );
+
+    auto add_edge = [ & ]( const uint32_t i_from, const uint32_t i_to )
+    {
+        if( i_from != i_to && std::find( edges[ i_from ].begin(), edges[ i_from ].end(), i_to ) == edges[ i_from ].end() )
+        {
+            edges[ i_from ].push_back( i_to );
+            incoming[ i_to ]++;
+        }
+    };
+
+    for( uint32_t a = 0; a < pass_count; a++ )
+    {
+        for( uint32_t b = a + 1; b < pass_count; b++ )
+        {
+            for( const auto& access_a : m_declared_passes[ a ].m_accesses )
+            {
+                for( const auto& access_b : m_declared_passes[ b ].m_accesses )
+                {
+                    if( access_a.m_resource != access_b.m_resource )
+                    {
+                        continue;
+                    }
+
+                    const uint32_t rank_a = getAccessRank( access_a.m_access );
+                    const uint32_t rank_b = getAccessRank( access_b.m_access );
+
+                    if( rank_a < rank_b || ( rank_a == rank_b && rank_a < 2 ) )
+                    {
+                        add_edge( a, b );
+                    }
+                    else if( rank_b < rank_a )
+                    {
+                        add_edge( b, a );
+                    }
+                }
+            }
+        }
+    }
+
+    //kahn, picking the first declared pass among the ready ones so independent passes keep their order
+    m_order.clear();
+    std::vector<bool> done( pass_count, false );
+
+    while( m_order.size() < pass_count )
+    {
+        uint32_t next = UINT32_MAX;
+        for( uint32_t idx = 0; idx < pass_count; idx++ )
+        {
+            if( !done[ idx ] && incoming[ idx ] == 0 )
+            {
+                next = idx;
+                break;
+            }
+        }
+
+        if( next == UINT32_MAX )
+        {
+            throw MiniEngineException( "The render graph has a cycle" );
+        }
+
+        done[ next ] = true;
+        m_order.push_back( next );
+
+        for( uint32_t to : edges[ next ] )
+        {
+            incoming[ to ]--;
+        }
+    }
+}
+
+
+void RenderGraphVK::cullPasses()
+{
+    std::vector<bool> needed( m_resources.size(), false );
+    for( uint32_t output : m_outputs )
+    {
+        needed[ output ] = true;
+    }
+
+    //walk backwards, a pass lives if it writes something a live pass or the output needs
+    std::vector<uint32_t> alive;
+    for( auto it = m_order.rbegin(); it != m_order.rend(); ++it )
+    {
+        const Pass& pass = m_declared_passes[ *it ];
+
+        bool writes_needed = false;
+        for( const auto& access : pass.m_accesses )
+        {
+            writes_needed |= getAccessInfo( access.m_access ).m_write && needed[ access.m_resource ];
+        }
+
+        if( !writes_needed )
+        {
+            continue;
+        }
+
+        for( const auto& access : pass.m_accesses )
+        {
+            if( getAccessInfo( access.m_access ).m_read )
+            {
+                needed[ access.m_resource ] = true;
+            }
+        }
+
+        alive.push_back( *it );
+    }
+
+    m_order.assign( alive.rbegin(), alive.rend() );
+
+    m_passes.clear();
+    for( uint32_t pass_idx : m_order )
+    {
+        m_passes.push_back( m_declared_passes[ pass_idx ].m_pass );
+    }
+
+    //lifetimes over the passes that run
+    for( auto& resource : m_resources )
+    {
+        resource.m_first   = UINT32_MAX;
+        resource.m_last    = 0;
+        resource.m_sampled = false;
+        resource.m_storage = false;
+    }
+
+    for( uint32_t position = 0; position < static_cast<uint32_t>( m_order.size() ); position++ )
+    {
+        for( const auto& access : m_declared_passes[ m_order[ position ] ].m_accesses )
+        {
+            Resource& resource = m_resources[ access.m_resource ];
+
+            if( resource.m_first == UINT32_MAX )
+            {
+                //the contents of a transient image do not survive the frame, so it has to start with a clear
+                if( !resource.m_external && getAccessInfo( access.m_access ).m_read )
+                {
+                    throw MiniEngineException( "Render graph image %s is read before any pass writes it", resource.m_name.c_str() );
+                }
+                resource.m_first = position;
+            }
+
+            resource.m_last     = position;
+            resource.m_sampled |= access.m_access == Access::Sampled || access.m_access == Access::ComputeSampled;
+            resource.m_storage |= access.m_access == Access::StorageWrite;
+        }
+    }
+}
+
+
+void RenderGraphVK::assignQueues()
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    //compute passes ahead of every graphics pass stay on the graphics queue, so every async submit has
+    //a graphics submit of the same frame to wait on
+    bool graphics_before = false;
+    m_async = false;
+
+    for( auto& resource : m_resources )
+    {
+        resource.m_async = false;
+    }
+
+    for( uint32_t pass_idx : m_order )
+    {
+        Pass& pass = m_declared_passes[ pass_idx ];
+
+        pass.m_async     = device.hasAsyncComputeQueue() && pass.m_pass->isCompute() && graphics_before;
+        graphics_before |= !pass.m_async;
+        m_async         |= pass.m_async;
+
+        pass.m_pass->setQueueFamilyIndex( pass.m_async ? device.getComputeQueueFamilyIndex() : device.getGraphicsQueueFamilyIndex() );
+
+        for( const auto& access : pass.m_accesses )
+        {
+            m_resources[ access.m_resource ].m_async |= pass.m_async;
+        }
+    }
+}
+
+
+void RenderGraphVK::createImages()
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    //images shared by both queues skip the ownership transfers, the driver may then keep them uncompressed
+    const std::array<uint32_t, 2> queue_families = { device.getGraphicsQueueFamilyIndex(), device.getComputeQueueFamilyIndex() };
+
+    uint32_t window_width = 0, window_height = 0;
+    m_runtime.m_renderer->getWindow().getWindowSize( window_width, window_height );
+
+    std::vector<uint32_t> used;
+
+    for( uint32_t idx = 0; idx < static_cast<uint32_t>( m_resources.size() ); idx++ )
+    {
+        Resource& resource = m_resources[ idx ];
+
+        if( resource.m_external || resource.m_first == UINT32_MAX )
+        {
+            continue;
+        }
+
+        VkImageCreateInfo image{};
+        image.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image.imageType     = VK_IMAGE_TYPE_2D;
+        image.format        = resource.m_desc.m_format;
+        image.extent.width  = resource.m_desc.m_width  ? resource.m_desc.m_width  : window_width;
+        image.extent.height = resource.m_desc.m_height ? resource.m_desc.m_height : window_height;
+        image.extent.depth  = 1;
+        image.mipLevels     = 1;
+        image.arrayLayers   = resource.m_desc.m_layers;
+        image.samples       = VK_SAMPLE_COUNT_1_BIT;
+        image.tiling        = VK_IMAGE_TILING_OPTIMAL;
+        image.usage         = resource.m_desc.m_usage | VK_IMAGE_USAGE_SAMPLED_BIT | ( resource.m_storage ? VK_IMAGE_USAGE_STORAGE_BIT : 0 );
+        image.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if( m_async )
+        {
+            image.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+            image.queueFamilyIndexCount = static_cast<uint32_t>( queue_families.size() );
+            image.pQueueFamilyIndices   = queue_families.data();
+        }
+
+        if( VK_SUCCESS != vkCreateImage( device.getLogicalDevice(), &image, nullptr, &resource.m_image->m_image ) )
+        {
+            throw MiniEngineException( "Issue creating render graph image %s", resource.m_name.c_str() );
+        }
+
+        vkGetImageMemoryRequirements( device.getLogicalDevice(), resource.m_image->m_image, &resource.m_requirements );
+        used.push_back( idx );
+    }
+
+    //greedy interval packing: an image moves into the block whose last tenant is done before it starts
+    //and whose size grows the least. the blocks hold one image at a time, so every tenant binds at the start of the block
+    std::stable_sort( used.begin(), used.end(), [ this ]( uint32_t a, uint32_t b ) { return m_resources[ a ].m_first < m_resources[ b ].m_first; } );
+
+    m_blocks.clear();
+    m_required_memory = 0;
+
+    for( uint32_t idx : used )
+    {
+        Resource& resource = m_resources[ idx ];
+        m_required_memory += resource.m_requirements.size;
+
+        uint32_t     best      = UINT32_MAX;
+        VkDeviceSize best_grow = 0;
+
+        for( uint32_t block_idx = 0; block_idx < static_cast<uint32_t>( m_blocks.size() ); block_idx++ )
+        {
+            const MemoryBlock& block = m_blocks[ block_idx ];
+
+            //positions do not order the two queues, so images of async passes keep their memory to themselves
+            if( resource.m_async || m_resources[ block.m_resources.back() ].m_async ||
+                m_resources[ block.m_resources.back() ].m_last >= resource.m_first || ( block.m_type_bits & resource.m_requirements.memoryTypeBits ) == 0 )
+            {
+                continue;
+            }
+
+            const VkDeviceSize grow = resource.m_requirements.size > block.m_size ? resource.m_requirements.size - block.m_size : 0;
+            if( best == UINT32_MAX || grow < best_grow )
+            {
+                best      = block_idx;
+                best_grow = grow;
+            }
+        }
+
+        if( best == UINT32_MAX )
+        {
+            best = static_cast<uint32_t>( m_blocks.size() );
+            m_blocks.emplace_back();
+        }
+
+        MemoryBlock& block = m_blocks[ best ];
+        block.m_size       = std::max( block.m_size, resource.m_requirements.size );
+        block.m_alignment  = std::max( block.m_alignment, resource.m_requirements.alignment );
+        block.m_type_bits &= resource.m_requirements.memoryTypeBits;
+        block.m_resources.push_back( idx );
+        resource.m_block   = best;
+    }
+
+    m_allocated_memory = 0;
+
+    for( auto& block : m_blocks )
+    {
+        //the aliased range is a single allocation as far as the allocator is concerned
+        VkMemoryRequirements requirements{};
+        requirements.size           = block.m_size;
+        requirements.alignment      = block.m_alignment;
+        requirements.memoryTypeBits = block.m_type_bits;
+
+        block.m_memory = device.getAllocator().allocate( requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false );
+
+        m_allocated_memory += block.m_size;
+
+        for( uint32_t idx : block.m_resources )
+        {
+            Resource&   resource = m_resources[ idx ];
+            ImageBlock& image    = *resource.m_image;
+
+            if( VK_SUCCESS != vkBindImageMemory( device.getLogicalDevice(), image.m_image, block.m_memory.m_memory, block.m_memory.m_offset ) )
+            {
+                throw MiniEngineException( "Issue binding render graph image %s", resource.m_name.c_str() );
+            }
+
+            //sampling a depth image reads a single aspect
+            VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT;
+            if( isDepthFormat( image.m_format ) )
+            {
+                aspect_mask = VK_IMAGE_ASPECT_DEPTH_BIT;
+                if( hasStencil( image.m_format ) && !resource.m_sampled )
+                {
+                    aspect_mask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+                }
+            }
+
+            VkImageViewCreateInfo image_view{};
+            image_view.sType                            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            image_view.viewType                         = image.m_type == IMAGE_BLOCK_2D_ARRAY ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+            image_view.format                           = image.m_format;
+            image_view.subresourceRange.aspectMask      = aspect_mask;
+            image_view.subresourceRange.baseMipLevel    = 0;
+            image_view.subresourceRange.levelCount      = 1;
+            image_view.subresourceRange.baseArrayLayer  = 0;
+            image_view.subresourceRange.layerCount      = resource.m_desc.m_layers;
+            image_view.image                            = image.m_image;
+
+            if( VK_SUCCESS != vkCreateImageView( device.getLogicalDevice(), &image_view, nullptr, &image.m_image_view ) )
+            {
+                throw MiniEngineException( "Issue creating render graph image %s", resource.m_name.c_str() );
+            }
+
+            UtilsVK::setObjectName( device.getLogicalDevice(), (uint64_t)image.m_image, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, resource.m_name.c_str() );
+        }
+    }
+}
+
+
+void RenderGraphVK::destroyImages()
+{
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    for( auto& resource : m_resources )
+    {
+        if( resource.m_external || resource.m_image->m_image == VK_NULL_HANDLE )
+        {
+            continue;
+        }
+
+        vkDestroyImageView( device.getLogicalDevice(), resource.m_image->m_image_view, nullptr );
+        vkDestroyImage    ( device.getLogicalDevice(), resource.m_image->m_image     , nullptr );
+
+        resource.m_image->m_image_view = VK_NULL_HANDLE;
+        resource.m_image->m_image      = VK_NULL_HANDLE;
+        resource.m_block               = UINT32_MAX;
+    }
+
+    for( auto& block : m_blocks )
+    {
+        device.getAllocator().free( block.m_memory );
+    }
+
+    m_blocks.clear();
+    m_allocated_memory = 0;
+    m_required_memory  = 0;
+}
+
+
+void RenderGraphVK::recordBarriers()
+{
+    struct ImageState
+    {
+        VkImageLayout        m_layout       = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags m_write_stages = 0;
+        VkAccessFlags        m_write_access = 0;
+        VkPipelineStageFlags m_read_stages  = 0; //since the last write
+        VkPipelineStageFlags m_visible      = 0; //stages the last write was made visible to
+        uint32_t             m_write_queue  = 0;
+        uint32_t             m_read_queues  = 0;
+    };
+
+    struct PassBarriers
+    {
+        std::vector<VkImageMemoryBarrier> m_barriers;
+        VkPipelineStageFlags              m_src_stages = 0;
+        VkPipelineStageFlags              m_dst_stages = 0;
+    };
+
+    std::vector<PassBarriers> pass_barriers( m_order.size() );
+
+    //the state an image is left in at the end of the frame, which the next frame starts from
+    auto get_final_state = [ this ]( const uint32_t i_resource )
+    {
+        ImageState state;
+        for( uint32_t pass_idx : m_order )
+        {
+            const uint32_t queue = m_declared_passes[ pass_idx ].m_async ? kASYNC_QUEUE : kGRAPHICS_QUEUE;
+
+            for( const auto& access : m_declared_passes[ pass_idx ].m_accesses )
+            {
+                if( access.m_resource != i_resource )
+                {
+                    continue;
+                }
+
+                const AccessInfo info = getAccessInfo( access.m_access );
+                state.m_layout = info.m_layout;
+                if( info.m_write )
+                {
+                    state.m_write_stages = info.m_stages;
+                    state.m_write_access = info.m_access;
+                    state.m_read_stages  = 0;
+                    state.m_write_queue  = queue;
+                    state.m_read_queues  = 0;
+                }
+                else
+                {
+                    state.m_read_stages |= info.m_stages;
+                    state.m_read_queues |= queue;
+                }
+            }
+        }
+        return state;
+    };
+
+    m_cross_queue.assign( m_order.size(), false );
+
+    for( uint32_t res_idx = 0; res_idx < static_cast<uint32_t>( m_resources.size() ); res_idx++ )
+    {
+        const Resource& resource = m_resources[ res_idx ];
+
+        if( resource.m_external || resource.m_block == UINT32_MAX )
+        {
+            continue;
+        }
+
+        //the first use waits on whoever used the memory last: the previous tenant of the block, or for the
+        //first tenant the last one of the previous frame, which may be the image itself
+        const std::vector<uint32_t>& tenants = m_blocks[ resource.m_block ].m_resources;
+        const size_t tenant_idx = std::find( tenants.begin(), tenants.end(), res_idx ) - tenants.begin();
+        const uint32_t previous = tenants[ ( tenant_idx + tenants.size() - 1 ) % tenants.size() ];
+
+        ImageState state = get_final_state( previous );
+        state.m_layout   = VK_IMAGE_LAYOUT_UNDEFINED; //the first access clears, the old contents can go
+
+        VkImageSubresourceRange range{};
+        range.aspectMask     = isDepthFormat( resource.m_desc.m_format ) ? VK_IMAGE_ASPECT_DEPTH_BIT | ( hasStencil( resource.m_desc.m_format ) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0 ) : VK_IMAGE_ASPECT_COLOR_BIT;
+        range.baseMipLevel   = 0;
+        range.levelCount     = 1;
+        range.baseArrayLayer = 0;
+        range.layerCount     = resource.m_desc.m_layers;
+
+        for( uint32_t position = 0; position < static_cast<uint32_t>( m_order.size() ); position++ )
+        {
+            const uint32_t queue = m_declared_passes[ m_order[ position ] ].m_async ? kASYNC_QUEUE : kGRAPHICS_QUEUE;
+
+            for( const auto& access : m_declared_passes[ m_order[ position ] ].m_accesses )
+            {
+                if( access.m_resource != res_idx )
+                {
+                    continue;
+                }
+
+                const AccessInfo info = getAccessInfo( access.m_access );
+                const bool transition = info.m_layout != state.m_layout;
+
+                //work of the other queue is ordered by the semaphore wait of the submit, which also makes
+                //its writes visible. the barrier then only has to start after that wait
+                const uint32_t waits_on    = info.m_write || transition ? state.m_write_queue | state.m_read_queues : state.m_write_queue;
+                const bool     cross_queue = ( waits_on & ~queue ) != 0;
+
+                if( cross_queue )
+                {
+                    m_cross_queue[ position ] = true;
+                }
+
+                //reads in the same layout only need the last write made visible to their stage
+                if( !transition && !info.m_write && ( state.m_write_stages == 0 || state.m_write_queue != queue || ( info.m_stages & ~state.m_visible ) == 0 ) )
+                {
+                    state.m_read_stages |= info.m_stages;
+                    state.m_read_queues |= queue;
+                    continue;
+                }
+
+                VkImageMemoryBarrier barrier{};
+                barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcAccessMask       = state.m_write_queue == queue ? state.m_write_access : 0;
+                barrier.dstAccessMask       = info.m_access;
+                barrier.oldLayout           = state.m_layout;
+                barrier.newLayout           = info.m_layout;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image               = resource.m_image->m_image;
+                barrier.subresourceRange    = range;
+
+                //a write has to wait for the reads before it as well
+                PassBarriers& barriers = pass_barriers[ position ];
+                barriers.m_barriers.push_back( barrier );
+                barriers.m_src_stages |= cross_queue ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : state.m_write_stages | ( info.m_write || transition ? state.m_read_stages : 0 );
+                barriers.m_dst_stages |= info.m_stages;
+
+                state.m_layout = info.m_layout;
+                if( info.m_write )
+                {
+                    state.m_write_stages = info.m_stages;
+                    state.m_write_access = info.m_access;
+                    state.m_read_stages  = 0;
+                    state.m_visible      = 0;
+                    state.m_write_queue  = queue;
+                    state.m_read_queues  = 0;
+                }
+                else
+                {
+                    state.m_read_stages |= info.m_stages;
+                    state.m_visible     |= info.m_stages;
+                    state.m_read_queues |= queue;
+                }
+            }
+        }
+    }
+
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    if( !m_command_pools )
+    {
+        m_command_pools = std::make_unique<CommandPoolsVK>( m_runtime, 1, 1, false, device.getGraphicsQueueFamilyIndex() );
+        m_command_pools->initialize();
+    }
+
+    //barriers of the async passes are submitted with them, on the compute queue
+    if( m_async && !m_compute_command_pools )
+    {
+        m_compute_command_pools = std::make_unique<CommandPoolsVK>( m_runtime, 1, 1, false, device.getComputeQueueFamilyIndex() );
+        m_compute_command_pools->initialize();
+    }
+
+    m_command_pools->reset( 0 );
+    if( m_compute_command_pools )
+    {
+        m_compute_command_pools->reset( 0 );
+    }
+    m_barriers.assign( m_order.size(), VK_NULL_HANDLE );
+
+    for( size_t position = 0; position < m_order.size(); position++ )
+    {
+        const PassBarriers& barriers = pass_barriers[ position ];
+
+        if( barriers.m_barriers.empty() )
+        {
+            continue;
+        }
+
+        VkCommandBuffer cmd = m_declared_passes[ m_order[ position ] ].m_async ? m_compute_command_pools->getCommandBuffer( 0 ) : m_command_pools->getCommandBuffer( 0 );
+
+        //the same barriers every frame, so one recording is pending in every frame in flight
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+
+        if( vkBeginCommandBuffer( cmd, &begin_info ) != VK_SUCCESS )
+        {
+            throw MiniEngineException( "failed to begin recording the render graph barriers!" );
+        }
+
+        vkCmdPipelineBarrier(
+            cmd,
+            barriers.m_src_stages ? barriers.m_src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            barriers.m_dst_stages,
+            0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>( barriers.m_barriers.size() ), barriers.m_barriers.data() );
+
+        if( vkEndCommandBuffer( cmd ) != VK_SUCCESS )
+        {
+            throw MiniEngineException( "failed to record the render graph barriers!" );
+        }
+
+        m_barriers[ position ] = cmd;
+    }
+}
+
+
+void RenderGraphVK::createSubmits()
+{
+    destroySubmits();
+
+    //latest submit of each queue so far, index 0 graphics and 1 async
+    std::array<uint32_t, 2> latest = { UINT32_MAX, UINT32_MAX };
+
+    for( uint32_t position = 0; position < static_cast<uint32_t>( m_order.size() ); position++ )
+    {
+        const bool     async        = m_declared_passes[ m_order[ position ] ].m_async;
+        const uint32_t latest_other = latest[ async ? 0 : 1 ];
+        const bool     needs_wait   = m_cross_queue[ position ] && latest_other != UINT32_MAX;
+
+        //a wait only delays the passes after it, so the submit is split where a pass has to wait
+        if( m_submits.empty() || m_submits.back().m_async != async || ( needs_wait && m_submits.back().m_wait != latest_other ) )
+        {
+            Submit submit;
+            submit.m_async = async;
+            submit.m_first = position;
+            submit.m_wait  = needs_wait ? latest_other : UINT32_MAX;
+
+            m_submits.push_back( submit );
+            latest[ async ? 1 : 0 ] = static_cast<uint32_t>( m_submits.size() - 1 );
+
+            if( needs_wait )
+            {
+                m_submits[ latest_other ].m_signal = true;
+            }
+        }
+
+        m_submits.back().m_count++;
+    }
+
+    //the swap chain semaphores and the frame fence go with the last submit, it has to cover the whole frame
+    assert( m_submits.empty() || !m_submits.back().m_async );
+
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+
+    VkSemaphoreCreateInfo semaphore_info{};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for( auto& semaphores : m_semaphores )
+    {
+        semaphores.assign( m_submits.size(), VK_NULL_HANDLE );
+
+        for( size_t submit_idx = 0; submit_idx < m_submits.size(); submit_idx++ )
+        {
+            if( !m_submits[ submit_idx ].m_signal )
+            {
+                continue;
+            }
+
+            if( vkCreateSemaphore( device.getLogicalDevice(), &semaphore_info, nullptr, &semaphores[ submit_idx ] ) != VK_SUCCESS )
+            {
+                throw MiniEngineException( "failed to create the render graph semaphores!" );
+            }
+        }
+    }
+}
+
+
+void RenderGraphVK::destroySubmits()
+{
+    for( auto& semaphores : m_semaphores )
+    {
+        for( VkSemaphore semaphore : semaphores )
+        {
+            if( semaphore != VK_NULL_HANDLE )
+            {
+                vkDestroySemaphore( m_runtime.m_renderer->getDevice()->getLogicalDevice(), semaphore, nullptr );
+            }
+        }
+        semaphores.clear();
+    }
+
+    m_submits.clear();
+}
+
+
+void RenderGraphVK::submit( const Frame& i_frame, const std::vector<VkCommandBuffer>& i_pass_cmds, VkSemaphore i_wait_semaphore, VkSemaphore i_signal_semaphore, VkFence i_fence ) const
+{
+    assert( i_pass_cmds.size() == m_order.size() );
+
+    const DeviceVK& device = *m_runtime.m_renderer->getDevice();
+    const auto& semaphores = m_semaphores[ i_frame.m_frame_index ];
+
+    std::vector<VkCommandBuffer> cmds;
+    cmds.reserve( i_pass_cmds.size() * 2 );
+
+    for( size_t submit_idx = 0; submit_idx < m_submits.size(); submit_idx++ )
+    {
+        const Submit& submit = m_submits[ submit_idx ];
+        const bool    last   = submit_idx + 1 == m_submits.size();
+
+        //the render graph barriers go right before the pass that needs them
+        cmds.clear();
+        for( uint32_t position = submit.m_first; position < submit.m_first + submit.m_count; position++ )
+        {
+            if( m_barriers[ position ] != VK_NULL_HANDLE )
+            {
+                cmds.push_back( m_barriers[ position ] );
+            }
+            cmds.push_back( i_pass_cmds[ position ] );
+        }
+
+        std::array<VkSemaphore, 2>          wait_semaphores;
+        std::array<VkPipelineStageFlags, 2> wait_stages;
+        uint32_t                            wait_count = 0;
+
+        if( submit.m_wait != UINT32_MAX )
+        {
+            wait_semaphores[ wait_count ] = semaphores[ submit.m_wait ];
+            wait_stages    [ wait_count ] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            wait_count++;
+        }
+
+        if( last && i_wait_semaphore != VK_NULL_HANDLE )
+        {
+            wait_semaphores[ wait_count ] = i_wait_semaphore;
+            wait_stages    [ wait_count ] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            wait_count++;
+        }
+
+        VkSemaphore signal_semaphore = last ? i_signal_semaphore : ( submit.m_signal ? semaphores[ submit_idx ] : VK_NULL_HANDLE );
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.waitSemaphoreCount   = wait_count;
+        submit_info.pWaitSemaphores      = wait_semaphores.data();
+        submit_info.pWaitDstStageMask    = wait_stages.data();
+        submit_info.commandBufferCount   = static_cast<uint32_t>( cmds.size() );
+        submit_info.pCommandBuffers      = cmds.data();
+        submit_info.signalSemaphoreCount = signal_semaphore != VK_NULL_HANDLE ? 1 : 0;
+        submit_info.pSignalSemaphores    = &signal_semaphore;
+
+        VkQueue queue = submit.m_async ? device.getComputeQueue() : device.getGraphicsQueue();
+
+        if( vkQueueSubmit( queue, 1, &submit_info, last ? i_fence : VK_NULL_HANDLE ) != VK_SUCCESS )
+        {
+            throw MiniEngineException( "Error submitting the render graph submit %d of frame slot %d", submit_idx, i_frame.m_frame_index );
+        }
+    }
+}
@@ -0,0 +1,225 @@
+#include "vulkan/renderPassVK.h"
+#include "vulkan/utilsVK.h"
+#include "vulkan/commandPoolsVK.h"
+#include "vulkan/profilerVK.h"
+#include "vulkan/rendererVK.h"
+#include "vulkan/deviceVK.h"
+#include "vulkan/meshletCullingVK.h"
+#include "vulkan/geometryArenaVK.h"
+#include "runtime.h"
+#include "frame.h"
+#include "entity.h"
+#include "threadPool.h"
+
+using namespace MiniEngine;
+
+
+RenderPassVK::RenderPassVK( const Runtime& i_runtime, const std::shared_ptr<RenderPassVK> i_prev_pass ) :
+    m_runtime           ( i_runtime       ),
+    m_prev_render_pass  ( i_prev_pass     ),
+    m_lod_view          ( LodView::Camera ),
+    m_meshlet_draws     ( false           ),
+    m_vertex_stream     ( VertexStream::Interleaved ),
+    m_queue_family_index( UINT32_MAX      )
+{
+}
+
+
+RenderPassVK::~RenderPassVK()
+{
+}
+
+
+void RenderPassVK::resize()
+{
+    invalidate();
+}
+
+
+void RenderPassVK::invalidate()
+{
+    for( auto& cached : m_cached_command_buffers )
+    {
+        cached.m_cmd_buffer = VK_NULL_HANDLE;
+    }
+}
+
+
+void RenderPassVK::setQueueFamilyIndex( const uint32_t i_queue_family_index )
+{
+    m_queue_family_index = i_queue_family_index;
+}
+
+
+void RenderPassVK::initializeCommandBuffers( const uint32_t i_key_count )
+{
+    const uint32_t queue_family_index = m_queue_family_index != UINT32_MAX ? m_queue_family_index : m_runtime.m_renderer->getDevice()->getGraphicsQueueFamilyIndex();
+
+    m_command_pools = std::make_unique<CommandPoolsVK>( m_runtime, m_runtime.m_thread_pool->getThreadCount(), i_key_count, false, queue_family_index );
+    m_command_pools->initialize();
+
+    m_cached_command_buffers.assign( i_key_count, {} );
+}
+
+
+void RenderPassVK::shutdownCommandBuffers()
+{
+    if( m_command_pools )
+    {
+        m_command_pools->shutdown();
+        m_command_pools = nullptr;
+    }
+
+    m_cached_command_buffers.clear();
+}
+
+
+VkCommandBuffer RenderPassVK::getCachedCommandBuffer( const Frame& i_frame, const uint32_t i_key )
+{
+    const CachedCommandBuffer& cached = m_cached_command_buffers[ i_key ];
+
+    if( cached.m_cmd_buffer != VK_NULL_HANDLE )
+    {
+        //the timestamps are written again by the replay, read them like a freshly recorded region
+        m_runtime.m_profiler->submitRegion( i_frame, cached.m_profiler_scope );
+    }
+
+    return cached.m_cmd_buffer;
+}
+
+
+VkCommandBuffer RenderPassVK::allocateCommandBuffer( const uint32_t i_key )
+{
+    //a key is only recorded by the frame slot that submitted it last, whose fence has been waited already
+    m_cached_command_buffers[ i_key ] = {};
+    m_command_pools->reset( i_key );
+
+    return m_command_pools->getCommandBuffer( i_key );
+}
+
+
+void RenderPassVK::cacheCommandBuffer( const uint32_t i_key, VkCommandBuffer i_cmd_buffer, const uint32_t i_profiler_scope )
+{
+    m_cached_command_buffers[ i_key ].m_cmd_buffer     = i_cmd_buffer;
+    m_cached_command_buffers[ i_key ].m_profiler_scope = i_profiler_scope;
+}
+
+
+void RenderPassVK::setViewportAndScissor( VkCommandBuffer i_cmd_buffer, const VkExtent2D& i_extent )
+{
+    VkViewport viewport{};
+    viewport.x        = 0.0f;
+    viewport.y        = 0.0f;
+    viewport.width    = static_cast<float>( i_extent.width  );
+    viewport.height   = static_cast<float>( i_extent.height );
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor{};
+    scissor.offset = { 0, 0 };
+    scissor.extent = i_extent;
+
+    vkCmdSetViewport( i_cmd_buffer, 0, 1, &viewport );
+    vkCmdSetScissor ( i_cmd_buffer, 0, 1, &scissor  );
+}
+
+
+bool RenderPassVK::useSecondaryCommandBuffers( const size_t i_entity_count ) const
+{
+    return m_runtime.m_thread_pool->getThreadCount() > 1 && i_entity_count > kENTITIES_PER_SECONDARY_BUFFER;
+}
+
+
+void RenderPassVK::drawEntities(
+    VkCommandBuffer                               i_cmd_buffer,
+    const Frame&                                  i_frame,
+    const uint32_t                                i_key,
+    const char*                                   i_region_name,
+    const std::vector<EntityPtr>&                 i_entities,
+    const VkCommandBufferInheritanceInfo*         i_inheritance,
+    const std::function<void( VkCommandBuffer )>& i_bind_state ) const
+{
+    if( i_inheritance == nullptr )
+    {
+        UtilsVK::beginRegion( i_cmd_buffer, i_region_name, Vector4f( 0.0f, 0.5f, 0.5f, 1.0f ) );
+
+        i_bind_state( i_cmd_buffer );
+
+        //entities of one bucket mostly share the arena blocks, they are bound once
+        GeometryBinding binding;
+        for( auto entity : i_entities )
+        {
+            drawEntity( i_cmd_buffer, i_frame, *entity, binding );
+        }
+
+        UtilsVK::endRegion( i_cmd_buffer );
+        return;
+    }
+
+    if( i_entities.empty() )
+    {
+        return;
+    }
+
+    const size_t chunk_count = ( i_entities.size() + kENTITIES_PER_SECONDARY_BUFFER - 1 ) / kENTITIES_PER_SECONDARY_BUFFER;
+
+    std::vector<VkCommandBuffer>  secondaries( chunk_count, VK_NULL_HANDLE );
+    std::vector<ThreadPool::Job>  jobs;
+    jobs.reserve( chunk_count );
+
+    for( size_t chunk = 0; chunk < chunk_count; chunk++ )
+    {
+        jobs.push_back( [ &, chunk ]()
+        {
+            //allocated on the thread that records it, each thread owns its pool
+            VkCommandBuffer cmd = m_command_pools->getCommandBuffer( i_key, VK_COMMAND_BUFFER_LEVEL_SECONDARY );
+
+            //kept alive with the primary that executes it, so no one time submit
+            VkCommandBufferBeginInfo begin_info{};
+            begin_info.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            begin_info.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            begin_info.pInheritanceInfo = i_inheritance;
+
+            if( vkBeginCommandBuffer( cmd, &begin_info ) != VK_SUCCESS )
+            {
+                throw MiniEngineException( "failed to begin recording secondary command buffer!" );
+            }
+
+            UtilsVK::beginRegion( cmd, i_region_name, Vector4f( 0.0f, 0.5f, 0.5f, 1.0f ) );
+
+            i_bind_state( cmd );
+
+            GeometryBinding binding;
+            const size_t end = std::min( ( chunk + 1 ) * kENTITIES_PER_SECONDARY_BUFFER, i_entities.size() );
+            for( size_t idx = chunk * kENTITIES_PER_SECONDARY_BUFFER; idx < end; idx++ )
+            {
+                drawEntity( cmd, i_frame, *i_entities[ idx ], binding );
+            }
+
+            UtilsVK::endRegion( cmd );
+
+            if( vkEndCommandBuffer( cmd ) != VK_SUCCESS )
+            {
+                throw MiniEngineException( "failed to record secondary command buffer!" );
+            }
+
+            secondaries[ chunk ] = cmd;
+        } );
+    }
+
+    m_runtime.m_thread_pool->run( jobs );
+
+    vkCmdExecuteCommands( i_cmd_buffer, static_cast<uint32_t>( secondaries.size() ), secondaries.data() );
+}
+
+
+void RenderPassVK::drawEntity( VkCommandBuffer i_cmd_buffer, const Frame& i_frame, Entity& i_entity, GeometryBinding& io_binding ) const
+{
+    //the meshlets only cover lod 0
+    if( m_meshlet_draws && i_entity.getLod( m_lod_view ) == 0 && m_runtime.m_meshlet_culling->drawEntity( i_cmd_buffer, i_frame, i_entity, m_vertex_stream, &io_binding ) )
+    {
+        return;
+    }
+
+    i_entity.draw( i_cmd_buffer, i_frame, m_lod_view, m_vertex_stream, &io_binding );
+}
@@ -73,10 +73,10 @@ VKAPI_ATTR VkBool32 VKAPI_CALL debugUtilsMessengerCallback(
 
 
 
-bool RendererVK::initialize()
+bool RendererVK::initialize( const bool i_headless )
 {
-    //we create the glfw window
-    m_window = std::make_unique<WindowVK>( *this, "Mini Engine", 800, 800  );
+    //we create the glfw window, or only the offscreen output when running headless
+    m_window = std::make_unique<WindowVK>( *this, "Mini Engine", 800, 800, i_headless );
     m_device = std::make_shared<DeviceVK>( *this );
 
     //get the vulkan instance
@@ -122,8 +122,16 @@ void RendererVK::createInstance()
     app_info.apiVersion         = VK_MAKE_VERSION( 1, 2, 0 );
 
     std::vector<const char*> extensions;
-    extensions.push_back            ( VK_KHR_SURFACE_EXTENSION_NAME       );
-    extensions.push_back            ( VK_KHR_WIN32_SURFACE_EXTENSION_NAME );
+    if( !m_window->isHeadless() )
+    {
+        extensions.push_back        ( VK_KHR_SURFACE_EXTENSION_NAME       );
+        extensions.push_back        ( VK_KHR_WIN32_SURFACE_EXTENSION_NAME );
+    }
+
+    if( enable_validation_layers )
+    {
+        extensions.push_back        ( VK_EXT_DEBUG_UTILS_EXTENSION_NAME   );
+    }
 
     // Get extensions supported by the instance and store for later use
     uint32_t count = 0;
@@ -150,10 +158,6 @@ void RendererVK::createInstance()
 
     if( extensions.size() > 0 )
     {
-        if( enable_validation_layers )
-        {
-            extensions.push_back            ( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
-        }
         instance_create_info.enabledExtensionCount   = ( uint32_t )extensions.size();
         instance_create_info.ppEnabledExtensionNames = extensions.data();
     }
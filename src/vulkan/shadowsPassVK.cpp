@@ -9,7 +9,11 @@
 #include "shaderRegistry.h"
 #include "entity.h"
 #include "vulkan/meshVK.h"
+#include "vulkan/profilerVK.h"
+#include "vulkan/commandPoolsVK.h"
 #include "material.h"
+#include "vertexLayout.h"
+#include "meshRegistry.h"
 
 using namespace MiniEngine;
 
@@ -19,10 +23,8 @@ ShadowPassVK::ShadowPassVK(
     RenderPassVK(i_runtime),
     m_shadow_output(i_shadow_output)
 {
-    for (auto cmd : m_command_buffer)
-    {
-        cmd = VK_NULL_HANDLE;
-    }
+    //the geometry shader draws every light layer from one draw, the level is picked for the closest light
+    m_lod_view = LodView::Shadow;
 }
 
 ShadowPassVK::~ShadowPassVK()
@@ -33,14 +35,21 @@ bool ShadowPassVK::initialize()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
-    m_entities_to_draw = {
-                            { static_cast<uint32_t>(Material::TMaterial::Diffuse), {} },
-                            { static_cast<uint32_t>(Material::TMaterial::Microfacets), {} }
-    };
+    //only the positions are read, from their own stream when the meshes keep one
+    m_vertex_stream = m_runtime.m_mesh_registry->hasPositionStreams() ? VertexStream::Position : VertexStream::Interleaved;
+
+    //one list per material and vertex format, each drawn with its own pipeline
+    for (uint32_t mat_id = 0; mat_id < static_cast<uint32_t>(m_pipelines.size()); mat_id++)
+    {
+        for (uint32_t format = 0; format < kVERTEX_FORMAT_COUNT; format++)
+        {
+            m_entities_to_draw[mat_id * kVERTEX_FORMAT_COUNT + format] = {};
+        }
+    }
 
     //SHADER STAGES
     {
-        VkShaderModule vert_module = m_runtime.m_shader_registry->loadShader("./shaders/vert.spv", VK_SHADER_STAGE_VERTEX_BIT);
+        VkShaderModule vert_module = m_runtime.m_shader_registry->loadShader("./shaders/depth_v.spv", VK_SHADER_STAGE_VERTEX_BIT);
         VkShaderModule geom_module = m_runtime.m_shader_registry->loadShader("./shaders/shadows.spv", VK_SHADER_STAGE_GEOMETRY_BIT);
 
         { // difuse
@@ -82,14 +91,7 @@ bool ShadowPassVK::initialize()
     createPipelines();
     createFbo();
 
-    VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
-
-    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    commandBufferAllocateInfo.commandPool = renderer.getDevice()->getCommandPool();
-    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    commandBufferAllocateInfo.commandBufferCount = 3;
-
-    vkAllocateCommandBuffers(renderer.getDevice()->getLogicalDevice(), &commandBufferAllocateInfo, m_command_buffer.data());
+    initializeCommandBuffers(kMAX_NUMBER_OF_FRAMES);
 
         return true;
 }
@@ -98,7 +100,7 @@ void ShadowPassVK::shutdown()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
-    vkFreeCommandBuffers(renderer.getDevice()->getLogicalDevice(), renderer.getDevice()->getCommandPool(), m_command_buffer.size(), m_command_buffer.data());
+    shutdownCommandBuffers();
 
     vkDestroyDescriptorPool(renderer.getDevice()->getLogicalDevice(), m_descriptor_pool, nullptr);
 
@@ -106,12 +108,15 @@ void ShadowPassVK::shutdown()
     {
         vkDestroyDescriptorSetLayout(renderer.getDevice()->getLogicalDevice(), pipeline.m_descriptor_set_layout[0], nullptr);
         vkDestroyDescriptorSetLayout(renderer.getDevice()->getLogicalDevice(), pipeline.m_descriptor_set_layout[1], nullptr);
-        vkDestroyPipeline(renderer.getDevice()->getLogicalDevice(), pipeline.m_pipeline, nullptr);
+        for (VkPipeline format_pipeline : pipeline.m_pipeline)
+        {
+            vkDestroyPipeline(renderer.getDevice()->getLogicalDevice(), format_pipeline, nullptr);
+        }
         vkDestroyPipelineLayout(renderer.getDevice()->getLogicalDevice(), pipeline.m_pipeline_layouts, nullptr);
     }
 
 
-    for (uint32 id = 0; id < static_cast<uint32>(renderer.getWindow().getImageCount()); id++)
+    for (uint32 id = 0; id < static_cast<uint32>(m_fbos.size()); id++)
     {
         vkDestroyFramebuffer(renderer.getDevice()->getLogicalDevice(), m_fbos[id], nullptr);
     }
@@ -124,28 +129,29 @@ void ShadowPassVK::shutdown()
 
 VkCommandBuffer ShadowPassVK::draw(const Frame& i_frame)
 {
-    RendererVK& renderer = *m_runtime.m_renderer;
-
-    VkCommandBuffer& current_cmd = m_command_buffer[renderer.getWindow().getCurrentImageId()];
+    //same draw list as the depth pass, replayed until an entity is added
+    const uint32_t key = i_frame.m_frame_index;
 
+    VkCommandBuffer current_cmd = getCachedCommandBuffer(i_frame, key);
     if (current_cmd != VK_NULL_HANDLE)
     {
-        VkCommandBufferResetFlags flags{};
-        vkResetCommandBuffer(current_cmd, flags);
+        return current_cmd;
     }
 
+    current_cmd = allocateCommandBuffer(key);
+
     VkCommandBufferBeginInfo begin_info{};
     begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-    uint32_t width, height;
-    renderer.getWindow().getWindowSize(width, height);
+    //the shadow map keeps its size whatever the window does
+    const VkExtent2D extent{ SHADOW_MAP_SIZE, SHADOW_MAP_SIZE };
 
     VkRenderPassBeginInfo render_pass_info{};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     render_pass_info.renderPass = m_render_pass;
-    render_pass_info.framebuffer = m_fbos[renderer.getWindow().getCurrentImageId()];
+    render_pass_info.framebuffer = m_fbos[i_frame.m_frame_index];
     render_pass_info.renderArea.offset = { 0, 0 };
-    render_pass_info.renderArea.extent = { width, height };
+    render_pass_info.renderArea.extent = extent;
 
     std::array<VkClearValue, 1> clear_values;
     clear_values[0].depthStencil = { 1.0f, 0 };
@@ -153,44 +159,85 @@ VkCommandBuffer ShadowPassVK::draw(const Frame& i_frame)
     render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
     render_pass_info.pClearValues = clear_values.data();
 
+    //the subpass is either fully inline or fully secondary, so decide on the entities of every material
+    size_t entity_count = 0;
+    for (const auto& entities : m_entities_to_draw)
+    {
+        entity_count += entities.second.size();
+    }
+
+    const bool use_secondaries = useSecondaryCommandBuffers(entity_count);
+
+    VkCommandBufferInheritanceInfo inheritance_info{};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance_info.renderPass = m_render_pass;
+    inheritance_info.subpass = 0;
+    inheritance_info.framebuffer = m_fbos[i_frame.m_frame_index];
+
     if (vkBeginCommandBuffer(current_cmd, &begin_info) != VK_SUCCESS)
     {
         throw MiniEngineException("failed to begin recording command buffer!");
     }
 
-    UtilsVK::beginRegion(current_cmd, "Shadow Pass", Vector4f(0.0f, 0.5f, 0.0f, 1.0f));
-    vkCmdBeginRenderPass(current_cmd, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    const uint32_t scope = m_runtime.m_profiler->beginRegion(current_cmd, i_frame, "Shadow Pass", Vector4f(0.0f, 0.5f, 0.0f, 1.0f));
+    vkCmdBeginRenderPass(current_cmd, &render_pass_info, use_secondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 
     for (uint32_t mat_id = static_cast<uint32_t>(Material::TMaterial::Diffuse); mat_id < static_cast<uint32_t>(m_pipelines.size()); mat_id++)
     {
-        UtilsVK::beginRegion(current_cmd, mat_id == 0 ? "Diffuse Depth Pass" : mat_id == 1 ? "Dielectric Depth Pass" : "Microfacets Depth Pass", Vector4f(0.0f, 0.5f, 0.5f, 1.0f));
-
-        vkCmdBindPipeline(current_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[mat_id].m_pipeline);
-        vkCmdBindDescriptorSets(current_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelines[mat_id].m_pipeline_layouts, 0, 2, &m_pipelines[mat_id].m_descriptor_sets[renderer.getWindow().getCurrentImageId()].m_per_frame_descriptor, 0, nullptr);
+        const auto& pipeline = m_pipelines[mat_id];
 
-        for (auto entity : m_entities_to_draw[mat_id])
+        for (uint32_t format = 0; format < kVERTEX_FORMAT_COUNT; format++)
         {
-            entity->draw(current_cmd, i_frame);
+            const std::vector<EntityPtr>& entities = m_entities_to_draw[mat_id * kVERTEX_FORMAT_COUNT + format];
+            if (entities.empty())
+            {
+                continue;
+            }
+
+            drawEntities(current_cmd, i_frame, key, mat_id == 0 ? "Diffuse Depth Pass" : mat_id == 1 ? "Dielectric Depth Pass" : "Microfacets Depth Pass", entities, use_secondaries ? &inheritance_info : nullptr,
+                [&](VkCommandBuffer i_cmd)
+                {
+                    vkCmdBindPipeline(i_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.m_pipeline[format]);
+                    setViewportAndScissor(i_cmd, extent);
+                    vkCmdBindDescriptorSets(i_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.m_pipeline_layouts, 0, 2, &pipeline.m_descriptor_sets[i_frame.m_frame_index].m_per_frame_descriptor, 0, nullptr);
+                });
         }
-
-        UtilsVK::endRegion(current_cmd);
     }
 
     vkCmdEndRenderPass(current_cmd);
-    UtilsVK::endRegion(current_cmd);
+    m_runtime.m_profiler->endRegion(current_cmd, i_frame, scope);
 
     if (vkEndCommandBuffer(current_cmd) != VK_SUCCESS)
     {
         throw MiniEngineException("failed to record command buffer!");
     }
 
+    cacheCommandBuffer(key, current_cmd, scope);
+
     return current_cmd;
 }
 
 
+void ShadowPassVK::resize()
+{
+    RendererVK& renderer = *m_runtime.m_renderer;
+
+    //the map may share memory with window sized images, so the graph recreates it with them
+    for (uint32 id = 0; id < static_cast<uint32>(m_fbos.size()); id++)
+    {
+        vkDestroyFramebuffer(renderer.getDevice()->getLogicalDevice(), m_fbos[id], nullptr);
+    }
+
+    createFbo();
+    invalidate();
+}
+
+
 void ShadowPassVK::addEntityToDraw(const EntityPtr i_entity)
 {
-    m_entities_to_draw[static_cast<uint32_t>(i_entity->getMaterial().getType())].push_back(i_entity);
+    const uint32_t key = static_cast<uint32_t>(i_entity->getMaterial().getType()) * kVERTEX_FORMAT_COUNT + static_cast<uint32_t>(i_entity->getMesh().getVertexFormat());
+    m_entities_to_draw[key].push_back(i_entity);
+    invalidate();
 }
 
 
@@ -237,7 +284,8 @@ void ShadowPassVK::createRenderPass()
     attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    //composition samples the map after a render graph barrier, not a final layout
+    attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
     attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkAttachmentReference depth_reference = {};
@@ -257,24 +305,14 @@ void ShadowPassVK::createRenderPass()
     subpass_description.pPreserveAttachments = nullptr;
     subpass_description.pResolveAttachments = nullptr;
 
-    VkSubpassDependency dependency = {};
-
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-    dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
     VkRenderPassCreateInfo render_pass_info = {};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     render_pass_info.attachmentCount = 1;
     render_pass_info.pAttachments = &attachment;
     render_pass_info.subpassCount = 1;
     render_pass_info.pSubpasses = &subpass_description;
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
+    render_pass_info.dependencyCount = 0;
+    render_pass_info.pDependencies = nullptr;
 
     if (vkCreateRenderPass(renderer.getDevice()->getLogicalDevice(), &render_pass_info, nullptr, &m_render_pass) != VK_SUCCESS)
     {
@@ -287,36 +325,6 @@ void ShadowPassVK::createPipelines()
 {
     RendererVK& renderer = *m_runtime.m_renderer;
 
-    VkVertexInputBindingDescription binding_vertex_descrition{};
-    binding_vertex_descrition.binding = 0;
-    binding_vertex_descrition.stride = sizeof(Vertex);
-    binding_vertex_descrition.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-    std::array<VkVertexInputAttributeDescription, 3> attribute_descriptions{};
-
-    attribute_descriptions[0].binding = 0;
-    attribute_descriptions[0].location = 0;
-    attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attribute_descriptions[0].offset = offsetof(Vertex, m_position);
-
-    attribute_descriptions[1].binding = 0;
-    attribute_descriptions[1].location = 1;
-    attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attribute_descriptions[1].offset = offsetof(Vertex, m_normal);
-
-    attribute_descriptions[2].binding = 0;
-    attribute_descriptions[2].location = 2;
-    attribute_descriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-    attribute_descriptions[2].offset = offsetof(Vertex, m_uv);
-
-    VkPipelineVertexInputStateCreateInfo vertex_input_info{};
-    vertex_input_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertex_input_info.vertexBindingDescriptionCount = 1;
-    vertex_input_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
-    vertex_input_info.pVertexBindingDescriptions = &binding_vertex_descrition;
-    vertex_input_info.pVertexAttributeDescriptions = attribute_descriptions.data();
-    vertex_input_info.flags = 0;
-
     VkPipelineInputAssemblyStateCreateInfo input_assembly{};
     input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     input_assembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -379,30 +387,22 @@ void ShadowPassVK::createPipelines()
     multisampling.flags = 0;
 
 
-    uint32 width = 0, height = 0;
-    renderer.getWindow().getWindowSize(width, height);
-    VkExtent2D extend{ width, height };
-
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)width;
-    viewport.height = (float)height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor{};
-    scissor.offset = { 0, 0 };
-    scissor.extent = extend;
-
     VkPipelineViewportStateCreateInfo viewport_state{};
     viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewport_state.viewportCount = 1;
-    viewport_state.pViewports = &viewport;
+    viewport_state.pViewports = nullptr;
     viewport_state.scissorCount = 1;
-    viewport_state.pScissors = &scissor;
+    viewport_state.pScissors = nullptr;
     viewport_state.flags = 0;
 
+    //set when recording, like the other passes
+    std::array<VkDynamicState, 2> dynamic_states = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    VkPipelineDynamicStateCreateInfo dynamic_state{};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+    dynamic_state.pDynamicStates = dynamic_states.data();
+
     //create unfiorms 
     createDescriptorLayout();
 
@@ -417,8 +417,6 @@ void ShadowPassVK::createPipelines()
         pipeline_layout_info.pushConstantRangeCount = 0;
         pipeline_layout_info.flags = 0;
 
-        std::vector<VkGraphicsPipelineCreateInfo> graphic_pipelines;
-
 
         if (vkCreatePipelineLayout(renderer.getDevice()->getLogicalDevice(), &pipeline_layout_info, nullptr, &pipeline.m_pipeline_layouts) != VK_SUCCESS)
         {
@@ -437,18 +435,22 @@ void ShadowPassVK::createPipelines()
         pipeline_info.pMultisampleState = &multisampling;
         pipeline_info.pViewportState = &viewport_state;
         pipeline_info.pDepthStencilState = &depth_stencil;
-        pipeline_info.pDynamicState = VK_NULL_HANDLE;
+        pipeline_info.pDynamicState = &dynamic_state;
         pipeline_info.stageCount = pipeline.m_shader_stages.size();
         pipeline_info.pStages = pipeline.m_shader_stages.data();
         pipeline_info.flags = 0;
-        pipeline_info.pVertexInputState = &vertex_input_info;
         pipeline_info.subpass = 0;
 
-        graphic_pipelines.push_back(pipeline_info);
-
-        if (vkCreateGraphicsPipelines(renderer.getDevice()->getLogicalDevice(), VK_NULL_HANDLE, 1, graphic_pipelines.data(), nullptr, &pipeline.m_pipeline))
+        //same state for every vertex format, only the vertex input changes
+        for (uint32_t format = 0; format < kVERTEX_FORMAT_COUNT; format++)
         {
-            throw MiniEngineException("Error creating the pipeline");
+            VertexLayouts::InputState input_state(static_cast<VertexFormat>(format), m_vertex_stream);
+            pipeline_info.pVertexInputState = &input_state.m_create_info;
+
+            if (vkCreateGraphicsPipelines(renderer.getDevice()->getLogicalDevice(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline.m_pipeline[format]))
+            {
+                throw MiniEngineException("Error creating the pipeline");
+            }
         }
     }
     createDescriptors();
@@ -524,7 +526,7 @@ void ShadowPassVK::createDescriptors()
     //create descriptors for the global buffers
     for (auto& pipeline : m_pipelines)
     {
-        for (uint32_t id = 0; id < m_runtime.m_renderer->getWindow().getImageCount(); id++)
+        for (uint32_t id = 0; id < kMAX_NUMBER_OF_FRAMES; id++)
         {
             VkDescriptorSetAllocateInfo alloc_per_frame_info = {};
             alloc_per_frame_info.pNext = nullptr;
@@ -0,0 +1,508 @@
+#include "vulkan/uploadManagerVK.h"
+#include "vulkan/deviceVK.h"
+#include "vulkan/utilsVK.h"
+
+using namespace MiniEngine;
+
+
+namespace
+{
+    uint64_t alignUp( const uint64_t i_value, const uint64_t i_alignment )
+    {
+        return ( i_value + i_alignment - 1 ) / i_alignment * i_alignment;
+    }
+}
+
+
+UploadManagerVK::UploadManagerVK( const DeviceVK& i_device ) :
+    m_device              ( i_device       ),
+    m_command_pool        ( VK_NULL_HANDLE ),
+    m_acquire_command_pool( VK_NULL_HANDLE ),
+    m_recording           ( 0              ),
+    m_submitted           ( 0              ),
+    m_completed           ( 0              ),
+    m_ring_buffer         ( VK_NULL_HANDLE ),
+    m_ring_alignment      ( 16             ),
+    m_ring_head           ( 0              ),
+    m_ring_tail           ( 0              )
+{
+}
+
+
+void UploadManagerVK::initialize()
+{
+    VkCommandPoolCreateInfo pool_info{};
+    pool_info.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.queueFamilyIndex = m_device.getTransferQueueFamilyIndex();
+    pool_info.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    if( VK_SUCCESS != vkCreateCommandPool( m_device.getLogicalDevice(), &pool_info, nullptr, &m_command_pool ) )
+    {
+        throw MiniEngineException( "Error creating the upload command pool" );
+    }
+
+    std::array<VkCommandBuffer, kUPLOAD_BATCHES> command_buffers;
+
+    VkCommandBufferAllocateInfo alloc_info{};
+    alloc_info.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool        = m_command_pool;
+    alloc_info.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandBufferCount = kUPLOAD_BATCHES;
+
+    if( VK_SUCCESS != vkAllocateCommandBuffers( m_device.getLogicalDevice(), &alloc_info, command_buffers.data() ) )
+    {
+        throw MiniEngineException( "Error allocating the upload command buffers" );
+    }
+
+    for( uint32_t idx = 0; idx < kUPLOAD_BATCHES; idx++ )
+    {
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        if( VK_SUCCESS != vkCreateFence( m_device.getLogicalDevice(), &fence_info, nullptr, &m_batches[ idx ].m_fence ) )
+        {
+            throw MiniEngineException( "Error creating the upload fences" );
+        }
+
+        m_batches[ idx ].m_command_buffer = command_buffers[ idx ];
+    }
+
+    if( m_device.hasDedicatedTransferQueue() )
+    {
+        pool_info.queueFamilyIndex = m_device.getGraphicsQueueFamilyIndex();
+
+        if( VK_SUCCESS != vkCreateCommandPool( m_device.getLogicalDevice(), &pool_info, nullptr, &m_acquire_command_pool ) )
+        {
+            throw MiniEngineException( "Error creating the upload acquire command pool" );
+        }
+
+        alloc_info.commandPool = m_acquire_command_pool;
+
+        if( VK_SUCCESS != vkAllocateCommandBuffers( m_device.getLogicalDevice(), &alloc_info, command_buffers.data() ) )
+        {
+            throw MiniEngineException( "Error allocating the upload acquire command buffers" );
+        }
+
+        for( uint32_t idx = 0; idx < kUPLOAD_BATCHES; idx++ )
+        {
+            VkSemaphoreCreateInfo semaphore_info{};
+            semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+            if( VK_SUCCESS != vkCreateSemaphore( m_device.getLogicalDevice(), &semaphore_info, nullptr, &m_batches[ idx ].m_semaphore ) )
+            {
+                throw MiniEngineException( "Error creating the upload semaphores" );
+            }
+
+            m_batches[ idx ].m_acquire_command_buffer = command_buffers[ idx ];
+        }
+    }
+
+    UtilsVK::createBuffer( m_device, kUPLOAD_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_ring_buffer, m_ring_memory );
+    UtilsVK::setObjectName( m_device.getLogicalDevice(), (uint64_t)m_ring_buffer, VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT, "Upload Ring" );
+
+    //image copies start at multiples of the texel size, 16 covers every power of two format
+    m_ring_alignment = std::max<VkDeviceSize>( 16, m_device.getPhysicalDeviceProperties().limits.optimalBufferCopyOffsetAlignment );
+}
+
+
+void UploadManagerVK::shutdown()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( m_recording )
+    {
+        submit();
+    }
+
+    retire( m_submitted, true );
+
+    UtilsVK::freeBuffer( m_device, m_ring_buffer, m_ring_memory );
+
+    for( auto& batch : m_batches )
+    {
+        vkDestroyFence    ( m_device.getLogicalDevice(), batch.m_fence,     nullptr );
+        vkDestroySemaphore( m_device.getLogicalDevice(), batch.m_semaphore, nullptr );
+        batch = Batch();
+    }
+
+    vkDestroyCommandPool( m_device.getLogicalDevice(), m_command_pool,         nullptr );
+    vkDestroyCommandPool( m_device.getLogicalDevice(), m_acquire_command_pool, nullptr );
+    m_command_pool         = VK_NULL_HANDLE;
+    m_acquire_command_pool = VK_NULL_HANDLE;
+}
+
+
+uint64_t UploadManagerVK::uploadBuffer( VkBuffer i_dst_buffer, const void* i_data, const VkDeviceSize i_size, const VkDeviceSize i_dst_offset )
+{
+    assert( i_data != nullptr && i_size > 0 );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    VkBufferCopy region{};
+    region.dstOffset = i_dst_offset;
+    region.size      = i_size;
+
+    VkBuffer src_buffer = stage( i_data, i_size, region.srcOffset );
+
+    Batch& batch = getRecordingBatch();
+
+    vkCmdCopyBuffer( batch.m_command_buffer, src_buffer, i_dst_buffer, 1, &region );
+
+    if( m_device.hasDedicatedTransferQueue() )
+    {
+        VkBufferMemoryBarrier release{};
+        release.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        release.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        release.srcQueueFamilyIndex = m_device.getTransferQueueFamilyIndex();
+        release.dstQueueFamilyIndex = m_device.getGraphicsQueueFamilyIndex();
+        release.buffer              = i_dst_buffer;
+        release.offset              = i_dst_offset;
+        release.size                = i_size;
+
+        batch.m_buffer_releases.push_back( release );
+    }
+
+    return recordCopy( i_size );
+}
+
+
+uint64_t UploadManagerVK::uploadImage( VkImage i_dst_image, const void* i_data, const VkDeviceSize i_size, const uint32_t i_width, const uint32_t i_height, const VkImageLayout i_final_layout )
+{
+    assert( i_data != nullptr && i_size > 0 );
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel       = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount     = 1;
+    region.imageExtent                     = { i_width, i_height, 1 };
+
+    VkBuffer src_buffer = stage( i_data, i_size, region.bufferOffset );
+
+    Batch&          batch          = getRecordingBatch();
+    VkCommandBuffer command_buffer = batch.m_command_buffer;
+
+    VkImageSubresourceRange subresource_range{};
+    subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    subresource_range.levelCount = VK_REMAINING_MIP_LEVELS;
+    subresource_range.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+    UtilsVK::setImageLayout( command_buffer, i_dst_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresource_range );
+    vkCmdCopyBufferToImage( command_buffer, src_buffer, i_dst_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+
+    if( m_device.hasDedicatedTransferQueue() )
+    {
+        //the layout change to i_final_layout happens as part of the ownership transfer
+        VkImageMemoryBarrier release{};
+        release.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        release.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        release.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        release.newLayout           = i_final_layout;
+        release.srcQueueFamilyIndex = m_device.getTransferQueueFamilyIndex();
+        release.dstQueueFamilyIndex = m_device.getGraphicsQueueFamilyIndex();
+        release.image               = i_dst_image;
+        release.subresourceRange    = subresource_range;
+
+        batch.m_image_releases.push_back( release );
+    }
+    else
+    {
+        UtilsVK::setImageLayout( command_buffer, i_dst_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, i_final_layout, subresource_range );
+    }
+
+    return recordCopy( i_size );
+}
+
+
+uint64_t UploadManagerVK::flush()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( m_recording )
+    {
+        submit();
+    }
+
+    return m_submitted;
+}
+
+
+bool UploadManagerVK::isComplete( const uint64_t i_ticket )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    retire( i_ticket, false );
+    return i_ticket <= m_completed;
+}
+
+
+void UploadManagerVK::wait( const uint64_t i_ticket )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( i_ticket == m_recording )
+    {
+        submit();
+    }
+
+    retire( i_ticket, true );
+}
+
+
+VkBuffer UploadManagerVK::stage( const void* i_data, const VkDeviceSize i_size, VkDeviceSize& o_offset )
+{
+    if( i_size > kUPLOAD_RING_SIZE )
+    {
+        VkBuffer         buffer;
+        MemoryAllocation memory;
+
+        UtilsVK::createBuffer( m_device, i_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer, memory );
+        memcpy( memory.m_mapped, i_data, static_cast<size_t>( i_size ) );
+
+        getRecordingBatch().m_oversized.push_back( { buffer, memory } );
+
+        o_offset = 0;
+        return buffer;
+    }
+
+    //a copy never wraps around the end of the ring
+    uint64_t head = alignUp( m_ring_head, m_ring_alignment );
+    if( head % kUPLOAD_RING_SIZE + i_size > kUPLOAD_RING_SIZE )
+    {
+        head += kUPLOAD_RING_SIZE - head % kUPLOAD_RING_SIZE;
+    }
+
+    //the ring is full of copies the gpu has not done yet, make room starting with the oldest batch
+    while( head + i_size - m_ring_tail > kUPLOAD_RING_SIZE )
+    {
+        if( m_completed < m_submitted )
+        {
+            retire( m_completed + 1, true );
+        }
+        else if( m_recording )
+        {
+            submit();
+        }
+        else
+        {
+            //nothing in flight, the copy simply starts the ring over
+            m_ring_tail = head;
+        }
+    }
+
+    m_ring_head = head + i_size;
+    o_offset    = head % kUPLOAD_RING_SIZE;
+
+    memcpy( static_cast<uint8_t*>( m_ring_memory.m_mapped ) + o_offset, i_data, static_cast<size_t>( i_size ) );
+
+    return m_ring_buffer;
+}
+
+
+UploadManagerVK::Batch& UploadManagerVK::getRecordingBatch()
+{
+    if( m_recording == 0 )
+    {
+        const uint64_t ticket = m_submitted + 1;
+
+        //the slot still belongs to the batch submitted kUPLOAD_BATCHES tickets ago
+        if( ticket > kUPLOAD_BATCHES )
+        {
+            retire( ticket - kUPLOAD_BATCHES, true );
+        }
+
+        Batch& batch  = m_batches[ ticket % kUPLOAD_BATCHES ];
+        batch.m_bytes = 0;
+        batch.m_buffer_releases.clear();
+        batch.m_image_releases.clear();
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if( VK_SUCCESS != vkBeginCommandBuffer( batch.m_command_buffer, &begin_info ) )
+        {
+            throw MiniEngineException( "Error beginning the upload batch %d", ticket );
+        }
+
+        UtilsVK::beginRegion( batch.m_command_buffer, "Uploads", Vector4f( 0.0f, 0.5f, 0.0f, 1.0f ) );
+
+        m_recording = ticket;
+    }
+
+    return m_batches[ m_recording % kUPLOAD_BATCHES ];
+}
+
+
+uint64_t UploadManagerVK::recordCopy( const VkDeviceSize i_size )
+{
+    const uint64_t ticket = m_recording;
+
+    Batch& batch = m_batches[ ticket % kUPLOAD_BATCHES ];
+    batch.m_bytes += i_size;
+
+    if( batch.m_bytes >= kUPLOAD_RING_SIZE / kUPLOAD_BATCHES )
+    {
+        submit();
+    }
+
+    return ticket;
+}
+
+
+void UploadManagerVK::retire( const uint64_t i_ticket, const bool i_wait )
+{
+    while( m_completed < std::min( i_ticket, m_submitted ) )
+    {
+        Batch& batch = m_batches[ ( m_completed + 1 ) % kUPLOAD_BATCHES ];
+
+        if( i_wait )
+        {
+            vkWaitForFences( m_device.getLogicalDevice(), 1, &batch.m_fence, VK_TRUE, UINT64_MAX );
+        }
+        else if( VK_SUCCESS != vkGetFenceStatus( m_device.getLogicalDevice(), batch.m_fence ) )
+        {
+            break;
+        }
+
+        for( auto& staging : batch.m_oversized )
+        {
+            UtilsVK::freeBuffer( m_device, staging.first, staging.second );
+        }
+        batch.m_oversized.clear();
+
+        m_ring_tail = batch.m_ring_end;
+        m_completed++;
+    }
+}
+
+
+void UploadManagerVK::submit()
+{
+    assert( m_recording != 0 );
+
+    Batch& batch = m_batches[ m_recording % kUPLOAD_BATCHES ];
+
+    batch.m_ring_end = m_ring_head;
+
+    if( m_device.hasDedicatedTransferQueue() )
+    {
+        submitWithTransfers( batch );
+
+        m_submitted = m_recording;
+        m_recording = 0;
+        return;
+    }
+
+    //the copies are visible to anything the queue runs after the batch
+    VkMemoryBarrier barrier{};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    vkCmdPipelineBarrier( batch.m_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr );
+
+    UtilsVK::endRegion( batch.m_command_buffer );
+
+    if( VK_SUCCESS != vkEndCommandBuffer( batch.m_command_buffer ) )
+    {
+        throw MiniEngineException( "Error recording the upload batch %d", m_recording );
+    }
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers    = &batch.m_command_buffer;
+
+    vkResetFences( m_device.getLogicalDevice(), 1, &batch.m_fence );
+
+    if( VK_SUCCESS != vkQueueSubmit( m_device.getTransferQueue(), 1, &submit_info, batch.m_fence ) )
+    {
+        throw MiniEngineException( "Error submitting the upload batch %d", m_recording );
+    }
+
+    m_submitted = m_recording;
+    m_recording = 0;
+}
+
+
+void UploadManagerVK::submitWithTransfers( Batch& io_batch )
+{
+    //release on the transfer queue, the destination half of the barriers is ignored there
+    vkCmdPipelineBarrier( io_batch.m_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                          0, nullptr,
+                          static_cast<uint32_t>( io_batch.m_buffer_releases.size() ), io_batch.m_buffer_releases.data(),
+                          static_cast<uint32_t>( io_batch.m_image_releases.size()  ), io_batch.m_image_releases.data() );
+
+    UtilsVK::endRegion( io_batch.m_command_buffer );
+
+    if( VK_SUCCESS != vkEndCommandBuffer( io_batch.m_command_buffer ) )
+    {
+        throw MiniEngineException( "Error recording the upload batch %d", m_recording );
+    }
+
+    VkSubmitInfo transfer_info{};
+    transfer_info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    transfer_info.commandBufferCount   = 1;
+    transfer_info.pCommandBuffers      = &io_batch.m_command_buffer;
+    transfer_info.signalSemaphoreCount = 1;
+    transfer_info.pSignalSemaphores    = &io_batch.m_semaphore;
+
+    if( VK_SUCCESS != vkQueueSubmit( m_device.getTransferQueue(), 1, &transfer_info, VK_NULL_HANDLE ) )
+    {
+        throw MiniEngineException( "Error submitting the upload batch %d", m_recording );
+    }
+
+    //acquire on the graphics queue with the same barriers, now the source half is the ignored one
+    for( auto& barrier : io_batch.m_buffer_releases )
+    {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    }
+
+    for( auto& barrier : io_batch.m_image_releases )
+    {
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    }
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if( VK_SUCCESS != vkBeginCommandBuffer( io_batch.m_acquire_command_buffer, &begin_info ) )
+    {
+        throw MiniEngineException( "Error beginning the acquire of upload batch %d", m_recording );
+    }
+
+    vkCmdPipelineBarrier( io_batch.m_acquire_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                          0, nullptr,
+                          static_cast<uint32_t>( io_batch.m_buffer_releases.size() ), io_batch.m_buffer_releases.data(),
+                          static_cast<uint32_t>( io_batch.m_image_releases.size()  ), io_batch.m_image_releases.data() );
+
+    if( VK_SUCCESS != vkEndCommandBuffer( io_batch.m_acquire_command_buffer ) )
+    {
+        throw MiniEngineException( "Error recording the acquire of upload batch %d", m_recording );
+    }
+
+    const VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    VkSubmitInfo acquire_info{};
+    acquire_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    acquire_info.waitSemaphoreCount = 1;
+    acquire_info.pWaitSemaphores    = &io_batch.m_semaphore;
+    acquire_info.pWaitDstStageMask  = &wait_stage;
+    acquire_info.commandBufferCount = 1;
+    acquire_info.pCommandBuffers    = &io_batch.m_acquire_command_buffer;
+
+    vkResetFences( m_device.getLogicalDevice(), 1, &io_batch.m_fence );
+
+    //the graphics queue is shared with the frame submits, uploads have to come from the thread that renders
+    //or from a point where it does not submit, like scene loading
+    if( VK_SUCCESS != vkQueueSubmit( m_device.getGraphicsQueue(), 1, &acquire_info, io_batch.m_fence ) )
+    {
+        throw MiniEngineException( "Error submitting the acquire of upload batch %d", m_recording );
+    }
+}
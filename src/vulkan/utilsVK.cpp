@@ -1,6 +1,8 @@
 #include "vulkan/utilsVK.h"
 #include "vulkan/deviceVK.h"
 #include "vulkan/rendererVK.h"
+#include "vulkan/memoryAllocatorVK.h"
+#include "vulkan/uploadManagerVK.h"
 #include <fstream>
 #include <iostream>
 #include <vector>
@@ -183,14 +185,23 @@ VkShaderModule UtilsVK::loadShader(const std::string i_fileName, VkDevice i_devi
 }
 
 void UtilsVK::createBuffer(const DeviceVK &i_device, VkDeviceSize i_size, VkBufferUsageFlags i_usage,
-                           VkMemoryPropertyFlags i_properties, VkBuffer &o_buffer, VkDeviceMemory &o_buffer_memory)
+                           VkMemoryPropertyFlags i_properties, VkBuffer &o_buffer, MemoryAllocation &o_buffer_memory, const bool i_compute_shared)
 {
+    const std::array<uint32_t, 2> families = {i_device.getGraphicsQueueFamilyIndex(), i_device.getComputeQueueFamilyIndex()};
+
     VkBufferCreateInfo buffer_info{};
     buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     buffer_info.size = i_size;
     buffer_info.usage = i_usage;
     buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    if (i_compute_shared && i_device.hasAsyncComputeQueue())
+    {
+        buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_info.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+        buffer_info.pQueueFamilyIndices = families.data();
+    }
+
     if (vkCreateBuffer(i_device.getLogicalDevice(), &buffer_info, nullptr, &o_buffer) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create buffer!");
@@ -199,24 +210,26 @@ void UtilsVK::createBuffer(const DeviceVK &i_device, VkDeviceSize i_size, VkBuff
     VkMemoryRequirements mem_requirements;
     vkGetBufferMemoryRequirements(i_device.getLogicalDevice(), o_buffer, &mem_requirements);
 
-    VkMemoryAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = i_device.getMemoryTypeIndex(mem_requirements.memoryTypeBits, i_properties);
-
-    VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo{};
-    memoryAllocateFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-    memoryAllocateFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
-
-    alloc_info.pNext = &memoryAllocateFlagsInfo;
+    // Buffers now share memory blocks, keep device addresses aligned for acceleration structure scratch
+    if (i_usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+    {
+        mem_requirements.alignment = std::max<VkDeviceSize>(mem_requirements.alignment, 256);
+    }
 
+    o_buffer_memory = i_device.getAllocator().allocate(mem_requirements, i_properties, true);
 
-    if (vkAllocateMemory(i_device.getLogicalDevice(), &alloc_info, nullptr, &o_buffer_memory) != VK_SUCCESS)
+    if (vkBindBufferMemory(i_device.getLogicalDevice(), o_buffer, o_buffer_memory.m_memory, o_buffer_memory.m_offset) != VK_SUCCESS)
     {
-        throw std::runtime_error("failed to allocate buffer memory!");
+        throw std::runtime_error("failed to bind buffer memory!");
     }
+}
+
+void UtilsVK::freeBuffer(const DeviceVK &i_device, VkBuffer &io_buffer, MemoryAllocation &io_buffer_memory)
+{
+    vkDestroyBuffer(i_device.getLogicalDevice(), io_buffer, nullptr);
+    i_device.getAllocator().free(io_buffer_memory);
 
-    vkBindBufferMemory(i_device.getLogicalDevice(), o_buffer, o_buffer_memory, 0);
+    io_buffer = VK_NULL_HANDLE;
 }
 
 void UtilsVK::copyBuffer(const DeviceVK &i_device, VkBuffer i_src_buffer, VkBuffer i_dst_buffer, VkDeviceSize i_size)
@@ -378,8 +391,6 @@ void UtilsVK::createImage(const DeviceVK &i_device, VkFormat i_format, VkImageUs
     image.tiling = VK_IMAGE_TILING_OPTIMAL;
     image.usage = i_usage_bits | VK_IMAGE_USAGE_SAMPLED_BIT;
 
-    VkMemoryAllocateInfo mem_alloc{};
-    mem_alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     VkMemoryRequirements mem_reqs;
 
     if (VK_SUCCESS != vkCreateImage(i_device.getLogicalDevice(), &image, nullptr, &o_image_block.m_image))
@@ -388,16 +399,10 @@ void UtilsVK::createImage(const DeviceVK &i_device, VkFormat i_format, VkImageUs
     }
 
     vkGetImageMemoryRequirements(i_device.getLogicalDevice(), o_image_block.m_image, &mem_reqs);
-    mem_alloc.allocationSize = mem_reqs.size;
-    mem_alloc.memoryTypeIndex =
-        i_device.getMemoryTypeIndex(mem_reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    if (VK_SUCCESS != vkAllocateMemory(i_device.getLogicalDevice(), &mem_alloc, nullptr, &o_image_block.m_memory))
-    {
-        throw MiniEngineException("Issue creating an image");
-    }
+    o_image_block.m_memory = i_device.getAllocator().allocate(mem_reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
 
-    if (VK_SUCCESS != vkBindImageMemory(i_device.getLogicalDevice(), o_image_block.m_image, o_image_block.m_memory, 0))
+    if (VK_SUCCESS != vkBindImageMemory(i_device.getLogicalDevice(), o_image_block.m_image, o_image_block.m_memory.m_memory,
+                                        o_image_block.m_memory.m_offset))
     {
         throw MiniEngineException("Issue creating an image");
     }
@@ -456,8 +461,6 @@ void MiniEngine::UtilsVK::createImage(const DeviceVK &i_device, VkFormat i_forma
     image.tiling = VK_IMAGE_TILING_OPTIMAL;
     image.usage = i_usage_bits | VK_IMAGE_USAGE_SAMPLED_BIT;
 
-    VkMemoryAllocateInfo mem_alloc{};
-    mem_alloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     VkMemoryRequirements mem_reqs;
 
     if (VK_SUCCESS != vkCreateImage(i_device.getLogicalDevice(), &image, nullptr, &o_image_block.m_image))
@@ -466,16 +469,10 @@ void MiniEngine::UtilsVK::createImage(const DeviceVK &i_device, VkFormat i_forma
     }
 
     vkGetImageMemoryRequirements(i_device.getLogicalDevice(), o_image_block.m_image, &mem_reqs);
-    mem_alloc.allocationSize = mem_reqs.size;
-    mem_alloc.memoryTypeIndex =
-        i_device.getMemoryTypeIndex(mem_reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    o_image_block.m_memory = i_device.getAllocator().allocate(mem_reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
 
-    if (VK_SUCCESS != vkAllocateMemory(i_device.getLogicalDevice(), &mem_alloc, nullptr, &o_image_block.m_memory))
-    {
-        throw MiniEngineException("Issue creating an image");
-    }
-
-    if (VK_SUCCESS != vkBindImageMemory(i_device.getLogicalDevice(), o_image_block.m_image, o_image_block.m_memory, 0))
+    if (VK_SUCCESS != vkBindImageMemory(i_device.getLogicalDevice(), o_image_block.m_image, o_image_block.m_memory.m_memory,
+                                        o_image_block.m_memory.m_offset))
     {
         throw MiniEngineException("Issue creating an image");
     }
@@ -513,11 +510,10 @@ void UtilsVK::freeImageBlock(const DeviceVK &i_device, ImageBlock &io_free_image
 {
     vkDestroyImageView(i_device.getLogicalDevice(), io_free_image_block.m_image_view, nullptr);
     vkDestroyImage(i_device.getLogicalDevice(), io_free_image_block.m_image, nullptr);
-    vkFreeMemory(i_device.getLogicalDevice(), io_free_image_block.m_memory, nullptr);
+    i_device.getAllocator().free(io_free_image_block.m_memory);
 
     io_free_image_block.m_image_view = VK_NULL_HANDLE;
     io_free_image_block.m_image = VK_NULL_HANDLE;
-    io_free_image_block.m_memory = VK_NULL_HANDLE;
 }
 
 void UtilsVK::TextureFromBuffer(const DeviceVK &device, void *i_buffer, VkDeviceSize i_buffer_size, VkFormat i_format,
@@ -527,67 +523,8 @@ void UtilsVK::TextureFromBuffer(const DeviceVK &device, void *i_buffer, VkDevice
     assert(i_buffer != nullptr);
     uint32_t mip_levels = 1;
 
-    VkMemoryAllocateInfo mem_alloc_info{};
-    mem_alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     VkMemoryRequirements mem_reqs;
 
-    // Use a separate command buffer for texture loading
-    VkCommandBuffer command_buffer = initOneTimeCommandBuffer(device);
-
-    // Create a host-visible staging buffer that contains the raw image data
-    VkBuffer staging_buffer;
-    VkDeviceMemory staging_memory;
-
-    VkBufferCreateInfo buffer_create_info{};
-    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_create_info.size = i_buffer_size;
-
-    // This buffer is used as a transfer source for the buffer copy
-    buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (VK_SUCCESS != vkCreateBuffer(device.getLogicalDevice(), &buffer_create_info, nullptr, &staging_buffer))
-    {
-        throw MiniEngineException("Error Creating Buffer");
-    }
-
-    // Get memory requirements for the staging buffer (alignment, memory type bits)
-    vkGetBufferMemoryRequirements(device.getLogicalDevice(), staging_buffer, &mem_reqs);
-
-    mem_alloc_info.allocationSize = mem_reqs.size;
-    // Get memory type index for a host visible buffer
-    mem_alloc_info.memoryTypeIndex = device.getMemoryTypeIndex(
-        mem_reqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-    if (VK_SUCCESS != vkAllocateMemory(device.getLogicalDevice(), &mem_alloc_info, nullptr, &staging_memory))
-    {
-        throw MiniEngineException("Error Creating Buffer");
-    }
-
-    if (VK_SUCCESS != vkBindBufferMemory(device.getLogicalDevice(), staging_buffer, staging_memory, 0))
-    {
-        throw MiniEngineException("Error Creating Buffer");
-    }
-
-    // Copy texture data into staging buffer
-    uint8_t *data;
-    if (VK_SUCCESS != vkMapMemory(device.getLogicalDevice(), staging_memory, 0, mem_reqs.size, 0, (void **)&data))
-    {
-    }
-
-    memcpy(data, i_buffer, static_cast<size_t>(i_buffer_size));
-    vkUnmapMemory(device.getLogicalDevice(), staging_memory);
-
-    VkBufferImageCopy buffer_copy_region = {};
-    buffer_copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    buffer_copy_region.imageSubresource.mipLevel = 0;
-    buffer_copy_region.imageSubresource.baseArrayLayer = 0;
-    buffer_copy_region.imageSubresource.layerCount = 1;
-    buffer_copy_region.imageExtent.width = i_tex_width;
-    buffer_copy_region.imageExtent.height = i_tex_height;
-    buffer_copy_region.imageExtent.depth = 1;
-    buffer_copy_region.bufferOffset = 0;
-
     // Create optimal tiled target image
     VkImageCreateInfo image_create_info{};
     image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -615,45 +552,17 @@ void UtilsVK::TextureFromBuffer(const DeviceVK &device, void *i_buffer, VkDevice
 
     vkGetImageMemoryRequirements(device.getLogicalDevice(), o_new_image.m_image, &mem_reqs);
 
-    mem_alloc_info.allocationSize = mem_reqs.size;
+    o_new_image.m_memory = device.getAllocator().allocate(mem_reqs, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
 
-    mem_alloc_info.memoryTypeIndex =
-        device.getMemoryTypeIndex(mem_reqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    if (VK_SUCCESS != vkAllocateMemory(device.getLogicalDevice(), &mem_alloc_info, nullptr, &o_new_image.m_memory))
+    if (VK_SUCCESS != vkBindImageMemory(device.getLogicalDevice(), o_new_image.m_image, o_new_image.m_memory.m_memory,
+                                        o_new_image.m_memory.m_offset))
     {
         throw MiniEngineException("Error Creating Buffer");
     }
 
-    if (VK_SUCCESS != vkBindImageMemory(device.getLogicalDevice(), o_new_image.m_image, o_new_image.m_memory, 0))
-    {
-        throw MiniEngineException("Error Creating Buffer");
-    }
-
-    VkImageSubresourceRange subresource_range = {};
-    subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    subresource_range.baseMipLevel = 0;
-    subresource_range.levelCount = mip_levels;
-    subresource_range.layerCount = 1;
-
-    // Image barrier for optimal image (target)
-    // Optimal image will be used as destination for the copy
-    setImageLayout(command_buffer, o_new_image.m_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                   subresource_range);
-
-    // Copy mip levels from staging buffer
-    vkCmdCopyBufferToImage(command_buffer, staging_buffer, o_new_image.m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
-                           &buffer_copy_region);
-
-    // Change texture image layout to shader read after all mip levels have been copied
-    setImageLayout(command_buffer, o_new_image.m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, i_image_layout,
-                   subresource_range);
-
-    endOneTimeCommandBuffer(device, command_buffer);
-
-    // Clean up staging resources
-    vkFreeMemory(device.getLogicalDevice(), staging_memory, nullptr);
-    vkDestroyBuffer(device.getLogicalDevice(), staging_buffer, nullptr);
+    // Staged and batched with the other uploads, later submissions on the queue already see the texels
+    device.getUploadManager().uploadImage(o_new_image.m_image, i_buffer, i_buffer_size, i_tex_width, i_tex_height,
+                                          i_image_layout);
 
     // Create sampler
     VkSamplerCreateInfo sampler_create_info = {};
@@ -733,12 +642,18 @@ void UtilsVK::endOneTimeCommandBuffer(const DeviceVK &device, VkCommandBuffer io
 }
 void MiniEngine::UtilsVK::createBLAS(const DeviceVK&              i_device,
                                      VkBuffer                     i_vertex_buffer,
+                                     const VkDeviceSize           i_vertex_offset,
                                      VkBuffer                     i_index_buffer,
-                                     const std::vector<Vertex>&   m_vertices,
-                                     const std::vector<uint32_t>& i_indices,
+                                     const VkDeviceSize           i_index_offset,
+                                     const VkIndexType            i_index_type,
+                                     const uint32_t               i_vertex_count,
+                                     const uint32_t               i_index_count,
+                                     const VkFormat               i_vertex_format,
+                                     const uint32_t               i_vertex_stride,
+                                     VkBuffer                     i_transform_buffer,
                                      VkAccelerationStructureKHR&  o_blas,
                                      VkBuffer&                    o_buffer,
-                                     VkDeviceMemory&              o_memory ) {
+                                     MemoryAllocation&            o_memory ) {
 
 
     // GEOMETRY INFO -----------------------------------------------------------
@@ -749,28 +664,34 @@ void MiniEngine::UtilsVK::createBLAS(const DeviceVK&              i_device,
     VkAccelerationStructureGeometryKHR accelerationStructureGeometry{};
     accelerationStructureGeometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
 
-    vertexBufferDeviceAddress.deviceAddress = get_device_address(i_device.getLogicalDevice(), i_vertex_buffer);
-    if (!i_indices.empty())
-        indexBufferDeviceAddress.deviceAddress = get_device_address(i_device.getLogicalDevice(), i_index_buffer);
+    //the buffers may hold other geometry too, the offsets are where this one starts
+    vertexBufferDeviceAddress.deviceAddress = get_device_address(i_device.getLogicalDevice(), i_vertex_buffer) + i_vertex_offset;
+    if (i_index_count > 0)
+        indexBufferDeviceAddress.deviceAddress = get_device_address(i_device.getLogicalDevice(), i_index_buffer) + i_index_offset;
 
     accelerationStructureGeometry.flags        = VK_GEOMETRY_OPAQUE_BIT_KHR;
     accelerationStructureGeometry.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
     accelerationStructureGeometry.geometry.triangles.sType =
         VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
-    accelerationStructureGeometry.geometry.triangles.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
+    accelerationStructureGeometry.geometry.triangles.vertexFormat = i_vertex_format;
     accelerationStructureGeometry.geometry.triangles.vertexData   = vertexBufferDeviceAddress;
-    accelerationStructureGeometry.geometry.triangles.maxVertex    = (uint32_t)m_vertices.size() - 1;
-    accelerationStructureGeometry.geometry.triangles.vertexStride = sizeof(Vertex);
+    accelerationStructureGeometry.geometry.triangles.maxVertex    = i_vertex_count - 1;
+    accelerationStructureGeometry.geometry.triangles.vertexStride = i_vertex_stride;
 
-    if (!i_indices.empty())
+    if (i_index_count > 0)
     {
-        accelerationStructureGeometry.geometry.triangles.indexType = VK_INDEX_TYPE_UINT32;
+        accelerationStructureGeometry.geometry.triangles.indexType = i_index_type;
         accelerationStructureGeometry.geometry.triangles.indexData = indexBufferDeviceAddress;
     }
     
     accelerationStructureGeometry.geometry.triangles.transformData.deviceAddress = 0;
     accelerationStructureGeometry.geometry.triangles.transformData.hostAddress   = nullptr;
 
+    if (i_transform_buffer != VK_NULL_HANDLE)
+    {
+        accelerationStructureGeometry.geometry.triangles.transformData.deviceAddress = get_device_address(i_device.getLogicalDevice(), i_transform_buffer);
+    }
+
     // ACCELERATION STRUCTURE INFO -----------------------------------------------------------
 
     VkAccelerationStructureBuildGeometryInfoKHR accelerationStructureBuildGeometryInfo{};
@@ -783,7 +704,7 @@ void MiniEngine::UtilsVK::createBLAS(const DeviceVK&              i_device,
     VkAccelerationStructureBuildSizesInfoKHR accelerationStructureBuildSizesInfo{};
     accelerationStructureBuildSizesInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
 
-    const uint32_t numPrimitives = (uint32_t)i_indices.size() / 3;
+    const uint32_t numPrimitives = i_index_count / 3;
     vkGetAccelerationStructureBuildSizes(i_device.getLogicalDevice(),
                                          VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
                                          &accelerationStructureBuildGeometryInfo,
@@ -813,10 +734,10 @@ void MiniEngine::UtilsVK::createBLAS(const DeviceVK&              i_device,
     }
 
     // Create a small scratch buffer used during build of the bottom level acceleration structure
-    VkBuffer       staging_buffer;
-    VkDeviceMemory staging_memory;
+    VkBuffer         staging_buffer;
+    MemoryAllocation staging_memory;
     UtilsVK::createBuffer(i_device,
-                          accelerationStructureBuildSizesInfo.accelerationStructureSize,
+                          accelerationStructureBuildSizesInfo.buildScratchSize,
                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                           staging_buffer,
@@ -850,8 +771,7 @@ void MiniEngine::UtilsVK::createBLAS(const DeviceVK&              i_device,
 
 
     //Destroy temp scratch buffer
-    vkDestroyBuffer(i_device.getLogicalDevice(), staging_buffer, nullptr);
-    vkFreeMemory(i_device.getLogicalDevice(), staging_memory, nullptr);
+    freeBuffer(i_device, staging_buffer, staging_memory);
 }
 
 void MiniEngine::UtilsVK::createTLAS(const DeviceVK&                          i_device,
@@ -859,7 +779,7 @@ void MiniEngine::UtilsVK::createTLAS(const DeviceVK&                          i_
                                      std::vector<VkAccelerationStructureKHR>& i_blas_instances,
                                      VkAccelerationStructureKHR&              o_tlas,
                                      VkBuffer&                                o_buffer,
-                                     VkDeviceMemory&                          o_memory) {
+                                     MemoryAllocation&                        o_memory) {
 
     // SUBSCRIBING BLAS INSTANCES -----------------------------------------------------------
 
@@ -887,9 +807,9 @@ void MiniEngine::UtilsVK::createTLAS(const DeviceVK&                          i_
     }
 
     // Create a buffer for the instances -----------------------------------------------------------
-    VkBuffer       instances_buffer;
-    VkDeviceMemory instances_memory;
-    VkDeviceSize   instancesBufferSize = sizeof(VkAccelerationStructureInstanceKHR) * instances.size();
+    VkBuffer         instances_buffer;
+    MemoryAllocation instances_memory;
+    VkDeviceSize     instancesBufferSize = sizeof(VkAccelerationStructureInstanceKHR) * instances.size();
     UtilsVK::createBuffer(i_device,
                           instancesBufferSize,
                           VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
@@ -899,10 +819,7 @@ void MiniEngine::UtilsVK::createTLAS(const DeviceVK&                          i_
                           instances_memory);
 
     // Upload data to the buffer -----------------------------------------------------------
-    void* data;
-    vkMapMemory(i_device.getLogicalDevice(), instances_memory, 0, instancesBufferSize, 0, &data);
-    memcpy(data, instances.data(), instancesBufferSize);
-    vkUnmapMemory(i_device.getLogicalDevice(), instances_memory);
+    memcpy(instances_memory.m_mapped, instances.data(), instancesBufferSize);
 
     // GEOMETRY INFO -----------------------------------------------------------
 
@@ -959,8 +876,8 @@ void MiniEngine::UtilsVK::createTLAS(const DeviceVK&                          i_
     };
 
     // Create a small scratch buffer used during build of the top level acceleration structure
-    VkBuffer       staging_buffer;
-    VkDeviceMemory staging_memory;
+    VkBuffer         staging_buffer;
+    MemoryAllocation staging_memory;
     UtilsVK::createBuffer(i_device,
                           accelerationStructureBuildSizesInfo.buildScratchSize,
                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
@@ -997,11 +914,9 @@ void MiniEngine::UtilsVK::createTLAS(const DeviceVK&                          i_
     endOneTimeCommandBuffer(i_device, command_buffer);
 
     // Destroy temp instances buffer
-    vkDestroyBuffer(i_device.getLogicalDevice(), instances_buffer, nullptr);
-    vkFreeMemory(i_device.getLogicalDevice(), instances_memory, nullptr);
+    freeBuffer(i_device, instances_buffer, instances_memory);
     // Destroy temp scratch buffer
-    vkDestroyBuffer(i_device.getLogicalDevice(), staging_buffer, nullptr);
-    vkFreeMemory(i_device.getLogicalDevice(), staging_memory, nullptr);
+    freeBuffer(i_device, staging_buffer, staging_memory);
 }
 
 
@@ -2,12 +2,13 @@
 #include "vulkan/windowVK.h"
 #include "vulkan/rendererVK.h"
 #include "vulkan/deviceVK.h"
+#include "vulkan/utilsVK.h"
 #include "common.h"
 
 using namespace MiniEngine;
 
 
-WindowVK::WindowVK( const RendererVK& i_renderer, const std::string& i_name, const uint32_t i_width, const uint32_t i_height ) :
+WindowVK::WindowVK( const RendererVK& i_renderer, const std::string& i_name, const uint32_t i_width, const uint32_t i_height, const bool i_headless ) :
     m_renderer           ( i_renderer                        ),
     m_name               ( i_name                            ),
     m_width              ( i_width                           ),
@@ -17,12 +18,18 @@ WindowVK::WindowVK( const RendererVK& i_renderer, const std::string& i_name, con
     m_depth_format       ( VK_FORMAT_D32_SFLOAT_S8_UINT      ),
     m_color_space        ( VK_COLOR_SPACE_SRGB_NONLINEAR_KHR ),
     m_fullscreen         ( false                             ),
+    m_headless           ( i_headless                        ),
     m_prepared           ( false                             ),              
     m_surface            ( VK_NULL_HANDLE                    ),
     m_swap_chain         ( VK_NULL_HANDLE                    ),
     m_image_index        ( 0                                 ),
     m_image_count        ( 0                                 )
 {
+    if( m_headless )
+    {
+        return;
+    }
+
     glfwInit();
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -35,6 +42,13 @@ WindowVK::WindowVK( const RendererVK& i_renderer, const std::string& i_name, con
 
 uint32 WindowVK::prepareFrame( VkSemaphore i_presentation_semaphore )
 {
+    if( m_headless )
+    {
+        //the caller already waited on the fence of the frame slot, and the ring is at least as deep as the frames in flight
+        m_image_index = ( m_image_index + 1 ) % m_image_count;
+        return VK_SUCCESS;
+    }
+
     // Acquire the next image from the swap chain
     VkResult result = vkAcquireNextImageKHR( m_renderer.getDevice()->getLogicalDevice(), m_swap_chain, UINT64_MAX, i_presentation_semaphore, ( VkFence )nullptr, &m_image_index );
 
@@ -44,12 +58,23 @@ uint32 WindowVK::prepareFrame( VkSemaphore i_presentation_semaphore )
 
 uint32 WindowVK::renderFrame( VkSemaphore i_presentation_semaphore )
 {
+    if( m_headless )
+    {
+        return VK_SUCCESS;
+    }
+
     return queuePresent( i_presentation_semaphore );
 }
 
 
 void WindowVK::createSwapChain()
 {
+    if( m_headless )
+    {
+        createOffscreenImages();
+        return;
+    }
+
     // Store the current swap chain handle so we can use it later on to ease up recreation
     VkSwapchainKHR old_swap_chain = m_swap_chain;
 
@@ -211,6 +236,7 @@ void WindowVK::createSwapChain()
 
 
     // Get the swap chain buffers containing the image and imageview
+    m_swap_chain_images.resize( m_image_count );
     for( uint32_t i = 0; i < m_image_count; i++ )
     {
         VkImageViewCreateInfo colorAttachmentView = {};
@@ -264,6 +290,12 @@ VkResult WindowVK::queuePresent( VkSemaphore i_presentation_semaphore )
 
 void WindowVK::createSurface()
 {   
+    if( m_headless )
+    {
+        return;
+    }
+
+
     if( glfwCreateWindowSurface( m_renderer.getInstance(), m_window, nullptr, &m_surface ) )
     if( glfwCreateWindowSurface( m_renderer.getInstance(), m_window, nullptr, &m_surface ) )
     {
@@ -275,6 +307,11 @@ void WindowVK::createSurface()
 
 bool WindowVK::loop()
 {
+    if( m_headless )
+    {
+        return true;
+    }
+
     glfwPollEvents();
     return !glfwWindowShouldClose( m_window );
 }
@@ -282,6 +319,11 @@ bool WindowVK::loop()
 
 void WindowVK::wait() 
 {
+    if( m_headless )
+    {
+        return;
+    }
+
     //wait till minimize finishes
     int32 height = 0, width = 0;
     while( width == 0 || height == 0 ) 
@@ -294,6 +336,11 @@ void WindowVK::wait()
 
 void WindowVK::resize()
 {
+    if( m_headless )
+    {
+        return;
+    }
+
     for( uint32_t idx = 0; idx < m_image_count; idx++ )
     {
         vkDestroyImageView( m_renderer.getDevice()->getLogicalDevice(), m_swap_chain_images [ idx ].m_image_view , nullptr );
@@ -310,12 +357,29 @@ void WindowVK::resize()
 
 void WindowVK::resize( const uint32_t i_width, const uint32_t i_height )
 {
+    if( m_headless )
+    {
+        vkDeviceWaitIdle( m_renderer.getDevice()->getLogicalDevice() );
+
+        destroyOffscreenImages();
+        m_width  = i_width;
+        m_height = i_height;
+        createOffscreenImages ();
+        return;
+    }
+
     glfwSetWindowSize( m_window, i_width, i_height );    
 }
 
 
 void WindowVK::destroySwapChain()
 {
+    if( m_headless )
+    {
+        destroyOffscreenImages();
+        return;
+    }
+
     for( uint32_t idx = 0; idx < m_image_count; idx++ )
     {
         vkDestroyImageView( m_renderer.getDevice()->getLogicalDevice(), m_swap_chain_images[ idx ].m_image_view, nullptr );
@@ -328,5 +392,37 @@ void WindowVK::destroySwapChain()
 
 void WindowVK::destroySurface()
 {
+    if( m_headless )
+    {
+        return;
+    }
+
     vkDestroySurfaceKHR( m_renderer.getInstance(), m_surface, nullptr );
-}
\ No newline at end of file
+}
+
+
+void WindowVK::createOffscreenImages()
+{
+    //one image per frame in flight so a frame never overwrites an image the gpu may still be writing
+    m_image_count = kMAX_NUMBER_OF_FRAMES;
+    m_image_index = m_image_count - 1;
+    m_swap_chain_images.resize( m_image_count );
+
+    for( uint32_t i = 0; i < m_image_count; i++ )
+    {
+        UtilsVK::createImage( *m_renderer.getDevice(), m_color_format, static_cast<VkImageUsageFlagBits>( VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT ), m_width, m_height, m_swap_chain_images[ i ] );
+        UtilsVK::setObjectName( m_renderer.getDevice()->getLogicalDevice(), (uint64_t)( m_swap_chain_images[ i ].m_image ), VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, "Image Offscreen Output" );
+    }
+}
+
+
+void WindowVK::destroyOffscreenImages()
+{
+    for( auto& image : m_swap_chain_images )
+    {
+        UtilsVK::freeImageBlock( *m_renderer.getDevice(), image );
+    }
+
+    m_swap_chain_images.clear();
+    m_image_count = 0;
+}